@@ -0,0 +1,184 @@
+#include "pch.h"
+#include "AllocTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+// Visual C++ before 2015 has no thread_local, but the same for plain data
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define ALLOC_THREAD_LOCAL __declspec(thread)
+#else
+#define ALLOC_THREAD_LOCAL thread_local
+#endif
+
+namespace
+{
+	struct AtomicCounters
+	{
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> bytes;
+		std::atomic<uint64_t> frees;
+	};
+
+	// Plain globals without constructors: they are zero before the first static
+	// constructor allocates anything. Every thread has its own current tag, the
+	// allocations of the logger thread stay untagged.
+	std::atomic<bool> enabled;
+	ALLOC_THREAD_LOCAL size_t currentTag;
+
+	// tags are only added under tagMutex, numTags is raised after the name is set
+	std::mutex tagMutex;
+	const char* tagNames[AllocTracker::MAX_TAGS];
+	std::atomic<size_t> numTags;
+
+	AtomicCounters current[AllocTracker::MAX_TAGS];
+	AllocTracker::Counters lastFrame[AllocTracker::MAX_TAGS];
+}
+
+/*static*/ bool AllocTracker::IsEnabled()
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+/*static*/ void AllocTracker::SetEnabled(bool e)
+{
+	enabled.store(e, std::memory_order_relaxed);
+}
+
+/*static*/ size_t AllocTracker::GetTagId(const char* name)
+{
+	std::lock_guard<std::mutex> lock(tagMutex);
+
+	size_t n = numTags.load(std::memory_order_relaxed);
+	if (n == 0) {
+		tagNames[0] = "untagged";
+		numTags.store(++n, std::memory_order_release);
+	}
+
+	for (size_t i=0; i < n; ++i) {
+		if (std::strcmp(tagNames[i], name) == 0)
+			return i;
+	}
+
+	if (n == MAX_TAGS)
+		return UNTAGGED;
+
+	tagNames[n] = name;
+	numTags.store(n + 1, std::memory_order_release);
+	return n;
+}
+
+/*static*/ size_t AllocTracker::GetNumTags()
+{
+	return std::max<size_t>(numTags.load(std::memory_order_acquire), 1);
+}
+
+/*static*/ const char* AllocTracker::GetTagName(size_t tag)
+{
+	return tag < numTags.load(std::memory_order_acquire) ? tagNames[tag] : "untagged";
+}
+
+/*static*/ size_t AllocTracker::GetCurrentTag()
+{
+	return currentTag;
+}
+
+/*static*/ void AllocTracker::SetCurrentTag(size_t tag)
+{
+	currentTag = tag;
+}
+
+/*static*/ void AllocTracker::EndFrame()
+{
+	for (size_t i=0; i < MAX_TAGS; ++i) {
+		lastFrame[i].allocations = current[i].allocations.exchange(0, std::memory_order_relaxed);
+		lastFrame[i].bytes = current[i].bytes.exchange(0, std::memory_order_relaxed);
+		lastFrame[i].frees = current[i].frees.exchange(0, std::memory_order_relaxed);
+	}
+}
+
+/*static*/ AllocTracker::Counters AllocTracker::GetFrame(size_t tag)
+{
+	return lastFrame[tag];
+}
+
+/*static*/ AllocTracker::Counters AllocTracker::GetFrameTotal()
+{
+	Counters total;
+	for (size_t i=0; i < MAX_TAGS; ++i)
+		total += lastFrame[i];
+	return total;
+}
+
+/*static*/ void AllocTracker::RecordAllocation(size_t size)
+{
+	if (!enabled.load(std::memory_order_relaxed))
+		return;
+
+	AtomicCounters& c = current[currentTag];
+	c.allocations.fetch_add(1, std::memory_order_relaxed);
+	c.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+/*static*/ void AllocTracker::RecordFree()
+{
+	if (!enabled.load(std::memory_order_relaxed))
+		return;
+
+	current[currentTag].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Replacements of the global allocation functions, all other forms use these
+
+void* operator new(std::size_t size)
+{
+	AllocTracker::RecordAllocation(size);
+
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+	AllocTracker::RecordAllocation(size);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& nt) throw()
+{
+	return operator new(size, nt);
+}
+
+void operator delete(void* p) throw()
+{
+	if (!p)
+		return;
+
+	AllocTracker::RecordFree();
+	std::free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+	operator delete(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+	operator delete(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+	operator delete(p);
+}
@@ -0,0 +1,92 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <cstdint>
+
+// Counts the calls of the global operator new and delete while enabled. Every
+// allocation is booked on the tag of the current scope (see ALLOC_TAG), so the
+// allocations of a frame can be broken down by subsystem. The counters are atomic
+// and every thread has its own current tag, so allocations of other threads like the
+// logger are booked as untagged. While disabled, new and delete only check a flag
+// before calling malloc and free.
+class AllocTracker
+{
+public:
+	static const size_t MAX_TAGS = 32;
+	static const size_t UNTAGGED = 0;
+
+	struct Counters
+	{
+		uint64_t allocations;
+		uint64_t bytes;
+		uint64_t frees;
+
+		Counters()
+		: allocations(0), bytes(0), frees(0)
+		{ }
+
+		Counters& operator+=(const Counters& other)
+		{
+			allocations += other.allocations;
+			bytes += other.bytes;
+			frees += other.frees;
+			return *this;
+		}
+	};
+
+	static bool IsEnabled();
+	static void SetEnabled(bool e);
+
+	// Get the id of the tag with the given name, registering it if necessary. Tags
+	// beyond MAX_TAGS are booked as untagged. Safe to call from any thread.
+	static size_t GetTagId(const char* name);
+	static size_t GetNumTags();
+	static const char* GetTagName(size_t tag);
+
+	// Tag of the calling thread
+	static size_t GetCurrentTag();
+	static void SetCurrentTag(size_t tag);
+
+	// Finish the current frame, its counters are kept until the next call
+	static void EndFrame();
+
+	// Counters of the last finished frame
+	static Counters GetFrame(size_t tag);
+	static Counters GetFrameTotal();
+
+	// Called by the global operator new and delete
+	static void RecordAllocation(size_t size);
+	static void RecordFree();
+};
+
+// Books all allocations until the end of the scope on the given tag, use ALLOC_TAG instead of using it directly
+class AllocScope
+{
+	size_t previous;
+
+public:
+	explicit AllocScope(size_t tag)
+	: previous(AllocTracker::GetCurrentTag())
+	{
+		AllocTracker::SetCurrentTag(tag);
+	}
+
+	~AllocScope()
+	{
+		AllocTracker::SetCurrentTag(previous);
+	}
+
+private:
+	AllocScope(const AllocScope&) /*= delete*/;
+	AllocScope& operator=(const AllocScope&) /*= delete*/;
+};
+
+#define ALLOC_CONCAT_(a_, b_) a_##b_
+#define ALLOC_CONCAT(a_, b_) ALLOC_CONCAT_(a_, b_)
+
+// Book the allocations of the rest of the current scope on the tag with the given name (a string literal)
+#define ALLOC_TAG(name_) \
+	static const size_t ALLOC_CONCAT(allocTag_, __LINE__) = AllocTracker::GetTagId(name_); \
+	AllocScope ALLOC_CONCAT(allocScope_, __LINE__)(ALLOC_CONCAT(allocTag_, __LINE__))
+
+#endif //ALLOC_TRACKER_H
@@ -7,8 +7,6 @@ AnimSprite::AnimSprite()
 
 void AnimSprite::Update(float elapsed)
 {
-	size_t frame = 0;
-
 	if (frameTime == 0)
 		return;
 
@@ -17,7 +15,18 @@ void AnimSprite::Update(float elapsed)
 		curTime -= frames * frameTime;
 	}
 
-	frame = static_cast<size_t>(curTime / frameTime);
+	UpdateSubRect();
+}
+
+void AnimSprite::SetTime(float time)
+{
+	curTime = frameTime > 0 ? std::fmod(time, frames * frameTime) : 0;
+	UpdateSubRect();
+}
+
+void AnimSprite::UpdateSubRect()
+{
+	size_t frame = frameTime > 0 ? std::min(static_cast<size_t>(curTime / frameTime), frames - 1) : 0;
 
 	size_t xoffs = frame * width + (frame + 1) * offset;
 	size_t yoffs = static_cast<int>(direction) * height + (static_cast<int>(direction) + 1) * offset;
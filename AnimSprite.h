@@ -51,6 +51,10 @@ public:
 
 	void Update(float elapsed);
 
+	// Show the animation at the given time since its start, instead of advancing it. Also
+	// picks the frame for the current direction, so one sprite can draw many objects.
+	void SetTime(float time);
+
 	size_t GetWidth() const
 	{
 		return width;
@@ -65,6 +69,17 @@ public:
 	{
 		direction = dir;
 	}
+
+	// The direction to show while moving along d
+	static Direction GetDirection(const Vector2f& d)
+	{
+		if (std::abs(d.x) > std::abs(d.y))
+			return d.x > 0 ? Right : Left;
+		return d.y > 0 ? Down : Up;
+	}
+
+private:
+	void UpdateSubRect();
 };
 
 #endif //ANIM_SPRITE_H
@@ -0,0 +1,446 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "Simulation.h"
+#include "FireEffect.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "AllocTracker.h"
+#include "ResourceManager.h"
+#include "Theme.h"
+#include "TowerSettings.h"
+#include "Error.h"
+
+#include <iomanip>
+
+namespace js = json_spirit;
+
+// Towers are only placed this many blocks away from the path, so they have something to shoot at
+static const int TOWER_PATH_DISTANCE = 4;
+
+static const size_t PLENTY = 1000000000;
+
+std::vector<Scenario> GetDefaultScenarios()
+{
+	std::vector<Scenario> scenarios;
+
+	const size_t numEnemies[] = { 100, 1000, 10000 };
+	const char* names[] = { "enemies-100", "enemies-1k", "enemies-10k" };
+	for (size_t i=0; i < 3; ++i) {
+		Scenario sc;
+		sc.name = names[i];
+		sc.enemies = numEnemies[i];
+		sc.towersPerType = 50;
+		scenarios.push_back(sc);
+	}
+
+	Scenario canon;
+	canon.name = "canon-splash";
+	canon.enemies = 2000;
+	canon.towersPerType = 150;
+	canon.towerType = "canon";
+	canon.maxStage = true;
+	scenarios.push_back(canon);
+
+	Scenario fire;
+	fire.name = "fire-places";
+	fire.firePlaces = 100;
+	fire.warmupTicks = 0;
+	scenarios.push_back(fire);
+
+	return scenarios;
+}
+
+// Get count free places next to the path, spread evenly over the map
+static std::vector<Vector2f> FindPlaces(const Map& map, size_t count)
+{
+	std::vector<Vector2f> places;
+	if (count == 0)
+		return places;
+
+	const int width  = static_cast<int>(map.GetWidthBlocks());
+	const int height = static_cast<int>(map.GetHeightBlocks());
+	const NavGrid& grid = map.GetPathGrid();
+
+	auto isPath = [&](int x, int y) {
+		return grid.Contains(Vector2i(x, y)) && grid.IsWalkable(x, y);
+	};
+
+	std::vector<Vector2f> candidates;
+	for (int y=0; y < height; ++y) {
+		for (int x=0; x < width; ++x) {
+			if (isPath(x, y))
+				continue;
+
+			bool nearPath = false;
+			for (int dy=-TOWER_PATH_DISTANCE; dy <= TOWER_PATH_DISTANCE && !nearPath; ++dy) {
+				for (int dx=-TOWER_PATH_DISTANCE; dx <= TOWER_PATH_DISTANCE && !nearPath; ++dx)
+					nearPath = isPath(x + dx, y + dy);
+			}
+			if (nearPath)
+				candidates.push_back(map.BlockToPosition(Vector2i(x, y)));
+		}
+	}
+
+	if (candidates.size() < count)
+		throw GameError() << ErrorInfo::Desc("Not enough free places on the map") << ErrorInfo::Note(boost::lexical_cast<std::string>(count));
+
+	for (size_t i=0; i < count; ++i)
+		places.push_back(candidates[i * candidates.size() / count]);
+	return places;
+}
+
+static void PlaceTowers(Simulation& simulation, const Scenario& sc)
+{
+	std::vector<const TowerSettings*> types;
+	for (size_t i=0; i < gTheme.GetNumTowerSettings(); ++i) {
+		const TowerSettings* settings = gTheme.GetTowerSettings(i);
+		if (sc.towerType.empty() || settings->type == sc.towerType)
+			types.push_back(settings);
+	}
+	if (types.empty())
+		throw GameError() << ErrorInfo::Desc("Unknown tower type") << ErrorInfo::Note(sc.towerType);
+
+	// alternate the types, so every type is spread over the whole map
+	auto places = FindPlaces(simulation.GetMap(), sc.towersPerType * types.size());
+	for (size_t i=0; i < places.size(); ++i) {
+		simulation.GetMap().AddTowerPlace(places[i]);
+		simulation.AddTower(types[i % types.size()], places[i]);
+	}
+
+	if (sc.maxStage) {
+		const TowerStore& towers = simulation.GetTowers();
+		for (size_t i=0; i < towers.GetSize(); ++i) {
+			while (towers.Get(i).CanUpgrade())
+				simulation.UpgradeTower(towers.Get(i).GetPosition());
+		}
+	}
+}
+
+static std::vector<std::unique_ptr<FireEffect>> CreateFires(const Simulation& simulation, const Scenario& sc, RenderWindow& window)
+{
+	std::vector<std::unique_ptr<FireEffect>> fires;
+	for (auto& pos: FindPlaces(simulation.GetMap(), sc.firePlaces)) {
+		std::unique_ptr<FireEffect> fire(new FireEffect(static_cast<float>(window.GetWidth()), static_cast<float>(window.GetHeight())));
+		fire->SetFireTexture(&gImageManager.getResource("data/effects/fire.png"));
+		fire->SetNoiseTexture(&gImageManager.getResource("data/effects/noise.png"));
+		fire->SetAlphaTexture(&gImageManager.getResource("data/effects/alpha.png"));
+
+		fire->SetWidth(25);
+		fire->SetHeight(25);
+		fire->SetPosition(pos - Vector2f(12.5, 22));
+
+		fires.emplace_back(std::move(fire));
+	}
+	return fires;
+}
+
+ScenarioResult RunScenario(const Scenario& sc, RenderWindow* window)
+{
+	if (sc.NeedsWindow() && !window)
+		throw GameError() << ErrorInfo::Desc("Scenario needs a window") << ErrorInfo::Note(sc.name);
+
+	// nothing should end the scenario early
+	gStatus.Reset();
+	gStatus.startLives = PLENTY;
+	gStatus.startMoney = PLENTY;
+
+	Simulation simulation(gStatus);
+	simulation.Reset(sc.level, 0);
+
+	PlaceTowers(simulation, sc);
+
+	std::vector<std::unique_ptr<FireEffect>> fires;
+	if (sc.firePlaces)
+		fires = CreateFires(simulation, sc, *window);
+
+	size_t spawned = 0;
+	auto spawnEnemies = [&](size_t count) {
+		const Map& map = simulation.GetMap();
+		for (size_t i=0; i < count; ++i, ++spawned)
+			simulation.SpawnEnemy(spawned % simulation.GetNumEnemyTypes(), spawned % map.GetNumSpawns());
+	};
+
+	auto tick = [&]() {
+		simulation.Update(SIM_TICK);
+
+		if (!fires.empty()) {
+			{
+				PROFILE_ZONE("FireEffect::Update");
+				for (auto& fire: fires)
+					fire->Update(SIM_TICK);
+			}
+			{
+				PROFILE_ZONE("FireEffect::Draw");
+				RenderCategory category(RenderStats::Effects);
+				window->Clear();
+				for (auto& fire: fires)
+					RenderStats::Draw(*window, *fire);
+				window->Display();
+			}
+		}
+	};
+
+	// spread the spawns over the warmup, so the enemies are spread over the path
+	for (size_t i=0; i < sc.warmupTicks; ++i) {
+		size_t target = sc.enemies * (i + 1) / sc.warmupTicks;
+		spawnEnemies(target - std::min(target, simulation.GetNumEnemies()));
+		tick();
+	}
+
+	Profiler& profiler = Profiler::Instance();
+	profiler.ResetStats();
+	profiler.SetEnabled(true);
+
+	RenderStats& renderStats = RenderStats::Instance();
+	renderStats.SetEnabled(true);
+	std::array<RenderStats::Counters, RenderStats::NUM_CATEGORIES> renderTotal;
+
+	AllocTracker::SetEnabled(true);
+	AllocTracker::EndFrame();
+	std::array<AllocTracker::Counters, AllocTracker::MAX_TAGS> allocTotal;
+
+	ScenarioResult result;
+	result.name = sc.name;
+	result.ticks = sc.ticks;
+	result.towers = simulation.GetTowers().GetSize();
+	result.avgEnemies = 0;
+	result.avgProjectiles = 0;
+
+	// only the ticks themselves count, not the spawns to keep the number of enemies up
+	uint64_t elapsed = 0;
+	for (size_t i=0; i < sc.ticks; ++i) {
+		spawnEnemies(sc.enemies - std::min(sc.enemies, simulation.GetNumEnemies()));
+
+		result.avgEnemies += simulation.GetNumEnemies();
+		result.avgProjectiles += simulation.GetNumProjectiles();
+
+		uint64_t start = Profiler::GetTime();
+		tick();
+		elapsed += Profiler::GetTime() - start;
+
+		renderStats.EndFrame();
+		for (size_t c=0; c < RenderStats::NUM_CATEGORIES; ++c)
+			renderTotal[c] += renderStats.GetFrame(static_cast<RenderStats::Category>(c));
+
+		AllocTracker::EndFrame();
+		for (size_t t=0; t < AllocTracker::MAX_TAGS; ++t)
+			allocTotal[t] += AllocTracker::GetFrame(t);
+	}
+
+	profiler.SetEnabled(false);
+	renderStats.SetEnabled(false);
+	AllocTracker::SetEnabled(false);
+
+	const double ticks = static_cast<double>(std::max<size_t>(sc.ticks, 1));
+	result.avgEnemies /= ticks;
+	result.avgProjectiles /= ticks;
+	result.tickTime = elapsed / ticks;
+
+	for (auto& z: profiler.GetZones()) {
+		if (z.calls == 0)
+			continue;
+
+		ScenarioResult::Zone zone;
+		zone.name  = z.name;
+		zone.time  = z.time / ticks;
+		zone.calls = z.calls / ticks;
+		result.zones.push_back(zone);
+	}
+
+	for (size_t c=0; c < RenderStats::NUM_CATEGORIES; ++c) {
+		if (renderTotal[c].drawCalls == 0)
+			continue;
+
+		ScenarioResult::Render render;
+		render.category     = RenderStats::GetCategoryName(static_cast<RenderStats::Category>(c));
+		render.drawCalls    = renderTotal[c].drawCalls / ticks;
+		render.postFxPasses = renderTotal[c].postFxPasses / ticks;
+		render.imageChanges = renderTotal[c].imageChanges / ticks;
+		result.render.push_back(render);
+	}
+
+	for (size_t t=0; t < AllocTracker::GetNumTags(); ++t) {
+		if (allocTotal[t].allocations == 0 && allocTotal[t].frees == 0)
+			continue;
+
+		ScenarioResult::Allocations allocs;
+		allocs.tag         = AllocTracker::GetTagName(t);
+		allocs.allocations = allocTotal[t].allocations / ticks;
+		allocs.bytes       = allocTotal[t].bytes / ticks;
+		allocs.frees       = allocTotal[t].frees / ticks;
+		result.allocations.push_back(allocs);
+	}
+
+	return result;
+}
+
+js::mObject ResultToJson(const ScenarioResult& result)
+{
+	js::mObject obj;
+	obj["name"] = result.name;
+	obj["ticks"] = js::mValue(static_cast<uint64_t>(result.ticks));
+	obj["towers"] = js::mValue(static_cast<uint64_t>(result.towers));
+	obj["avg-enemies"] = result.avgEnemies;
+	obj["avg-projectiles"] = result.avgProjectiles;
+	obj["tick-ns"] = result.tickTime;
+
+	js::mObject zones;
+	for (auto& z: result.zones) {
+		js::mObject zone;
+		zone["ns-per-tick"] = z.time;
+		zone["calls-per-tick"] = z.calls;
+		zones[z.name] = zone;
+	}
+	obj["zones"] = zones;
+
+	if (!result.render.empty()) {
+		js::mObject render;
+		for (auto& r: result.render) {
+			js::mObject category;
+			category["draw-calls-per-frame"] = r.drawCalls;
+			category["postfx-passes-per-frame"] = r.postFxPasses;
+			category["image-changes-per-frame"] = r.imageChanges;
+			render[r.category] = category;
+		}
+		obj["render"] = render;
+	}
+
+	js::mObject allocations;
+	for (auto& a: result.allocations) {
+		js::mObject tag;
+		tag["allocations-per-tick"] = a.allocations;
+		tag["bytes-per-tick"] = a.bytes;
+		tag["frees-per-tick"] = a.frees;
+		allocations[a.tag] = tag;
+	}
+	obj["allocations"] = allocations;
+
+	return obj;
+}
+
+void PrintResult(std::ostream& out, const ScenarioResult& result)
+{
+	out << result.name << ": " << result.ticks << " ticks, " << result.towers << " towers, "
+	    << std::fixed << std::setprecision(0) << result.avgEnemies << " enemies, " << result.avgProjectiles << " projectiles\n"
+	    << "  " << std::left << std::setw(28) << "tick" << std::right << std::setw(14) << result.tickTime << " ns\n";
+
+	for (auto& z: result.zones) {
+		out << "  " << std::left << std::setw(28) << z.name << std::right << std::setw(14) << z.time << " ns"
+		    << std::setw(12) << std::setprecision(1) << z.calls << " calls" << std::setprecision(0) << "\n";
+	}
+
+	for (auto& r: result.render) {
+		out << "  render " << std::left << std::setw(21) << r.category << std::right << std::setprecision(1)
+		    << std::setw(10) << r.drawCalls << " draws" << std::setw(10) << r.postFxPasses << " postfx"
+		    << std::setw(10) << r.imageChanges << " image changes" << std::setprecision(0) << "\n";
+	}
+
+	for (auto& a: result.allocations) {
+		out << "  allocs " << std::left << std::setw(21) << a.tag << std::right << std::setprecision(1)
+		    << std::setw(10) << a.allocations << " allocs" << std::setw(10) << a.bytes << " bytes"
+		    << std::setw(10) << a.frees << " frees" << std::setprecision(0) << "\n";
+	}
+	out.unsetf(std::ios::fixed);
+	out << std::setprecision(6);
+}
+
+std::vector<EndlessStep> RunEndless(const EndlessSettings& es, std::function<void (const EndlessStep&)> progress)
+{
+	gStatus.Reset();
+	gStatus.startLives = PLENTY;
+	gStatus.startMoney = PLENTY;
+
+	Simulation simulation(gStatus);
+	simulation.Reset(es.level, 0);
+
+	// towers on all places, the types in turn
+	std::vector<Vector2f> places = simulation.GetMap().GetTowerPlaces();
+	for (size_t i=0; i < places.size(); ++i)
+		simulation.AddTower(gTheme.GetTowerSettings(i % gTheme.GetNumTowerSettings()), places[i]);
+
+	const Map& map = simulation.GetMap();
+	size_t spawned = 0;
+
+	std::vector<EndlessStep> curve;
+	double enemies = static_cast<double>(es.firstWave);
+	for (size_t wave=0; wave < es.maxWaves; ++wave, enemies *= es.waveGrowth) {
+		const size_t waveEnemies = static_cast<size_t>(enemies + 0.5);
+		const size_t spawnTicks = es.waveTicks / 2;
+
+		EndlessStep step;
+		step.wave = wave;
+		step.enemies = 0;
+		step.projectiles = 0;
+		step.avgFrameTime = 0;
+		step.maxFrameTime = 0;
+
+		for (size_t i=0; i < es.waveTicks; ++i) {
+			// ramp up to the number of enemies for this wave, then keep it
+			size_t target = i < spawnTicks ? waveEnemies * (i + 1) / spawnTicks : waveEnemies;
+			for (size_t n = simulation.GetNumEnemies(); n < target; ++n, ++spawned)
+				simulation.SpawnEnemy(spawned % simulation.GetNumEnemyTypes(), spawned % map.GetNumSpawns());
+
+			uint64_t start = Profiler::GetTime();
+			simulation.Update(SIM_TICK);
+			double frameTime = (Profiler::GetTime() - start) / 1e6;
+
+			if (i >= spawnTicks) {
+				step.enemies += simulation.GetNumEnemies();
+				step.projectiles += simulation.GetNumProjectiles();
+				step.avgFrameTime += frameTime;
+				step.maxFrameTime = std::max(step.maxFrameTime, frameTime);
+			}
+		}
+
+		const size_t measured = std::max<size_t>(es.waveTicks - spawnTicks, 1);
+		step.enemies /= measured;
+		step.projectiles /= measured;
+		step.towers = simulation.GetTowers().GetSize();
+		step.avgFrameTime /= measured;
+
+		curve.push_back(step);
+		if (progress)
+			progress(step);
+
+		if (step.avgFrameTime > es.budget)
+			break;
+	}
+
+	return curve;
+}
+
+js::mObject EndlessToJson(const EndlessSettings& es, const std::vector<EndlessStep>& curve)
+{
+	js::mObject obj;
+	obj["level"] = es.level;
+	obj["budget-ms"] = es.budget;
+	obj["exceeded"] = !curve.empty() && curve.back().avgFrameTime > es.budget;
+
+	js::mArray points;
+	for (auto& step: curve) {
+		js::mObject pt;
+		pt["wave"] = js::mValue(static_cast<uint64_t>(step.wave));
+		pt["enemies"] = js::mValue(static_cast<uint64_t>(step.enemies));
+		pt["projectiles"] = js::mValue(static_cast<uint64_t>(step.projectiles));
+		pt["towers"] = js::mValue(static_cast<uint64_t>(step.towers));
+		pt["entities"] = js::mValue(static_cast<uint64_t>(step.enemies + step.projectiles + step.towers));
+		pt["avg-frame-ms"] = step.avgFrameTime;
+		pt["max-frame-ms"] = step.maxFrameTime;
+		points.push_back(pt);
+	}
+	obj["curve"] = points;
+
+	return obj;
+}
+
+void PrintEndlessStep(std::ostream& out, const EndlessStep& step)
+{
+	out << "wave " << std::setw(3) << step.wave << ": "
+	    << std::setw(7) << step.enemies << " enemies, "
+	    << std::setw(6) << step.projectiles << " projectiles, "
+	    << std::setw(5) << step.towers << " towers, "
+	    << std::fixed << std::setprecision(3) << std::setw(9) << step.avgFrameTime << " ms avg, "
+	    << std::setw(9) << step.maxFrameTime << " ms max" << std::endl;
+	out.unsetf(std::ios::fixed);
+	out << std::setprecision(6);
+}
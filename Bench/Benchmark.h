@@ -0,0 +1,119 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "json_spirit/json_spirit.h"
+
+#include <functional>
+
+// A fixed stress scenario. The enemies get spawned during the warmup and are kept at
+// the given number afterwards, so the measured ticks always see the same load.
+struct Scenario
+{
+	std::string name;
+	std::string level;
+
+	size_t enemies;
+	size_t towersPerType;
+	std::string towerType;  // if set, only place towers of this type
+	bool maxStage;          // upgrade all towers to their last stage
+	size_t firePlaces;      // fire effects get updated and drawn every tick, needs a window
+
+	size_t warmupTicks;
+	size_t ticks;
+
+	Scenario()
+	: level("bench/forest.js"), enemies(0), towersPerType(0), maxStage(false), firePlaces(0), warmupTicks(500), ticks(1000)
+	{ }
+
+	bool NeedsWindow() const
+	{
+		return firePlaces > 0;
+	}
+};
+
+struct ScenarioResult
+{
+	std::string name;
+	size_t ticks;
+
+	size_t towers;
+	double avgEnemies;
+	double avgProjectiles;
+
+	// time of Simulation::Update (and the effects) in nanoseconds per tick
+	double tickTime;
+
+	struct Zone
+	{
+		std::string name;
+		double time;   // nanoseconds per tick
+		double calls;  // calls per tick
+	};
+	std::vector<Zone> zones;
+
+	// render stats per drawn frame, only for scenarios with a window
+	struct Render
+	{
+		std::string category;
+		double drawCalls;
+		double postFxPasses;
+		double imageChanges;
+	};
+	std::vector<Render> render;
+
+	// allocations per tick by tag, including the spawns that keep the enemies up
+	struct Allocations
+	{
+		std::string tag;
+		double allocations;
+		double bytes;
+		double frees;
+	};
+	std::vector<Allocations> allocations;
+};
+
+// Endless mode: the number of enemies is raised with every wave until a frame
+// (one tick at normal speed) takes longer than the budget.
+struct EndlessSettings
+{
+	std::string level;
+	double budget;       // in milliseconds
+	size_t firstWave;    // enemies in the first wave
+	float waveGrowth;
+	size_t waveTicks;    // the enemies are spawned during the first half, the second half is measured
+	size_t maxWaves;
+
+	EndlessSettings()
+	: budget(10), firstWave(100), waveGrowth(1.25f), waveTicks(200), maxWaves(100)
+	{ }
+};
+
+// One point of the entity count / frame time curve
+struct EndlessStep
+{
+	size_t wave;
+	size_t enemies;
+	size_t projectiles;
+	size_t towers;
+
+	double avgFrameTime;  // milliseconds
+	double maxFrameTime;
+};
+
+std::vector<Scenario> GetDefaultScenarios();
+
+// Run the scenario and collect the profiler zones of the measured ticks. The window
+// may be nullptr for scenarios that do not need one.
+ScenarioResult RunScenario(const Scenario& scenario, RenderWindow* window);
+
+json_spirit::mObject ResultToJson(const ScenarioResult& result);
+void PrintResult(std::ostream& out, const ScenarioResult& result);
+
+// Run the endless mode on the level with towers on all tower places. The callback gets
+// called after every wave.
+std::vector<EndlessStep> RunEndless(const EndlessSettings& settings, std::function<void (const EndlessStep&)> progress);
+
+json_spirit::mObject EndlessToJson(const EndlessSettings& settings, const std::vector<EndlessStep>& curve);
+void PrintEndlessStep(std::ostream& out, const EndlessStep& step);
+
+#endif //BENCHMARK_H
@@ -0,0 +1,275 @@
+#include "pch.h"
+#include "Gate.h"
+#include "Simulation.h"
+#include "Replay.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+#include "Theme.h"
+#include "TowerSettings.h"
+#include "Error.h"
+
+#include <iomanip>
+
+namespace js = json_spirit;
+namespace fs = boost::filesystem;
+
+// the bot acts every second and gives up after ten minutes of game time
+static const size_t BOT_INTERVAL = 100;
+static const size_t BOT_MAX_TICKS = 60000;
+
+static const double PERCENTILES[] = { 50, 90, 99 };
+static const char* PERCENTILE_NAMES[] = { "p50", "p90", "p99" };
+static const size_t NUM_PERCENTILES = 3;
+
+fs::path GetGateReplayPath()
+{
+	return fs::path("data/replays/gate");
+}
+
+static std::vector<std::string> FindReplays()
+{
+	fs::path dir = GetGateReplayPath();
+	if (!fs::is_directory(dir))
+		throw GameError() << ErrorInfo::Desc("Replay directory not found") << boost::errinfo_file_name(dir.string());
+
+	std::vector<std::string> replays;
+	for (fs::directory_iterator it(dir), end; it != end; ++it) {
+		if (it->path().extension() == ".replay")
+			replays.push_back(it->path().generic_string());
+	}
+	boost::sort(replays);
+
+	if (replays.empty())
+		throw GameError() << ErrorInfo::Desc("No replays found") << boost::errinfo_file_name(dir.string());
+	return replays;
+}
+
+std::vector<GateResult> RunGate(const GateSettings& settings)
+{
+	std::vector<std::string> files = settings.replays.empty() ? FindReplays() : settings.replays;
+
+	std::vector<GateResult> results;
+	for (auto& file: files) {
+		Replay replay;
+		replay.LoadFromFile(file);
+
+		GateResult result;
+		result.replay = file;
+		result.ticks = 0;
+		result.allocations = 0;
+
+		for (size_t run=0; run < settings.runs; ++run) {
+			gStatus.Reset();
+			Simulation simulation(gStatus);
+			ReplayPlayer player(replay, simulation);
+			player.Start(gStatus);
+
+			uint64_t frameTime = 0;
+			size_t frameTicks = 0;
+
+			AllocTracker::SetEnabled(true);
+			AllocTracker::EndFrame();
+
+			bool running = true;
+			while (running) {
+				uint64_t start = Profiler::GetTime();
+				running = player.Step();
+				uint64_t time = Profiler::GetTime() - start;
+
+				result.tickTime.Record(time);
+				frameTime += time;
+				if (++frameTicks == settings.ticksPerFrame) {
+					result.frameTime.Record(frameTime);
+					frameTime = 0;
+					frameTicks = 0;
+				}
+			}
+
+			AllocTracker::EndFrame();
+			AllocTracker::SetEnabled(false);
+
+			result.ticks = simulation.GetTick();
+			result.allocations = AllocTracker::GetFrameTotal().allocations;
+		}
+
+		results.push_back(result);
+	}
+
+	return results;
+}
+
+static double ToMs(uint64_t ns)
+{
+	return ns / 1e6;
+}
+
+static js::mObject HistogramToJson(const Histogram& histogram)
+{
+	js::mObject obj;
+	obj["count"] = static_cast<boost::int64_t>(histogram.GetCount());
+	obj["mean"] = histogram.GetMean() / 1e6;
+	for (size_t i=0; i < NUM_PERCENTILES; ++i)
+		obj[PERCENTILE_NAMES[i]] = ToMs(histogram.GetPercentile(PERCENTILES[i]));
+	obj["max"] = ToMs(histogram.GetMax());
+	return obj;
+}
+
+js::mObject GateToJson(const GateSettings& settings, const std::vector<GateResult>& results)
+{
+	js::mArray replays;
+	for (auto& result: results) {
+		js::mObject obj;
+		obj["replay"] = result.replay;
+		obj["ticks"] = static_cast<boost::int64_t>(result.ticks);
+		obj["tick"] = HistogramToJson(result.tickTime);
+		obj["frame"] = HistogramToJson(result.frameTime);
+		obj["allocations"] = static_cast<boost::int64_t>(result.allocations);
+		replays.push_back(obj);
+	}
+
+	js::mObject rootObj;
+	rootObj["version"] = 1;
+	rootObj["runs"] = static_cast<boost::int64_t>(settings.runs);
+	rootObj["ticks-per-frame"] = static_cast<boost::int64_t>(settings.ticksPerFrame);
+	rootObj["replays"] = replays;
+	return rootObj;
+}
+
+static const js::mObject* FindBaseline(const js::mObject& baseline, const std::string& replay)
+{
+	auto it = baseline.find("replays");
+	if (it == baseline.end() || it->second.type() != js::array_type)
+		return nullptr;
+
+	for (auto& val: it->second.get_array()) {
+		if (val.type() != js::obj_type)
+			continue;
+		const js::mObject& obj = val.get_obj();
+		auto name = obj.find("replay");
+		if (name != obj.end() && name->second.type() == js::str_type && name->second.get_str() == replay)
+			return &obj;
+	}
+	return nullptr;
+}
+
+static double GetValue(const js::mObject& obj, const std::string& histogram, const std::string& name)
+{
+	auto h = obj.find(histogram);
+	if (h == obj.end() || h->second.type() != js::obj_type)
+		return -1;
+
+	auto v = h->second.get_obj().find(name);
+	if (v == h->second.get_obj().end() || (v->second.type() != js::real_type && v->second.type() != js::int_type))
+		return -1;
+	return v->second.get_real();
+}
+
+size_t CompareGate(std::ostream& out, const GateSettings& settings, const std::vector<GateResult>& results, const js::mObject& baseline)
+{
+	auto framesIt = baseline.find("ticks-per-frame");
+	if (framesIt != baseline.end() && framesIt->second.type() == js::int_type && static_cast<size_t>(framesIt->second.get_int()) != settings.ticksPerFrame)
+		out << "warning: the baseline uses " << framesIt->second.get_int() << " ticks per frame, the frame times are not comparable\n";
+
+	out << std::fixed;
+
+	size_t regressions = 0;
+	for (auto& result: results) {
+		out << result.replay << "\n";
+
+		const js::mObject* base = FindBaseline(baseline, result.replay);
+		if (!base) {
+			out << "  not in the baseline\n";
+			continue;
+		}
+
+		auto ticksIt = base->find("ticks");
+		if (ticksIt != base->end() && ticksIt->second.type() == js::int_type && static_cast<size_t>(ticksIt->second.get_int()) != result.ticks) {
+			out << "  warning: the replay took " << ticksIt->second.get_int() << " ticks in the baseline and " << result.ticks
+			    << " now, the simulation does not play it the same anymore\n";
+		}
+
+		auto allocsIt = base->find("allocations");
+		if (allocsIt != base->end() && allocsIt->second.type() == js::int_type) {
+			boost::int64_t previous = allocsIt->second.get_int64();
+			out << "  allocs    " << std::setw(9) << previous << "    -> " << std::setw(9) << result.allocations;
+			if (static_cast<boost::int64_t>(result.allocations) > previous) {
+				out << "     REGRESSION";
+				regressions++;
+			}
+			out << "\n";
+		}
+
+		const char* histogramNames[] = { "tick", "frame" };
+		const Histogram* histograms[] = { &result.tickTime, &result.frameTime };
+		for (size_t h=0; h < 2; ++h) {
+			for (size_t i=0; i <= NUM_PERCENTILES; ++i) {
+				// the last row is the maximum, which never fails the gate
+				bool isMax = i == NUM_PERCENTILES;
+				std::string name = isMax ? "max" : PERCENTILE_NAMES[i];
+				double current = ToMs(isMax ? histograms[h]->GetMax() : histograms[h]->GetPercentile(PERCENTILES[i]));
+				double previous = GetValue(*base, histogramNames[h], name);
+
+				out << "  " << std::setw(5) << std::left << histogramNames[h] << " " << std::setw(3) << name << std::right;
+				if (previous < 0) {
+					out << "  " << std::setprecision(3) << std::setw(9) << current << " ms (not in the baseline)\n";
+					continue;
+				}
+
+				out << std::setprecision(3) << std::setw(9) << previous << " ms -> " << std::setw(9) << current << " ms";
+				if (previous > 0)
+					out << "  " << std::showpos << std::setprecision(1) << std::setw(7) << (current / previous - 1) * 100 << "%" << std::noshowpos;
+
+				bool regressed = current > previous * (1 + settings.threshold / 100) && current - previous > settings.minDelta;
+				if (regressed && !isMax) {
+					out << "  REGRESSION";
+					regressions++;
+				}
+				out << "\n";
+			}
+		}
+	}
+
+	out << std::setprecision(6);
+	out.unsetf(std::ios_base::floatfield);
+	return regressions;
+}
+
+Replay RecordBotReplay(const std::string& level, unsigned int seed)
+{
+	gStatus.Reset();
+
+	Replay replay;
+	Simulation simulation(gStatus);
+	simulation.SetRecorder(&replay);
+	simulation.Reset(level, seed);
+
+	size_t nextType = 0;
+	while (simulation.IsRunning() && simulation.GetTick() < BOT_MAX_TICKS) {
+		if (simulation.GetTick() % BOT_INTERVAL == 0) {
+			const GameStatus& status = simulation.GetStatus();
+			if (status.waveState == GameStatus::InCountdown)
+				simulation.SkipCountdown();
+
+			// build the tower types in turn, upgrade while there is not enough money
+			const TowerSettings* settings = gTheme.GetTowerSettings(nextType);
+			const auto& places = simulation.GetMap().GetTowerPlaces();
+			if (!places.empty() && status.money >= settings->baseCost) {
+				simulation.AddTower(settings, places.front());
+				nextType = (nextType + 1) % gTheme.GetNumTowerSettings();
+			}
+			else {
+				const TowerStore& towers = simulation.GetTowers();
+				for (size_t i=0; i < towers.GetSize(); ++i) {
+					if (towers.Get(i).CanUpgrade()) {
+						simulation.UpgradeTower(towers.Get(i).GetPosition());
+						break;
+					}
+				}
+			}
+		}
+
+		simulation.Update(SIM_TICK);
+	}
+
+	return replay;
+}
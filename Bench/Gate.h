@@ -0,0 +1,53 @@
+#ifndef GATE_H
+#define GATE_H
+
+#include "Histogram.h"
+#include "json_spirit/json_spirit.h"
+
+struct Replay;
+
+// Performance regression gate: a fixed set of replays is played back headless and the
+// time per tick and per frame is compared against a baseline from an earlier run.
+struct GateSettings
+{
+	std::vector<std::string> replays;  // empty: all replays in GetGateReplayPath()
+	std::string baseline;
+	double threshold;       // allowed increase of a percentile in percent
+	double minDelta;        // smaller increases in milliseconds are ignored as noise
+	size_t runs;            // every replay is played this many times
+	size_t ticksPerFrame;   // 4 ticks are one frame at 100 fps and quadruple speed
+
+	GateSettings()
+	: baseline("gate-baseline.json"), threshold(10), minDelta(0.05), runs(3), ticksPerFrame(4)
+	{ }
+};
+
+struct GateResult
+{
+	std::string replay;
+	size_t ticks;
+
+	Histogram tickTime;
+	Histogram frameTime;
+
+	// allocations during the playback, the same replay always allocates the same
+	uint64_t allocations;
+};
+
+// Directory of the replays played by the gate
+boost::filesystem::path GetGateReplayPath();
+
+std::vector<GateResult> RunGate(const GateSettings& settings);
+
+json_spirit::mObject GateToJson(const GateSettings& settings, const std::vector<GateResult>& results);
+
+// Print the differences to the baseline. Only p50, p90 and p99 and any increase of the
+// allocations can fail the gate, the maximum is too noisy and only shown. Returns the
+// number of regressions.
+size_t CompareGate(std::ostream& out, const GateSettings& settings, const std::vector<GateResult>& results, const json_spirit::mObject& baseline);
+
+// Play the level with a simple bot that builds and upgrades towers whenever possible and
+// skips all countdowns, to record a replay that reaches the late waves.
+Replay RecordBotReplay(const std::string& level, unsigned int seed);
+
+#endif //GATE_H
@@ -0,0 +1,314 @@
+#include "pch.h"
+#include "Generator.h"
+#include "DataPaths.h"
+#include "Error.h"
+
+#include "json_spirit/json_spirit.h"
+
+namespace fs = boost::filesystem;
+namespace js = json_spirit;
+
+// all sizes in blocks
+static const int PATH_WIDTH = 3;        // has to be odd
+static const int MARGIN = 2;            // free space at the map border
+static const int MIN_ROW_GAP = 3;       // free space between two rows of the path
+static const int TURN_JITTER = 4;       // random inset of the turns
+static const int TOWER_DISTANCE = 2;    // maximal distance of tower places to the path
+static const int TOWER_SPACING = 2;     // minimal distance between two tower places
+
+static const Color GRASS_COLOR(74, 122, 48);
+static const Color PATH_COLOR(160, 130, 85);
+
+namespace {
+
+class Grid
+{
+	int width, height;
+	std::vector<bool> cells;
+
+public:
+	Grid(int w, int h)
+	: width(w), height(h), cells(w * h, false)
+	{ }
+
+	int GetWidth() const { return width; }
+	int GetHeight() const { return height; }
+
+	bool Get(int x, int y) const
+	{
+		return x >= 0 && y >= 0 && x < width && y < height && cells[y * width + x];
+	}
+
+	void Set(int x, int y)
+	{
+		if (x >= 0 && y >= 0 && x < width && y < height)
+			cells[y * width + x] = true;
+	}
+
+	// Is any cell in the square with the given radius around x, y set?
+	bool AnyAround(int x, int y, int radius) const
+	{
+		for (int dy=-radius; dy <= radius; ++dy) {
+			for (int dx=-radius; dx <= radius; ++dx) {
+				if (Get(x + dx, y + dy))
+					return true;
+			}
+		}
+		return false;
+	}
+};
+
+}
+
+// Center line of the path, a list of block positions with only horizontal and vertical segments
+static std::vector<Vector2i> MakeCenterLine(const GeneratorSettings& s)
+{
+	const int width  = static_cast<int>(s.width);
+	const int height = static_cast<int>(s.height);
+
+	const int rowLength = width - 2 * MARGIN - PATH_WIDTH;
+	const int maxRows = (height - 2 * MARGIN + MIN_ROW_GAP) / (PATH_WIDTH + MIN_ROW_GAP);
+	if (rowLength < 2 * TURN_JITTER || maxRows < 1)
+		throw GameError() << ErrorInfo::Desc("Map is too small") << ErrorInfo::Note(s.name);
+
+	int rows = static_cast<int>(s.pathLength) / (rowLength + PATH_WIDTH + MIN_ROW_GAP) + 1;
+	rows = std::min(rows, maxRows);
+	int gap = rows > 1 ? (height - 2 * MARGIN - rows * PATH_WIDTH) / (rows - 1) : 0;
+
+	const int left  = MARGIN + PATH_WIDTH / 2;
+	const int right = width - 1 - MARGIN - PATH_WIDTH / 2;
+
+	std::vector<Vector2i> line;
+	line.push_back(Vector2i(left, MARGIN + PATH_WIDTH / 2));
+
+	for (int row=0; row < rows; ++row) {
+		int y = MARGIN + PATH_WIDTH / 2 + row * (PATH_WIDTH + gap);
+		int x = row % 2 == 0 ? right - Randomizer::Random(0, TURN_JITTER) : left + Randomizer::Random(0, TURN_JITTER);
+
+		if (row > 0)
+			line.push_back(Vector2i(line.back().x, y));
+		line.push_back(Vector2i(x, y));
+	}
+
+	// cut the path at the requested length
+	int remaining = static_cast<int>(s.pathLength);
+	for (size_t i=1; i < line.size(); ++i) {
+		Vector2i d = line[i] - line[i-1];
+		int length = std::abs(d.x) + std::abs(d.y);
+		if (length >= remaining) {
+			line[i] = line[i-1] + Vector2i(d.x / length * remaining, d.y / length * remaining);
+			line.resize(i + 1);
+			break;
+		}
+		remaining -= length;
+	}
+
+	return line;
+}
+
+// Position at the given distance along the center line
+static Vector2i PointOnLine(const std::vector<Vector2i>& line, int distance)
+{
+	for (size_t i=1; i < line.size(); ++i) {
+		Vector2i d = line[i] - line[i-1];
+		int length = std::abs(d.x) + std::abs(d.y);
+		if (distance <= length && length > 0)
+			return line[i-1] + Vector2i(d.x / length * distance, d.y / length * distance);
+		distance -= length;
+	}
+	return line.back();
+}
+
+static int LineLength(const std::vector<Vector2i>& line)
+{
+	int length = 0;
+	for (size_t i=1; i < line.size(); ++i)
+		length += std::abs(line[i].x - line[i-1].x) + std::abs(line[i].y - line[i-1].y);
+	return length;
+}
+
+static Grid RasterizePath(const GeneratorSettings& s, const std::vector<Vector2i>& line)
+{
+	Grid grid(static_cast<int>(s.width), static_cast<int>(s.height));
+
+	for (int dist=0; dist <= LineLength(line); ++dist) {
+		Vector2i pt = PointOnLine(line, dist);
+		for (int dy=-PATH_WIDTH/2; dy <= PATH_WIDTH/2; ++dy) {
+			for (int dx=-PATH_WIDTH/2; dx <= PATH_WIDTH/2; ++dx)
+				grid.Set(pt.x + dx, pt.y + dy);
+		}
+	}
+
+	return grid;
+}
+
+static js::mArray WritePosition(const GeneratorSettings& s, const Vector2i& blk)
+{
+	js::mArray arr;
+	arr.push_back((blk.x + 0.5) * s.blockSize);
+	arr.push_back((blk.y + 0.5) * s.blockSize);
+	return arr;
+}
+
+// Pick random free blocks next to the path, which are not too close to each other
+static std::vector<Vector2i> PickPlaces(const Grid& path, Grid& used, size_t count, int maxDistance, int spacing)
+{
+	std::vector<Vector2i> candidates;
+	for (int y=0; y < path.GetHeight(); ++y) {
+		for (int x=0; x < path.GetWidth(); ++x) {
+			if (!path.Get(x, y) && path.AnyAround(x, y, maxDistance))
+				candidates.push_back(Vector2i(x, y));
+		}
+	}
+
+	// Fisher-Yates, so the result only depends on the seed
+	for (size_t i=candidates.size(); i > 1; --i)
+		std::swap(candidates[i-1], candidates[Randomizer::Random(0, static_cast<int>(i) - 1)]);
+
+	std::vector<Vector2i> places;
+	for (auto& c: candidates) {
+		if (places.size() == count)
+			break;
+		if (used.AnyAround(c.x, c.y, spacing - 1))
+			continue;
+
+		used.Set(c.x, c.y);
+		places.push_back(c);
+	}
+
+	if (places.size() < count)
+		throw GameError() << ErrorInfo::Desc("Not enough room on the map") << ErrorInfo::Note(boost::lexical_cast<std::string>(count) + " places requested");
+	return places;
+}
+
+std::string GenerateMap(const GeneratorSettings& s)
+{
+	Randomizer::SetSeed(s.seed);
+
+	std::string mapName = "generated/" + s.name;
+	fs::path base = GetMapPath(mapName);
+	fs::create_directories(base);
+
+	auto line = MakeCenterLine(s);
+	Grid path = RasterizePath(s, line);
+
+	js::mObject rootObj;
+	rootObj["name"] = "Generated " + s.name;
+	rootObj["theme"] = "default";
+
+	// spread the spawns over the first half of the path
+	const int length = LineLength(line);
+	js::mArray spawns;
+	for (size_t i=0; i < s.spawns; ++i)
+		spawns.push_back(WritePosition(s, PointOnLine(line, static_cast<int>(i * length / (2 * s.spawns)))));
+	rootObj["spawn-places"] = spawns;
+
+	Vector2i end = line.back();
+	js::mObject target;
+	js::mArray topLeft;
+	topLeft.push_back(static_cast<double>((end.x - PATH_WIDTH/2) * s.blockSize));
+	topLeft.push_back(static_cast<double>((end.y - PATH_WIDTH/2) * s.blockSize));
+	target["top-left"] = topLeft;
+	target["width"] = static_cast<double>(PATH_WIDTH * s.blockSize);
+	target["height"] = static_cast<double>(PATH_WIDTH * s.blockSize);
+	rootObj["target-area"] = target;
+	rootObj["default-target"] = WritePosition(s, end);
+
+	Grid used(path.GetWidth(), path.GetHeight());
+	js::mArray towerPlaces;
+	for (auto& blk: PickPlaces(path, used, s.towerPlaces, TOWER_DISTANCE, TOWER_SPACING))
+		towerPlaces.push_back(WritePosition(s, blk));
+	rootObj["tower-places"] = towerPlaces;
+
+	js::mArray firePlaces;
+	for (auto& blk: PickPlaces(path, used, s.firePlaces, TOWER_DISTANCE + 2, 1))
+		firePlaces.push_back(WritePosition(s, blk));
+	rootObj["fire-places"] = firePlaces;
+
+	js::mObject pathObj;
+	pathObj["block-size"] = static_cast<int>(s.blockSize);
+	js::mArray rows;
+	for (int y=0; y < path.GetHeight(); ++y) {
+		std::string row(path.GetWidth(), '.');
+		for (int x=0; x < path.GetWidth(); ++x) {
+			if (path.Get(x, y))
+				row[x] = '#';
+		}
+		rows.push_back(row);
+	}
+	pathObj["rows"] = rows;
+	rootObj["path"] = pathObj;
+
+	fs::path mapFile = base / MapDefinitionFile;
+	std::ofstream out(mapFile.string());
+	if (!out.is_open())
+		throw GameError() << ErrorInfo::Desc("Failed to open file") << boost::errinfo_file_name(mapFile.string());
+	js::write_formatted(rootObj, out);
+
+	// the map size is taken from the background
+	Image bg;
+	bg.Create(static_cast<unsigned int>(s.width * s.blockSize), static_cast<unsigned int>(s.height * s.blockSize), GRASS_COLOR);
+	for (unsigned int y=0; y < bg.GetHeight(); ++y) {
+		for (unsigned int x=0; x < bg.GetWidth(); ++x) {
+			if (path.Get(static_cast<int>(x / s.blockSize), static_cast<int>(y / s.blockSize)))
+				bg.SetPixel(x, y, PATH_COLOR);
+		}
+	}
+
+	fs::path bgFile = base / "background.png";
+	if (!bg.SaveToFile(bgFile.string()))
+		throw GameError() << ErrorInfo::Desc("Failed to write image") << boost::errinfo_file_name(bgFile.string());
+
+	return mapName;
+}
+
+std::string GenerateLevel(const GeneratorSettings& s, const std::string& map)
+{
+	js::mObject rootObj;
+	rootObj["name"] = "Generated " + s.name;
+	rootObj["theme"] = "default";
+	rootObj["map"] = map;
+
+	js::mArray waves;
+	double enemies = static_cast<double>(s.firstWave);
+	for (size_t i=0; i < s.waves; ++i, enemies *= s.waveGrowth) {
+		size_t total = static_cast<size_t>(enemies + 0.5);
+
+		// split the enemies evenly over the spawns and types
+		js::mArray perSpawn;
+		for (size_t sp=0; sp < s.spawns; ++sp) {
+			size_t spawnCount = total / s.spawns + (sp < total % s.spawns ? 1 : 0);
+
+			js::mArray groups;
+			for (size_t tp=0; tp < s.enemyTypes; ++tp) {
+				size_t count = spawnCount / s.enemyTypes + (tp < spawnCount % s.enemyTypes ? 1 : 0);
+				if (count == 0)
+					continue;
+
+				js::mArray group;
+				group.push_back(static_cast<int>(tp));
+				group.push_back(static_cast<int>(count));
+				groups.push_back(group);
+			}
+			perSpawn.push_back(groups);
+		}
+
+		js::mObject wave;
+		wave["countdown"] = 5;
+		wave["enemies"] = perSpawn;
+		waves.push_back(wave);
+	}
+	rootObj["waves"] = waves;
+
+	std::string levelName = "generated/" + s.name + ".js";
+	fs::path levelPath = GetLevelPath(levelName);
+	fs::create_directories(levelPath);
+
+	fs::path levelFile = levelPath / GetLevelFile(levelName);
+	std::ofstream out(levelFile.string());
+	if (!out.is_open())
+		throw GameError() << ErrorInfo::Desc("Failed to open file") << boost::errinfo_file_name(levelFile.string());
+	js::write_formatted(rootObj, out);
+
+	return levelName;
+}
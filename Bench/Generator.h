@@ -0,0 +1,36 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+// Settings for a generated stress map and level. The path snakes over the map in
+// rows until it has the requested length, the spawns are spread over the path.
+struct GeneratorSettings
+{
+	std::string name;         // the map gets written to data/maps/generated/<name>,
+	                          // the level to data/levels/generated/<name>.js
+	unsigned int seed;
+
+	size_t width, height;     // grid size in blocks
+	size_t blockSize;
+	size_t pathLength;        // in blocks, the path gets shorter if it does not fit
+	size_t spawns;
+	size_t towerPlaces;
+	size_t firePlaces;
+
+	size_t waves;
+	size_t firstWave;         // number of enemies in the first wave
+	float waveGrowth;         // each wave has this many times more enemies than the one before
+	size_t enemyTypes;        // enemy types 0 to enemyTypes-1 get used in turn
+
+	GeneratorSettings()
+	: name("stress"), seed(0), width(100), height(75), blockSize(16), pathLength(1000), spawns(4),
+	  towerPlaces(200), firePlaces(10), waves(20), firstWave(50), waveGrowth(1.5f), enemyTypes(2)
+	{ }
+};
+
+// Write map.js and background.png, returns the name of the map
+std::string GenerateMap(const GeneratorSettings& settings);
+
+// Write the level for a map created by GenerateMap, returns the name of the level
+std::string GenerateLevel(const GeneratorSettings& settings, const std::string& map);
+
+#endif //GENERATOR_H
@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "Histogram.h"
+
+#include <cmath>
+#include <limits>
+
+// values below SUB_BUCKETS get a bucket of their own, every following power of two gets SUB_BUCKETS
+static const size_t NUM_BUCKETS = (64 - Histogram::SUB_BUCKET_BITS + 1) * Histogram::SUB_BUCKETS;
+
+Histogram::Histogram()
+: counts(NUM_BUCKETS), count(0), total(0), min(std::numeric_limits<uint64_t>::max()), max(0)
+{
+}
+
+/*static*/ size_t Histogram::GetBucket(uint64_t value)
+{
+	if (value < SUB_BUCKETS)
+		return static_cast<size_t>(value);
+
+	size_t msb = 0;
+	for (uint64_t v = value; v > 1; v >>= 1)
+		msb++;
+
+	// keep the SUB_BUCKET_BITS + 1 highest bits, the first one is always set
+	size_t shift = msb - SUB_BUCKET_BITS;
+	size_t sub = static_cast<size_t>(value >> shift) - SUB_BUCKETS;
+	return (shift + 1) * SUB_BUCKETS + sub;
+}
+
+/*static*/ uint64_t Histogram::GetBucketMax(size_t bucket)
+{
+	if (bucket < SUB_BUCKETS)
+		return bucket;
+
+	size_t shift = bucket / SUB_BUCKETS - 1;
+	uint64_t sub = bucket % SUB_BUCKETS + SUB_BUCKETS;
+	return ((sub + 1) << shift) - 1;
+}
+
+void Histogram::Record(uint64_t value)
+{
+	counts[GetBucket(value)]++;
+	count++;
+	total += value;
+	min = std::min(min, value);
+	max = std::max(max, value);
+}
+
+void Histogram::Merge(const Histogram& other)
+{
+	for (size_t i=0; i < NUM_BUCKETS; ++i)
+		counts[i] += other.counts[i];
+	count += other.count;
+	total += other.total;
+	min = std::min(min, other.min);
+	max = std::max(max, other.max);
+}
+
+uint64_t Histogram::GetPercentile(double percent) const
+{
+	if (count == 0)
+		return 0;
+
+	uint64_t rank = static_cast<uint64_t>(std::ceil(percent / 100 * count));
+	rank = std::max<uint64_t>(rank, 1);
+
+	uint64_t seen = 0;
+	for (size_t i=0; i < NUM_BUCKETS; ++i) {
+		seen += counts[i];
+		if (seen >= rank)
+			return std::min(GetBucketMax(i), max);
+	}
+	return max;
+}
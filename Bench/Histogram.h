@@ -0,0 +1,55 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <cstdint>
+
+// Log-linear histogram of durations in nanoseconds (like HdrHistogram). Every power
+// of two is split into SUB_BUCKETS buckets, so all values are kept with a relative
+// error below 1 / SUB_BUCKETS and the size does not depend on the number of values.
+class Histogram
+{
+public:
+	static const size_t SUB_BUCKET_BITS = 5;
+	static const size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+private:
+	std::vector<uint64_t> counts;
+	uint64_t count;
+	uint64_t total;
+	uint64_t min, max;
+
+public:
+	Histogram();
+
+	void Record(uint64_t value);
+	void Merge(const Histogram& other);
+
+	uint64_t GetCount() const
+	{
+		return count;
+	}
+
+	uint64_t GetMin() const
+	{
+		return count ? min : 0;
+	}
+
+	uint64_t GetMax() const
+	{
+		return max;
+	}
+
+	double GetMean() const
+	{
+		return count ? static_cast<double>(total) / count : 0;
+	}
+
+	// Smallest value (within the precision) that is greater or equal to percent % of all values
+	uint64_t GetPercentile(double percent) const;
+
+private:
+	static size_t GetBucket(uint64_t value);
+	static uint64_t GetBucketMax(size_t bucket);
+};
+
+#endif //HISTOGRAM_H
@@ -0,0 +1,319 @@
+#include "pch.h"
+#include "KernelBench.h"
+#include "Components.h"
+#include "Kernels.h"
+#include "Simulation.h"
+#include "Utility.h"
+#include "Profiler.h"
+
+#include <iomanip>
+
+namespace js = json_spirit;
+
+static const size_t BATCH_SIZES[] = { 100, 1000, 10000 };
+
+// the objects are spread over an area of the size of a map
+static const float AREA_WIDTH = 800;
+static const float AREA_HEIGHT = 600;
+
+static const float MIN_RANGE = 30;
+static const float MAX_RANGE = 150;
+
+// the acos approximation of the kernels is a lot closer, the rest is rounding
+static const float MAX_ROTATION_ERROR = 0.001f;  // in degrees
+
+// only the first failures of a batch are described
+static const size_t MAX_REPORTED = 5;
+
+// The per-object code the kernels replaced, kept as the reference
+namespace Legacy
+{
+	static const Vector2f LEFT(-1.0f, 0.0f);
+
+	// MoveProjectiles on the components
+	static void MoveProjectiles(std::vector<Transform>& transforms, std::vector<Projectile>& projectiles, float elapsed)
+	{
+		for (size_t i=0; i < projectiles.size(); ++i) {
+			Projectile& p = projectiles[i];
+			if (p.hit)
+				continue;
+
+			Vector2f dir = p.targetPosition - transforms[i].pos;
+			float r = norm(dir);
+			if (r < HIT_DISTANCE) {
+				p.hit = true;
+				continue;
+			}
+
+			dir /= r;
+			float angle = acosf(dot(LEFT, dir));
+			if (dir.y < 0)
+				angle = -angle;
+
+			transforms[i].pos += dir * p.speed * elapsed;
+			transforms[i].rotation = angle * 180/PI;
+		}
+	}
+
+	// An item of the grid of the EnemyIndex
+	struct Item
+	{
+		Vector2f pos;
+		uint32_t entry;
+	};
+
+	// EnemyIndex::ForEachInRange over the items of some cells
+	static size_t SelectInRange(const std::vector<Item>& items, const Vector2f& pos, float rangeSq, uint32_t* out)
+	{
+		size_t count = 0;
+		for (size_t i=0; i < items.size(); ++i) {
+			if (distSq(items[i].pos, pos) <= rangeSq)
+				out[count++] = static_cast<uint32_t>(i);
+		}
+		return count;
+	}
+}
+
+static Vector2f RandomPosition()
+{
+	return Vector2f(Randomizer::Random(0.0f, AREA_WIDTH), Randomizer::Random(0.0f, AREA_HEIGHT));
+}
+
+// What MoveProjectiles does around the kernel, without looking up the targets
+static void CopyToBatch(const std::vector<Transform>& transforms, const std::vector<Projectile>& projectiles, HomingBatch& batch)
+{
+	batch.Resize(transforms.size());
+	for (size_t i=0; i < transforms.size(); ++i) {
+		batch.x[i] = transforms[i].pos.x;
+		batch.y[i] = transforms[i].pos.y;
+		batch.targetX[i] = projectiles[i].targetPosition.x;
+		batch.targetY[i] = projectiles[i].targetPosition.y;
+		batch.speed[i] = projectiles[i].speed;
+		batch.rotation[i] = transforms[i].rotation;
+		batch.hit[i] = projectiles[i].hit;
+	}
+}
+
+static void CopyFromBatch(const HomingBatch& batch, std::vector<Transform>& transforms, std::vector<Projectile>& projectiles)
+{
+	for (size_t i=0; i < transforms.size(); ++i) {
+		transforms[i].pos = Vector2f(batch.x[i], batch.y[i]);
+		transforms[i].rotation = batch.rotation[i];
+		projectiles[i].hit = batch.hit[i] != 0;
+	}
+}
+
+static KernelBenchResult RunHoming(const KernelBenchSettings& settings, size_t count, std::ostream& errors)
+{
+	KernelBenchResult result;
+	result.kernel = "homing";
+	result.count = count;
+	result.failures = 0;
+
+	// some projectiles are at their target already, a few hit it in the last update
+	std::vector<Transform> transforms(count);
+	std::vector<Projectile> projectiles(count);
+	for (size_t i=0; i < count; ++i) {
+		Projectile& p = projectiles[i];
+		transforms[i].pos = RandomPosition();
+		if (Randomizer::Random(0, 19) == 0)
+			p.targetPosition = transforms[i].pos + Vector2f(Randomizer::Random(-8.0f, 8.0f), Randomizer::Random(-8.0f, 8.0f));
+		else
+			p.targetPosition = RandomPosition();
+		p.speed = Randomizer::Random(100.0f, 400.0f);
+		p.hit = Randomizer::Random(0, 99) == 0;
+	}
+
+	std::vector<Transform> objectTransforms(transforms), batchTransforms(transforms);
+	std::vector<Projectile> objectProjectiles(projectiles), batchProjectiles(projectiles);
+	HomingBatch scalar, simd;
+
+	Legacy::MoveProjectiles(objectTransforms, objectProjectiles, SIM_TICK);
+	CopyToBatch(transforms, projectiles, scalar);
+	HomeProjectilesScalar(scalar, SIM_TICK);
+	CopyToBatch(transforms, projectiles, simd);
+	HomeProjectiles(simd, SIM_TICK);
+	CopyFromBatch(simd, batchTransforms, batchProjectiles);
+
+	for (size_t i=0; i < count; ++i) {
+		const Transform& t = objectTransforms[i];
+		const bool same = batchTransforms[i].pos == t.pos && batchProjectiles[i].hit == objectProjectiles[i].hit
+			&& std::abs(batchTransforms[i].rotation - t.rotation) <= MAX_ROTATION_ERROR
+			&& scalar.x[i] == simd.x[i] && scalar.y[i] == simd.y[i] && scalar.rotation[i] == simd.rotation[i] && scalar.hit[i] == simd.hit[i];
+		if (same)
+			continue;
+
+		if (result.failures++ < MAX_REPORTED) {
+			errors << "homing of " << count << " projectiles: projectile " << i << " at " << batchTransforms[i].pos.x << ", " << batchTransforms[i].pos.y
+			       << " turned " << batchTransforms[i].rotation << (batchProjectiles[i].hit ? " hit" : "") << ", expected " << t.pos.x << ", " << t.pos.y
+			       << " turned " << t.rotation << (objectProjectiles[i].hit ? " hit" : "") << "\n";
+		}
+	}
+
+	// every update starts from the same positions, so the projectiles do not all reach their target
+	uint64_t objectTime = 0, scalarTime = 0, simdTime = 0, copyTime = 0;
+	for (size_t r=0; r < settings.repeats; ++r) {
+		objectTransforms = transforms;
+		objectProjectiles = projectiles;
+		uint64_t start = Profiler::GetTime();
+		Legacy::MoveProjectiles(objectTransforms, objectProjectiles, SIM_TICK);
+		objectTime += Profiler::GetTime() - start;
+
+		CopyToBatch(transforms, projectiles, scalar);
+		start = Profiler::GetTime();
+		HomeProjectilesScalar(scalar, SIM_TICK);
+		scalarTime += Profiler::GetTime() - start;
+
+		start = Profiler::GetTime();
+		CopyToBatch(transforms, projectiles, simd);
+		copyTime += Profiler::GetTime() - start;
+
+		start = Profiler::GetTime();
+		HomeProjectiles(simd, SIM_TICK);
+		simdTime += Profiler::GetTime() - start;
+
+		start = Profiler::GetTime();
+		CopyFromBatch(simd, batchTransforms, batchProjectiles);
+		copyTime += Profiler::GetTime() - start;
+	}
+
+	const double updates = static_cast<double>(settings.repeats);
+	result.objectTime = objectTime / updates;
+	result.scalarTime = scalarTime / updates;
+	result.simdTime = simdTime / updates;
+	result.copyTime = copyTime / updates;
+	return result;
+}
+
+static KernelBenchResult RunRange(const KernelBenchSettings& settings, size_t count, std::ostream& errors)
+{
+	KernelBenchResult result;
+	result.kernel = "range";
+	result.count = count;
+	result.failures = 0;
+	result.copyTime = 0;
+
+	std::vector<Legacy::Item> items(count);
+	std::vector<float> x(count), y(count);
+	for (size_t i=0; i < count; ++i) {
+		items[i].pos = RandomPosition();
+		items[i].entry = static_cast<uint32_t>(i);
+		x[i] = items[i].pos.x;
+		y[i] = items[i].pos.y;
+	}
+
+	std::vector<Vector2f> positions(settings.queries);
+	std::vector<float> rangesSq(settings.queries);
+	for (size_t q=0; q < settings.queries; ++q) {
+		positions[q] = RandomPosition();
+		const float range = Randomizer::Random(MIN_RANGE, MAX_RANGE);
+		rangesSq[q] = range * range;
+	}
+
+	std::vector<uint32_t> objectFound(count + 1), scalarFound(count + 1), simdFound(count + 1);
+	for (size_t q=0; q < settings.queries; ++q) {
+		const size_t n = Legacy::SelectInRange(items, positions[q], rangesSq[q], &objectFound[0]);
+		const size_t numScalar = SelectInRangeScalar(&x[0], &y[0], count, positions[q], rangesSq[q], &scalarFound[0]);
+		const size_t numSimd = SelectInRange(&x[0], &y[0], count, positions[q], rangesSq[q], &simdFound[0]);
+		if (numScalar == n && numSimd == n && std::equal(objectFound.begin(), objectFound.begin() + n, scalarFound.begin())
+			&& std::equal(objectFound.begin(), objectFound.begin() + n, simdFound.begin()))
+			continue;
+
+		if (result.failures++ < MAX_REPORTED) {
+			errors << "range test of " << count << " enemies: query " << q << " found " << numScalar << " (scalar) and "
+			       << numSimd << " (SIMD) enemies, expected " << n << "\n";
+		}
+	}
+
+	// the number of enemies found keeps the loops from being optimized away
+	uint64_t objectTime = 0, scalarTime = 0, simdTime = 0;
+	size_t objectTotal = 0, scalarTotal = 0, simdTotal = 0;
+	for (size_t r=0; r < settings.repeats; ++r) {
+		uint64_t start = Profiler::GetTime();
+		for (size_t q=0; q < settings.queries; ++q)
+			objectTotal += Legacy::SelectInRange(items, positions[q], rangesSq[q], &objectFound[0]);
+		objectTime += Profiler::GetTime() - start;
+
+		start = Profiler::GetTime();
+		for (size_t q=0; q < settings.queries; ++q)
+			scalarTotal += SelectInRangeScalar(&x[0], &y[0], count, positions[q], rangesSq[q], &scalarFound[0]);
+		scalarTime += Profiler::GetTime() - start;
+
+		start = Profiler::GetTime();
+		for (size_t q=0; q < settings.queries; ++q)
+			simdTotal += SelectInRange(&x[0], &y[0], count, positions[q], rangesSq[q], &simdFound[0]);
+		simdTime += Profiler::GetTime() - start;
+	}
+	if (scalarTotal != objectTotal || simdTotal != objectTotal) {
+		errors << "range test of " << count << " enemies: found " << scalarTotal << " (scalar) and " << simdTotal
+		       << " (SIMD) enemies in the timed queries, expected " << objectTotal << "\n";
+		result.failures++;
+	}
+
+	const double queries = static_cast<double>(settings.repeats * std::max<size_t>(settings.queries, 1));
+	result.objectTime = objectTime / queries;
+	result.scalarTime = scalarTime / queries;
+	result.simdTime = simdTime / queries;
+	return result;
+}
+
+std::vector<KernelBenchResult> RunKernelBench(const KernelBenchSettings& settings, std::ostream& errors)
+{
+	Randomizer::SetSeed(settings.seed);
+
+	std::vector<KernelBenchResult> results;
+	for (size_t i=0; i < sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]); ++i)
+		results.push_back(RunHoming(settings, BATCH_SIZES[i], errors));
+	for (size_t i=0; i < sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]); ++i)
+		results.push_back(RunRange(settings, BATCH_SIZES[i], errors));
+	return results;
+}
+
+js::mObject KernelBenchToJson(const KernelBenchSettings& settings, const std::vector<KernelBenchResult>& results)
+{
+	js::mArray batches;
+	for (auto& result: results) {
+		js::mObject obj;
+		obj["kernel"] = result.kernel;
+		obj["count"] = static_cast<boost::int64_t>(result.count);
+		obj["failures"] = static_cast<boost::int64_t>(result.failures);
+		obj["object-ns"] = result.objectTime;
+		obj["scalar-ns"] = result.scalarTime;
+		obj["simd-ns"] = result.simdTime;
+		obj["copy-ns"] = result.copyTime;
+		batches.push_back(obj);
+	}
+
+	js::mObject rootObj;
+	rootObj["version"] = 1;
+	rootObj["seed"] = static_cast<boost::int64_t>(settings.seed);
+	rootObj["repeats"] = static_cast<boost::int64_t>(settings.repeats);
+	rootObj["queries"] = static_cast<boost::int64_t>(settings.queries);
+	rootObj["kernel-set"] = GetKernelSet();
+	rootObj["batches"] = batches;
+	return rootObj;
+}
+
+void PrintKernelBenchResult(std::ostream& out, const KernelBenchResult& result)
+{
+	const bool homing = result.kernel == "homing";
+	out << result.kernel << ": " << result.count << (homing ? " projectiles, " : " enemies, ") << result.failures << " failures, "
+	    << (homing ? "ns per update\n" : "ns per query\n")
+	    << std::fixed << std::setprecision(0)
+	    << "  per object  " << std::setw(10) << result.objectTime << "\n"
+	    << "  scalar      " << std::setw(10) << result.scalarTime;
+	if (result.scalarTime > 0)
+		out << "  (" << std::setprecision(1) << result.objectTime / result.scalarTime << "x)" << std::setprecision(0);
+	out << "\n"
+	    << "  " << std::left << std::setw(12) << GetKernelSet() << std::right << std::setw(10) << result.simdTime;
+	if (result.simdTime > 0)
+		out << "  (" << std::setprecision(1) << result.objectTime / result.simdTime << "x)" << std::setprecision(0);
+	out << "\n";
+	if (homing) {
+		out << "  copies      " << std::setw(10) << result.copyTime;
+		if (result.simdTime + result.copyTime > 0)
+			out << "  (" << std::setprecision(1) << result.objectTime / (result.simdTime + result.copyTime) << "x with the kernel)";
+		out << "\n";
+	}
+	out.unsetf(std::ios_base::floatfield);
+}
@@ -0,0 +1,42 @@
+#ifndef KERNEL_BENCH_H
+#define KERNEL_BENCH_H
+
+#include "json_spirit/json_spirit.h"
+
+// Checks the batch kernels against the per-object code they replaced and times them.
+// Homing moves random projectiles like MoveProjectiles did on the components, the range
+// test looks for the enemies around random positions like the grid of the EnemyIndex
+// did per item. The kernels have to give the same positions, hits and indices, the
+// rotation may differ by the error of the acos approximation.
+struct KernelBenchSettings
+{
+	unsigned int seed;
+	size_t repeats;   // every batch is timed this many times
+	size_t queries;   // range queries per batch of enemies
+
+	KernelBenchSettings()
+	: seed(0), repeats(200), queries(100)
+	{ }
+};
+
+struct KernelBenchResult
+{
+	std::string kernel;  // "homing" or "range"
+	size_t count;        // projectiles or enemies in the batch
+	size_t failures;     // objects with other results than the per-object code
+
+	// nanoseconds per batch update or range query
+	double objectTime;   // the per-object code
+	double scalarTime;   // the kernel without SIMD
+	double simdTime;     // the kernel as built
+	double copyTime;     // copying the components into the batch and back, only homing
+};
+
+// Every failure is described on errors
+std::vector<KernelBenchResult> RunKernelBench(const KernelBenchSettings& settings, std::ostream& errors);
+
+json_spirit::mObject KernelBenchToJson(const KernelBenchSettings& settings, const std::vector<KernelBenchResult>& results);
+
+void PrintKernelBenchResult(std::ostream& out, const KernelBenchResult& result);
+
+#endif //KERNEL_BENCH_H
@@ -0,0 +1,484 @@
+#include "pch.h"
+#include "PathBench.h"
+#include "GridAStar.h"
+#include "HierarchicalPath.h"
+#include "Generator.h"
+#include "FlowField.h"
+#include "Map.h"
+#include "DataPaths.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <iomanip>
+
+namespace js = json_spirit;
+namespace fs = boost::filesystem;
+
+// the legacy A* searches its lists linearly, on bigger maps it would take minutes
+static const size_t LEGACY_MAX_BLOCKS = 4000;
+
+// The A* of Enemy::FindPath before the flow fields, kept as the reference for the
+// timings. It only got the cleanup on failure, which leaked all nodes.
+namespace Legacy
+{
+	struct Node
+	{
+		size_t x, y;
+		float g, f;
+
+		Node *parent;
+
+		Node(size_t x, size_t y)
+		: x(x), y(y), g(.0f), f(.0f), parent(0)
+		{ }
+
+		bool operator == (const Node& rhs) const
+		{
+			return x == rhs.x && y == rhs.y;
+		}
+
+		bool operator != (const Node& rhs) const
+		{
+			return !(*this == rhs);
+		}
+
+		float CalcH(const Node& goal)
+		{
+			return 1.0f * (std::abs(static_cast<int>(x - goal.x)) + std::abs(static_cast<int>(y - goal.y)));
+		}
+	};
+
+	static bool NodePtrComp(const Node* lhs, const Node *rhs)
+	{
+		return lhs->f > rhs->f;
+	}
+
+	struct NodeEqPos
+	{
+		const Node& ref;
+
+		explicit NodeEqPos(const Node& r)
+		: ref(r)
+		{ }
+
+		bool operator()(const Node* nptr) const
+		{
+			return (*nptr) == ref;
+		}
+	};
+
+	static bool ValidNeighbor(int x, int y, const Map& map)
+	{
+		return (x >= 0) && (y >= 0)
+			&& (static_cast<size_t>(x) < map.GetWidthBlocks()) && (static_cast<size_t>(y) < map.GetHeightBlocks())
+			&& map.GetPathGrid().IsWalkable(x, y);
+	}
+
+	static void FillNeighbors(std::vector<Vector2i>& c, const Map& map, int x, int y)
+	{
+		if (ValidNeighbor(x-1, y, map))
+			c.push_back(Vector2i(x-1, y));
+		if (ValidNeighbor(x+1, y, map))
+			c.push_back(Vector2i(x+1, y));
+		if (ValidNeighbor(x, y-1, map))
+			c.push_back(Vector2i(x, y-1));
+		if (ValidNeighbor(x, y+1, map))
+			c.push_back(Vector2i(x, y+1));
+	}
+
+	static bool FindPath(const Map& map, const Vector2i& startBlk, const Vector2i& goalBlk, std::vector<Vector2i>& path)
+	{
+		path.clear();
+
+		std::vector<Node*> allNodes;
+		std::vector<Node*> open, closed;
+
+		Node *goal = new Node(goalBlk.x, goalBlk.y);
+		allNodes.push_back(goal);
+
+		Node *start = new Node(startBlk.x, startBlk.y);
+		allNodes.push_back(start);
+
+		open.push_back(start);
+		boost::push_heap(open, NodePtrComp);
+
+		while (!open.empty() && *open.front() != *goal) {
+			Node *cur = open.front();
+
+			boost::pop_heap(open, NodePtrComp);
+			open.pop_back();
+
+			std::vector<Vector2i> neighbors;
+			FillNeighbors(neighbors, map, cur->x, cur->y);
+
+			for (auto it = neighbors.begin(); it != neighbors.end(); ++it) {
+				Node *suc = new Node(it->x, it->y);
+				allNodes.push_back(suc);
+
+				float newg = cur->g + 1.f;
+
+				auto oit = boost::find_if(open, NodeEqPos(*suc));
+				auto cit = boost::find_if(closed, NodeEqPos(*suc));
+
+				if (oit != open.end()) {
+					if ((*oit)->g <= newg)
+						continue;
+				}
+				if (cit != closed.end()) {
+					if ((*cit)->g <= newg)
+						continue;
+				}
+
+				suc->parent = cur;
+				suc->g = newg;
+				suc->f = suc->g + suc->CalcH(*goal);
+
+				if (cit != closed.end()) {
+					closed.erase(cit);
+				}
+				if (oit != open.end()) {
+					open.erase(oit);
+					boost::make_heap(open, NodePtrComp);
+				}
+
+				open.push_back(suc);
+				boost::push_heap(open, NodePtrComp);
+			}
+
+			closed.push_back(cur);
+		}
+
+		bool found = !open.empty();
+		for (Node *n = found ? open.front() : nullptr; n; n = n->parent)
+			path.push_back(Vector2i(n->x, n->y));
+		boost::reverse(path);
+
+		for (size_t i=0; i < allNodes.size(); ++i)
+			delete allNodes[i];
+		return found;
+	}
+}
+
+static std::vector<std::string> FindMaps()
+{
+	fs::path root = GetMapPath("");
+
+	std::vector<std::string> maps;
+	for (fs::recursive_directory_iterator it(root), end; it != end; ++it) {
+		if (it->path().filename() != MapDefinitionFile)
+			continue;
+
+		// the name is the directory relative to data/maps
+		std::string name = it->path().parent_path().generic_string().substr(root.generic_string().size());
+		boost::trim_left_if(name, boost::is_any_of("/"));
+		maps.push_back(name);
+	}
+	boost::sort(maps);
+	return maps;
+}
+
+static std::string ToString(const Vector2i& blk)
+{
+	return "(" + boost::lexical_cast<std::string>(blk.x) + ", " + boost::lexical_cast<std::string>(blk.y) + ")";
+}
+
+// Compare a found path against the distances of the flow field to the goal, returns an empty string if it is fine.
+// Unless shortest is set the path may be longer than needed.
+static std::string CheckPath(const Map& map, const FlowField& field, const Vector2i& start, bool found, const std::vector<Vector2i>& path, bool shortest = true)
+{
+	const NavGrid& grid = map.GetPathGrid();
+
+	// the start may be beside the path, then the way leads over the closest walkable neighbor
+	uint32_t expected = field.GetDistance(start);
+	if (expected == FlowField::UNREACHABLE) {
+		Vector2i next = field.GetNext(start);
+		if (next != start)
+			expected = field.GetDistance(next) + 1;
+	}
+
+	if (expected == FlowField::UNREACHABLE)
+		return found ? "found a path to an unreachable goal" : "";
+	if (!found)
+		return "no path found, expected " + boost::lexical_cast<std::string>(expected) + " steps";
+	if (path.size() < expected + 1 || (shortest && path.size() != expected + 1))
+		return boost::lexical_cast<std::string>(path.size() - 1) + " steps, expected " + boost::lexical_cast<std::string>(expected);
+	if (path.front() != start || path.back() != field.GetTarget())
+		return "the path does not connect start and goal";
+
+	for (size_t i=1; i < path.size(); ++i) {
+		const Vector2i& a = path[i-1];
+		const Vector2i& b = path[i];
+		if (std::abs(a.x - b.x) + std::abs(a.y - b.y) != 1)
+			return "jump from " + ToString(a) + " to " + ToString(b);
+		if (!grid.IsWalkable(b.x, b.y))
+			return "leaves the path at " + ToString(b);
+	}
+	return "";
+}
+
+// Compare the repaired field against a freshly computed one, returns an empty string if they match
+static std::string CheckField(const FlowField& repaired, const FlowField& computed, size_t width, size_t height)
+{
+	for (int y=0; y < static_cast<int>(height); ++y) {
+		for (int x=0; x < static_cast<int>(width); ++x) {
+			Vector2i blk(x, y);
+			uint32_t d = computed.GetDistance(blk);
+			if (repaired.GetDistance(blk) != d)
+				return "wrong distance at " + ToString(blk);
+
+			// the way may differ, but has to lead one step closer
+			if (d != FlowField::UNREACHABLE && d != 0 && computed.GetDistance(repaired.GetNext(blk)) != d - 1)
+				return "wrong direction at " + ToString(blk);
+		}
+	}
+	return "";
+}
+
+// Long snaking paths over large maps, the flat searches have to walk all of it
+static void GenerateLargeMaps(const PathBenchSettings& settings)
+{
+	for (size_t i=0; i < settings.largeMaps; ++i) {
+		GeneratorSettings gen;
+		gen.seed = settings.seed;
+		gen.width = 128 << i;
+		gen.height = 96 << i;
+		gen.name = "paths-" + boost::lexical_cast<std::string>(gen.width) + "x" + boost::lexical_cast<std::string>(gen.height);
+		gen.blockSize = 4;  // keeps the background small
+		gen.pathLength = gen.width * gen.height;
+		gen.spawns = 1;
+		gen.towerPlaces = 0;
+		gen.firePlaces = 0;
+		GenerateMap(gen);
+	}
+}
+
+std::vector<PathBenchResult> RunPathBench(const PathBenchSettings& settings, std::ostream& errors)
+{
+	GenerateLargeMaps(settings);
+	Randomizer::SetSeed(settings.seed);
+
+	std::vector<PathBenchResult> results;
+	for (auto& name: FindMaps()) {
+		Map map;
+		map.LoadFromFile(name);
+
+		const NavGrid& grid = map.GetPathGrid();
+		const int width = static_cast<int>(map.GetWidthBlocks());
+		const int height = static_cast<int>(map.GetHeightBlocks());
+
+		std::vector<Vector2i> walkable;
+		for (int y=0; y < height; ++y) {
+			for (int x=0; x < width; ++x) {
+				if (grid.IsWalkable(x, y))
+					walkable.push_back(Vector2i(x, y));
+			}
+		}
+		if (walkable.empty())
+			continue;
+
+		// from every spawn to the target, then between random walkable blocks
+		std::vector<std::pair<Vector2i, Vector2i>> pairs;
+		Vector2i target = map.PositionToBlock(map.GetDefaultTarget());
+		for (size_t i=0; i < map.GetNumSpawns(); ++i)
+			pairs.push_back(std::make_pair(map.PositionToBlock(map.GetSpawnPosition(i)), target));
+		for (size_t i=0; i < settings.randomPairs; ++i) {
+			const Vector2i& a = walkable[Randomizer::Random(0, static_cast<int>(walkable.size()) - 1)];
+			const Vector2i& b = walkable[Randomizer::Random(0, static_cast<int>(walkable.size()) - 1)];
+			pairs.push_back(std::make_pair(a, b));
+		}
+
+		PathBenchResult result;
+		result.map = name;
+		result.blocks = walkable.size();
+		result.searches = pairs.size();
+		result.failures = 0;
+		result.avgExpanded = 0;
+		result.hierarchyExpanded = 0;
+		result.hierarchyExcess = 0;
+
+		if (grid.CountWalkable() != walkable.size()) {
+			errors << name << ": NavGrid counts " << grid.CountWalkable() << " walkable blocks, expected " << walkable.size() << "\n";
+			result.failures++;
+		}
+
+		GridAStar astar;
+		astar.SetGrid(grid);
+
+		HierarchicalPath hierarchy;
+		uint64_t buildTime = Profiler::GetTime();
+		for (size_t r=0; r < settings.repeats; ++r)
+			hierarchy.Build(grid);
+		buildTime = Profiler::GetTime() - buildTime;
+		result.hierarchyNodes = hierarchy.GetNumNodes();
+
+		const bool runLegacy = walkable.size() <= LEGACY_MAX_BLOCKS;
+		uint64_t legacyTime = 0, gridTime = 0, hierarchyTime = 0, fieldTime = 0;
+		size_t optimalSteps = 0, hierarchySteps = 0;
+		std::vector<Vector2i> legacyPath, gridPath, hierarchyPath;
+
+		for (auto& p: pairs) {
+			FlowField field;
+			uint64_t start = Profiler::GetTime();
+			for (size_t r=0; r < settings.repeats; ++r)
+				field.Compute(grid, p.second);
+			fieldTime += Profiler::GetTime() - start;
+
+			bool legacyFound = false, gridFound = false, hierarchyFound = false;
+
+			if (runLegacy) {
+				start = Profiler::GetTime();
+				for (size_t r=0; r < settings.repeats; ++r)
+					legacyFound = Legacy::FindPath(map, p.first, p.second, legacyPath);
+				legacyTime += Profiler::GetTime() - start;
+			}
+
+			start = Profiler::GetTime();
+			for (size_t r=0; r < settings.repeats; ++r)
+				gridFound = astar.FindPath(p.first, p.second, gridPath);
+			gridTime += Profiler::GetTime() - start;
+
+			start = Profiler::GetTime();
+			for (size_t r=0; r < settings.repeats; ++r)
+				hierarchyFound = hierarchy.FindPath(p.first, p.second, hierarchyPath);
+			hierarchyTime += Profiler::GetTime() - start;
+
+			result.avgExpanded += astar.GetNumExpanded();
+			result.hierarchyExpanded += hierarchy.GetNumExpanded();
+
+			std::string gridError = CheckPath(map, field, p.first, gridFound, gridPath);
+			std::string hierarchyError = CheckPath(map, field, p.first, hierarchyFound, hierarchyPath, false);
+			std::string legacyError = runLegacy ? CheckPath(map, field, p.first, legacyFound, legacyPath) : "";
+			if (!gridError.empty()) {
+				errors << name << ": GridAStar " << ToString(p.first) << " -> " << ToString(p.second) << ": " << gridError << "\n";
+				result.failures++;
+			}
+			if (!hierarchyError.empty()) {
+				errors << name << ": HierarchicalPath " << ToString(p.first) << " -> " << ToString(p.second) << ": " << hierarchyError << "\n";
+				result.failures++;
+			}
+			else if (gridFound) {
+				optimalSteps += gridPath.size() - 1;
+				hierarchySteps += hierarchyPath.size() - 1;
+			}
+			if (!legacyError.empty()) {
+				// only reported, the old implementation is the baseline and not under test
+				errors << name << ": legacy A* " << ToString(p.first) << " -> " << ToString(p.second) << ": " << legacyError << "\n";
+			}
+		}
+
+		// block random path blocks and open them again in random order, like towers in maze mode
+		NavGrid mazeGrid = grid;
+		std::vector<Vector2i> blocked;
+		FlowField repaired, computed;
+		repaired.Compute(mazeGrid, target);
+
+		uint64_t repairTime = 0, recomputeTime = 0;
+		for (size_t i=0; i < settings.mazeChanges; ++i) {
+			bool open = !blocked.empty() && Randomizer::Random(0, 2) == 0;
+
+			Vector2i blk;
+			if (open) {
+				size_t idx = Randomizer::Random(0, static_cast<int>(blocked.size()) - 1);
+				blk = blocked[idx];
+				blocked.erase(blocked.begin() + idx);
+			}
+			else {
+				blk = walkable[Randomizer::Random(0, static_cast<int>(walkable.size()) - 1)];
+				if (!mazeGrid.IsWalkable(blk.x, blk.y) || blk == target)
+					continue;
+				blocked.push_back(blk);
+			}
+			mazeGrid.SetWalkable(blk, open);
+
+			uint64_t start = Profiler::GetTime();
+			if (open)
+				repaired.Unblock(mazeGrid, blk);
+			else
+				repaired.Block(mazeGrid, blk);
+			repairTime += Profiler::GetTime() - start;
+
+			start = Profiler::GetTime();
+			computed.Compute(mazeGrid, target);
+			recomputeTime += Profiler::GetTime() - start;
+
+			std::string error = CheckField(repaired, computed, width, height);
+			if (!error.empty()) {
+				errors << name << ": flow field after " << (open ? "opening " : "blocking ") << ToString(blk) << ": " << error << "\n";
+				result.failures++;
+				repaired = computed;
+			}
+		}
+
+		const double searches = static_cast<double>(pairs.size() * settings.repeats);
+		result.avgExpanded /= pairs.size();
+		result.hierarchyExpanded /= pairs.size();
+		result.hierarchyExcess = optimalSteps ? 100.0 * (hierarchySteps - optimalSteps) / optimalSteps : 0;
+		result.legacyTime = legacyTime / searches;
+		result.gridTime = gridTime / searches;
+		result.hierarchyTime = hierarchyTime / searches;
+		result.flowFieldTime = fieldTime / searches;
+		result.buildTime = buildTime / static_cast<double>(settings.repeats);
+		result.repairTime = settings.mazeChanges ? repairTime / static_cast<double>(settings.mazeChanges) : 0;
+		result.recomputeTime = settings.mazeChanges ? recomputeTime / static_cast<double>(settings.mazeChanges) : 0;
+		results.push_back(result);
+	}
+
+	if (results.empty())
+		throw GameError() << ErrorInfo::Desc("No maps found") << boost::errinfo_file_name(GetMapPath("").string());
+	return results;
+}
+
+js::mObject PathBenchToJson(const PathBenchSettings& settings, const std::vector<PathBenchResult>& results)
+{
+	js::mArray maps;
+	for (auto& result: results) {
+		js::mObject obj;
+		obj["map"] = result.map;
+		obj["blocks"] = static_cast<boost::int64_t>(result.blocks);
+		obj["searches"] = static_cast<boost::int64_t>(result.searches);
+		obj["failures"] = static_cast<boost::int64_t>(result.failures);
+		obj["expanded-per-search"] = result.avgExpanded;
+		obj["legacy-ns"] = result.legacyTime;
+		obj["grid-astar-ns"] = result.gridTime;
+		obj["hierarchical-ns"] = result.hierarchyTime;
+		obj["hierarchical-expanded-per-search"] = result.hierarchyExpanded;
+		obj["hierarchical-nodes"] = static_cast<boost::int64_t>(result.hierarchyNodes);
+		obj["hierarchical-excess-pct"] = result.hierarchyExcess;
+		obj["hierarchical-build-ns"] = result.buildTime;
+		obj["flow-field-ns"] = result.flowFieldTime;
+		obj["repair-ns"] = result.repairTime;
+		obj["recompute-ns"] = result.recomputeTime;
+		maps.push_back(obj);
+	}
+
+	js::mObject rootObj;
+	rootObj["version"] = 2;
+	rootObj["seed"] = static_cast<boost::int64_t>(settings.seed);
+	rootObj["repeats"] = static_cast<boost::int64_t>(settings.repeats);
+	rootObj["maps"] = maps;
+	return rootObj;
+}
+
+void PrintPathBenchResult(std::ostream& out, const PathBenchResult& result)
+{
+	out << result.map << ": " << result.blocks << " blocks, " << result.searches << " searches, " << result.failures << " failures, "
+	    << std::fixed << std::setprecision(1) << result.avgExpanded << " nodes expanded per search\n"
+	    << std::setprecision(0);
+	if (result.legacyTime > 0)
+		out << "  legacy A*   " << std::setw(10) << result.legacyTime << " ns\n";
+	else
+		out << "  legacy A*      skipped\n";
+	out << "  GridAStar   " << std::setw(10) << result.gridTime << " ns";
+	if (result.gridTime > 0 && result.legacyTime > 0)
+		out << "  (" << std::setprecision(1) << result.legacyTime / result.gridTime << "x)" << std::setprecision(0);
+	out << "\n"
+	    << "  HPA*        " << std::setw(10) << result.hierarchyTime << " ns";
+	if (result.hierarchyTime > 0)
+		out << "  (" << std::setprecision(1) << result.gridTime / result.hierarchyTime << "x of GridAStar)";
+	out << ", " << std::setprecision(1) << result.hierarchyExcess << "% longer, " << result.hierarchyExpanded << " of "
+	    << result.hierarchyNodes << " nodes expanded, built in " << std::setprecision(0) << result.buildTime << " ns\n"
+	    << "  flow field  " << std::setw(10) << result.flowFieldTime << " ns\n"
+	    << "  repair      " << std::setw(10) << result.repairTime << " ns per change, "
+	    << result.recomputeTime << " ns to compute it again\n";
+	out.unsetf(std::ios_base::floatfield);
+}
@@ -0,0 +1,55 @@
+#ifndef PATH_BENCH_H
+#define PATH_BENCH_H
+
+#include "json_spirit/json_spirit.h"
+
+// Checks GridAStar against the breadth first distances of the flow fields and times it
+// against the A* the enemies used before the flow fields, on every map in data/maps.
+// HierarchicalPath is timed as well, its paths only have to be valid and get compared
+// by length. Searched are the ways from all spawns to the target and between random
+// blocks. Then random path blocks get blocked and opened again like towers in maze
+// mode, the repaired flow field is compared to a full computation.
+struct PathBenchSettings
+{
+	unsigned int seed;
+	size_t randomPairs;  // random start and goal blocks per map
+	size_t repeats;      // every search is timed this many times
+	size_t mazeChanges;  // blocks blocked or opened per map
+	size_t largeMaps;    // maps generated before, the first 128x96 blocks, each one twice as wide and high
+
+	PathBenchSettings()
+	: seed(0), randomPairs(200), repeats(20), mazeChanges(200), largeMaps(2)
+	{ }
+};
+
+struct PathBenchResult
+{
+	std::string map;
+	size_t blocks;           // walkable blocks
+	size_t searches;
+	size_t failures;         // wrong or missing paths
+	double avgExpanded;      // nodes expanded by GridAStar per search
+	double hierarchyExpanded;  // abstract nodes expanded by HierarchicalPath per search
+	size_t hierarchyNodes;
+	double hierarchyExcess;  // how much longer the paths of HierarchicalPath are, in percent
+
+	// nanoseconds per search
+	double legacyTime;       // 0 on large maps, where it would take minutes
+	double gridTime;
+	double hierarchyTime;
+	double flowFieldTime;    // computing the flow field to the goal, for comparison
+	double buildTime;        // building the clusters of HierarchicalPath once
+
+	// nanoseconds per blocked or opened block
+	double repairTime;
+	double recomputeTime;    // computing the whole field instead
+};
+
+// Every failure is described on errors
+std::vector<PathBenchResult> RunPathBench(const PathBenchSettings& settings, std::ostream& errors);
+
+json_spirit::mObject PathBenchToJson(const PathBenchSettings& settings, const std::vector<PathBenchResult>& results);
+
+void PrintPathBenchResult(std::ostream& out, const PathBenchResult& result);
+
+#endif //PATH_BENCH_H
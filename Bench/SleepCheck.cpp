@@ -0,0 +1,63 @@
+#include "pch.h"
+#include "SleepCheck.h"
+#include "Components.h"
+#include "World.h"
+#include "Systems.h"
+#include "Simulation.h"
+
+// the cooldowns of the default theme are in between
+static const float MIN_COOLDOWN = 0.3f;
+static const float MAX_COOLDOWN = 3.0f;
+
+// ticks a tower stays awake or asleep at most
+static const int MAX_STRETCH = 500;
+
+// only the first wrong ticks are described
+static const size_t MAX_REPORTED = 5;
+
+size_t RunSleepCheck(const SleepCheckSettings& settings, std::ostream& errors)
+{
+	Randomizer::SetSeed(settings.seed);
+
+	// the same towers twice, only the ones in sleeping fall asleep
+	World awake, sleeping;
+	std::vector<Entity> awakeTowers(settings.towers), sleepingTowers(settings.towers);
+	std::vector<int> stretch(settings.towers);
+	for (size_t i=0; i < settings.towers; ++i) {
+		const float cooldown = Randomizer::Random(MIN_COOLDOWN, MAX_COOLDOWN);
+		awakeTowers[i] = awake.Create(Bit(CooldownId));
+		awake.Write<Cooldown>(awakeTowers[i]).cooldown = cooldown;
+		sleepingTowers[i] = sleeping.Create(Bit(CooldownId));
+		sleeping.Write<Cooldown>(sleepingTowers[i]).cooldown = cooldown;
+		stretch[i] = Randomizer::Random(0, MAX_STRETCH);
+	}
+
+	size_t failures = 0;
+	for (size_t tick=0; tick < settings.ticks; ++tick) {
+		// the TowerActivity puts the towers to sleep before the cooldowns are updated
+		for (size_t i=0; i < settings.towers; ++i) {
+			if (--stretch[i] > 0)
+				continue;
+			Cooldown& c = sleeping.Write<Cooldown>(sleepingTowers[i]);
+			c.asleep = !c.asleep;
+			stretch[i] = Randomizer::Random(1, MAX_STRETCH);
+		}
+
+		UpdateCooldowns(awake, SIM_TICK);
+		UpdateCooldowns(sleeping, SIM_TICK);
+
+		for (size_t i=0; i < settings.towers; ++i) {
+			const Cooldown& a = awake.Read<Cooldown>(awakeTowers[i]);
+			const Cooldown& s = sleeping.Read<Cooldown>(sleepingTowers[i]);
+			if (s.ready == (a.ready && !s.asleep))
+				continue;
+
+			if (failures++ < MAX_REPORTED) {
+				errors << "tower " << i << " with a cooldown of " << a.cooldown << "s " << (s.asleep ? "asleep" : "awake")
+				       << " in tick " << tick << ": " << (s.ready ? "attacks" : "does not attack") << ", the one always awake "
+				       << (a.ready ? "attacks" : "does not") << "\n";
+			}
+		}
+	}
+	return failures;
+}
@@ -0,0 +1,22 @@
+#ifndef SLEEP_CHECK_H
+#define SLEEP_CHECK_H
+
+// Checks that sleeping towers attack on the same ticks as towers that never sleep. The
+// same random cooldowns are counted down twice with UpdateCooldowns, one set of towers
+// stays awake, the other falls asleep and wakes up again after random stretches of
+// ticks. While awake, both have to be ready on the same ticks, asleep never.
+struct SleepCheckSettings
+{
+	unsigned int seed;
+	size_t towers;
+	size_t ticks;
+
+	SleepCheckSettings()
+	: seed(0), towers(200), ticks(6000)
+	{ }
+};
+
+// Returns the number of wrong ticks, the first ones are described on errors
+size_t RunSleepCheck(const SleepCheckSettings& settings, std::ostream& errors);
+
+#endif //SLEEP_CHECK_H
@@ -0,0 +1,422 @@
+#include "pch.h"
+#include "Benchmark.h"
+#include "Gate.h"
+#include "Generator.h"
+#include "PathBench.h"
+#include "KernelBench.h"
+#include "SleepCheck.h"
+#include "Simulation.h"
+#include "Replay.h"
+#include "ResourceManager.h"
+#include "GlobalStatus.h"
+#include "Theme.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "Error.h"
+
+#include <iostream>
+
+namespace js = json_spirit;
+
+// global resource manager variables
+ResourceManager<sf::Image> gImageManager;
+
+Theme gTheme;
+
+GlobalStatus gStatus;
+
+static void PrintUsage()
+{
+	std::cerr << "usage: DrachenBench [options]                run the benchmark scenarios\n"
+	          << "       DrachenBench --generate <name> [options]  generate a stress map and level\n"
+	          << "       DrachenBench --endless <level> [options]  raise the enemies until the frame budget is exceeded\n"
+	          << "       DrachenBench --gate [options]             compare the replay frame times against a baseline\n"
+	          << "       DrachenBench --record <level> [options]   record a replay of a bot playing the level\n"
+	          << "       DrachenBench --paths [options]            check and time the path searches on all maps\n"
+	          << "       DrachenBench --kernels [options]          check and time the batch kernels against the per-object code\n"
+	          << "       DrachenBench --sleep [options]            check that sleeping towers attack on the same ticks as awake ones\n"
+	          << "\n"
+	          << "benchmark options:\n"
+	          << "  --list              list all scenarios\n"
+	          << "  --scenario <name>   only run the given scenario, may be given multiple times\n"
+	          << "  --ticks <n>         number of measured ticks per scenario\n"
+	          << "  --no-window         skip the scenarios that need a window\n"
+	          << "\n"
+	          << "generator options:\n"
+	          << "  --seed <n>, --width <blocks>, --height <blocks>, --path-length <blocks>,\n"
+	          << "  --spawns <n>, --tower-places <n>, --fire-places <n>, --waves <n>,\n"
+	          << "  --first-wave <enemies>, --wave-growth <factor>\n"
+	          << "\n"
+	          << "endless options:\n"
+	          << "  --budget <ms>, --first-wave <enemies>, --wave-growth <factor>, --wave-ticks <n>\n"
+	          << "\n"
+	          << "gate options:\n"
+	          << "  --replay <file>     play the given replay instead of all in " << GetGateReplayPath().string() << ", may be given multiple times\n"
+	          << "  --baseline <file>   baseline to compare against (default gate-baseline.json)\n"
+	          << "  --update-baseline   write the results to the baseline instead of comparing\n"
+	          << "  --threshold <pct>   allowed increase of p50, p90 and p99 (default 10)\n"
+	          << "  --runs <n>          plays of every replay (default 3)\n"
+	          << "  --frame-ticks <n>   ticks per frame (default 4)\n"
+	          << "\n"
+	          << "record options:\n"
+	          << "  --seed <n>, the replay is written to the file given with --out\n"
+	          << "\n"
+	          << "paths options:\n"
+	          << "  --seed <n>, --pairs <n> random searches per map (default 200),\n"
+	          << "  --repeats <n> timed runs of every search (default 20),\n"
+	          << "  --changes <n> blocks blocked or opened on every map (default 200),\n"
+	          << "  --large-maps <n> large maps generated into data/maps/generated first (default 2)\n"
+	          << "\n"
+	          << "kernels options:\n"
+	          << "  --seed <n>, --repeats <n> timed runs of every batch (default 200),\n"
+	          << "  --queries <n> range queries per batch of enemies (default 100)\n"
+	          << "\n"
+	          << "sleep options:\n"
+	          << "  --seed <n>, --towers <n> (default 200), --ticks <n> (default 6000)\n"
+	          << "\n"
+	          << "  --out <file>        write the results as json to file instead of stdout\n"
+	          << "  --trace <file>      write all profiler zones to a Chrome trace file\n";
+}
+
+static void PrintError(boost::exception& ex)
+{
+	std::cerr << "Error";
+	if (std::string const* desc = boost::get_error_info<ErrorInfo::Desc>(ex))
+		std::cerr << ": " << *desc;
+	if (std::string const* note = boost::get_error_info<ErrorInfo::Note>(ex))
+		std::cerr << " (" << *note << ")";
+	if (std::string const* fileName = boost::get_error_info<boost::errinfo_file_name>(ex))
+		std::cerr << " in '" << *fileName << "'";
+	std::cerr << std::endl;
+}
+
+static void WriteResult(const js::mObject& rootObj, const std::string& outFile)
+{
+	if (outFile.empty()) {
+		js::write_formatted(rootObj, std::cout);
+		std::cout << std::endl;
+		return;
+	}
+
+	std::ofstream out(outFile);
+	if (!out.is_open())
+		throw GameError() << ErrorInfo::Desc("Failed to open file") << boost::errinfo_file_name(outFile);
+	js::write_formatted(rootObj, out);
+}
+
+static void RunScenarios(const std::set<std::string>& selected, size_t ticks, bool useWindow, const std::string& outFile)
+{
+	std::unique_ptr<RenderWindow> window;
+
+	js::mArray results;
+	for (auto& sc: GetDefaultScenarios()) {
+		if (!selected.empty() && !selected.count(sc.name))
+			continue;
+
+		if (sc.NeedsWindow()) {
+			if (!useWindow) {
+				std::cerr << sc.name << ": skipped, needs a window\n";
+				continue;
+			}
+			if (!window)
+				window.reset(new RenderWindow(sf::VideoMode(800, 600, 32), "Drachen Benchmark"));
+		}
+
+		Scenario scenario = sc;
+		if (ticks)
+			scenario.ticks = ticks;
+
+		ScenarioResult result = RunScenario(scenario, window.get());
+		PrintResult(std::cerr, result);
+		results.push_back(ResultToJson(result));
+	}
+
+	// memory held by all images loaded by the scenarios
+	js::mObject resources;
+	for (size_t i=0; i < ResourceUsage::NUM_CATEGORIES; ++i) {
+		auto category = static_cast<ResourceUsage::Category>(i);
+		resources[ResourceUsage::getCategoryName(category)] = static_cast<boost::int64_t>(gImageManager.getCategoryBytes(category));
+	}
+	resources["peak"] = static_cast<boost::int64_t>(gImageManager.getPeakBytes());
+	gImageManager.writeReport(std::cerr);
+
+	js::mObject rootObj;
+	rootObj["version"] = 1;
+	rootObj["tick-length"] = SIM_TICK;
+	rootObj["scenarios"] = results;
+	rootObj["resource-bytes"] = resources;
+	WriteResult(rootObj, outFile);
+}
+
+int main(int argc, char** argv)
+{
+	enum { Scenarios, Generate, Endless, Gate, Record, Paths, Kernels, Sleep } mode = Scenarios;
+
+	std::set<std::string> selected;
+	size_t ticks = 0;
+	std::string outFile, traceFile;
+	bool useWindow = true;
+	bool list = false;
+	bool updateBaseline = false;
+	std::string recordLevel;
+
+	GeneratorSettings gen;
+	EndlessSettings endless;
+	GateSettings gate;
+	PathBenchSettings paths;
+	KernelBenchSettings kernels;
+	SleepCheckSettings sleepCheck;
+
+	try {
+		for (int i=1; i < argc; ++i) {
+			std::string arg = argv[i];
+			const char* value = i + 1 < argc ? argv[i+1] : nullptr;
+
+			if (arg == "--list")
+				list = true;
+			else if (arg == "--no-window")
+				useWindow = false;
+			else if (arg == "--gate")
+				mode = Gate;
+			else if (arg == "--paths")
+				mode = Paths;
+			else if (arg == "--kernels")
+				mode = Kernels;
+			else if (arg == "--sleep")
+				mode = Sleep;
+			else if (arg == "--update-baseline")
+				updateBaseline = true;
+			else if (!value) {
+				PrintUsage();
+				return 1;
+			}
+			else {
+				++i;
+				if (arg == "--generate") {
+					mode = Generate;
+					gen.name = value;
+				}
+				else if (arg == "--endless") {
+					mode = Endless;
+					endless.level = value;
+				}
+				else if (arg == "--record") {
+					mode = Record;
+					recordLevel = value;
+				}
+				else if (arg == "--scenario")
+					selected.insert(value);
+				else if (arg == "--ticks")
+					ticks = boost::lexical_cast<size_t>(value);
+				else if (arg == "--out")
+					outFile = value;
+				else if (arg == "--trace")
+					traceFile = value;
+				else if (arg == "--seed")
+					gen.seed = paths.seed = kernels.seed = sleepCheck.seed = boost::lexical_cast<unsigned int>(value);
+				else if (arg == "--width")
+					gen.width = boost::lexical_cast<size_t>(value);
+				else if (arg == "--height")
+					gen.height = boost::lexical_cast<size_t>(value);
+				else if (arg == "--path-length")
+					gen.pathLength = boost::lexical_cast<size_t>(value);
+				else if (arg == "--spawns")
+					gen.spawns = boost::lexical_cast<size_t>(value);
+				else if (arg == "--tower-places")
+					gen.towerPlaces = boost::lexical_cast<size_t>(value);
+				else if (arg == "--fire-places")
+					gen.firePlaces = boost::lexical_cast<size_t>(value);
+				else if (arg == "--waves")
+					gen.waves = boost::lexical_cast<size_t>(value);
+				else if (arg == "--first-wave")
+					gen.firstWave = endless.firstWave = boost::lexical_cast<size_t>(value);
+				else if (arg == "--wave-growth")
+					gen.waveGrowth = endless.waveGrowth = boost::lexical_cast<float>(value);
+				else if (arg == "--budget")
+					endless.budget = boost::lexical_cast<double>(value);
+				else if (arg == "--wave-ticks")
+					endless.waveTicks = boost::lexical_cast<size_t>(value);
+				else if (arg == "--replay")
+					gate.replays.push_back(value);
+				else if (arg == "--baseline")
+					gate.baseline = value;
+				else if (arg == "--threshold")
+					gate.threshold = boost::lexical_cast<double>(value);
+				else if (arg == "--runs")
+					gate.runs = boost::lexical_cast<size_t>(value);
+				else if (arg == "--frame-ticks")
+					gate.ticksPerFrame = boost::lexical_cast<size_t>(value);
+				else if (arg == "--pairs")
+					paths.randomPairs = boost::lexical_cast<size_t>(value);
+				else if (arg == "--repeats")
+					paths.repeats = kernels.repeats = boost::lexical_cast<size_t>(value);
+				else if (arg == "--changes")
+					paths.mazeChanges = boost::lexical_cast<size_t>(value);
+				else if (arg == "--large-maps")
+					paths.largeMaps = boost::lexical_cast<size_t>(value);
+				else if (arg == "--queries")
+					kernels.queries = boost::lexical_cast<size_t>(value);
+				else if (arg == "--towers")
+					sleepCheck.towers = boost::lexical_cast<size_t>(value);
+				else {
+					PrintUsage();
+					return 1;
+				}
+			}
+		}
+	}
+	catch (boost::bad_lexical_cast&) {
+		PrintUsage();
+		return 1;
+	}
+
+	if (list) {
+		for (auto& sc: GetDefaultScenarios())
+			std::cout << sc.name << (sc.NeedsWindow() ? " (window)" : "") << "\n";
+		return 0;
+	}
+
+	try {
+		LOG(Msg, "Drachen benchmark startup");
+		if (!traceFile.empty())
+			Profiler::Instance().StartTrace(traceFile);
+		gTheme.LoadTheme("default");
+
+		switch (mode) {
+		case Scenarios:
+			RunScenarios(selected, ticks, useWindow, outFile);
+			break;
+
+		case Generate: {
+			if (gen.spawns == 0)
+				throw GameError() << ErrorInfo::Desc("At least one spawn is needed");
+
+			std::string map = GenerateMap(gen);
+			std::string level = GenerateLevel(gen, map);
+			std::cout << "map: " << map << "\n"
+			          << "level: " << level << std::endl;
+			break;
+		}
+
+		case Endless: {
+			auto curve = RunEndless(endless, [](const EndlessStep& step) {
+				PrintEndlessStep(std::cerr, step);
+			});
+			WriteResult(EndlessToJson(endless, curve), outFile);
+			break;
+		}
+
+		case Gate: {
+			if (gate.runs == 0 || gate.ticksPerFrame == 0) {
+				PrintUsage();
+				return 1;
+			}
+
+			auto results = RunGate(gate);
+			if (!outFile.empty())
+				WriteResult(GateToJson(gate, results), outFile);
+
+			if (updateBaseline) {
+				WriteResult(GateToJson(gate, results), gate.baseline);
+				std::cerr << "baseline written to " << gate.baseline << std::endl;
+				break;
+			}
+
+			std::ifstream in(gate.baseline);
+			if (!in.is_open())
+				throw GameError() << ErrorInfo::Desc("Failed to open the baseline, create it with --update-baseline") << boost::errinfo_file_name(gate.baseline);
+			js::mValue baseline;
+			try {
+				js::read_or_throw(in, baseline);
+			}
+			catch (js::Error_position err) {
+				throw GameError() << ErrorInfo::Desc("Invalid json file") << ErrorInfo::Note(err.reason_) << boost::errinfo_at_line(err.line_) << boost::errinfo_file_name(gate.baseline);
+			}
+			if (baseline.type() != js::obj_type)
+				throw GameError() << ErrorInfo::Desc("Root value is not an object") << boost::errinfo_file_name(gate.baseline);
+
+			size_t regressions = CompareGate(std::cout, gate, results, baseline.get_obj());
+			if (regressions) {
+				std::cout << regressions << " regression(s) above " << gate.threshold << "%" << std::endl;
+				return 2;
+			}
+			std::cout << "no regressions" << std::endl;
+			break;
+		}
+
+		case Record: {
+			if (outFile.empty())
+				throw GameError() << ErrorInfo::Desc("No output file given, use --out");
+
+			Replay replay = RecordBotReplay(recordLevel, gen.seed);
+			replay.WriteToFile(outFile);
+			std::cout << "replay: " << outFile << "\n"
+			          << "commands: " << replay.commands.size() << std::endl;
+			break;
+		}
+
+		case Paths: {
+			if (paths.repeats == 0) {
+				PrintUsage();
+				return 1;
+			}
+
+			auto results = RunPathBench(paths, std::cerr);
+			size_t failures = 0;
+			for (auto& result: results) {
+				PrintPathBenchResult(std::cerr, result);
+				failures += result.failures;
+			}
+			WriteResult(PathBenchToJson(paths, results), outFile);
+
+			if (failures) {
+				std::cerr << failures << " wrong path(s)" << std::endl;
+				return 2;
+			}
+			break;
+		}
+
+		case Kernels: {
+			if (kernels.repeats == 0) {
+				PrintUsage();
+				return 1;
+			}
+
+			auto results = RunKernelBench(kernels, std::cerr);
+			size_t failures = 0;
+			for (auto& result: results) {
+				PrintKernelBenchResult(std::cerr, result);
+				failures += result.failures;
+			}
+			WriteResult(KernelBenchToJson(kernels, results), outFile);
+
+			if (failures) {
+				std::cerr << failures << " wrong result(s)" << std::endl;
+				return 2;
+			}
+			break;
+		}
+
+		case Sleep: {
+			if (ticks)
+				sleepCheck.ticks = ticks;
+
+			size_t failures = RunSleepCheck(sleepCheck, std::cerr);
+			std::cerr << "sleep: " << sleepCheck.towers << " towers, " << sleepCheck.ticks << " ticks, " << failures << " wrong tick(s)" << std::endl;
+			if (failures)
+				return 2;
+			break;
+		}
+		}
+	}
+	catch (boost::exception& ex) {
+		PrintError(ex);
+		return 1;
+	}
+	catch (std::exception& ex) {
+		std::cerr << "Error: " << ex.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
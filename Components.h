@@ -0,0 +1,125 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include "TowerSettings.h"
+#include "HandlePool.h"
+
+#include <cstdint>
+
+typedef uint32_t ComponentMask;
+
+// Everything the systems read or write. The components up to NUM_COMPONENTS are stored
+// in the World, the enemy data is scheduled the same way but lives in the EnemyStore.
+enum ComponentId {
+	TransformId,
+	TargetingId,
+	CooldownId,
+	LauncherId,
+	ProjectileId,
+	SplashId,
+	AuraId,
+	NUM_COMPONENTS,
+
+	EnemyMotionId = NUM_COMPONENTS,  // position, path and animation of the enemies
+	EnemyHealthId,
+};
+
+inline ComponentMask Bit(ComponentId id)
+{
+	return 1u << id;
+}
+
+struct Transform
+{
+	Vector2f pos;
+	float rotation;  // in degrees
+
+	Transform()
+	: rotation(0)
+	{ }
+};
+
+// Picks an enemy within range to attack
+struct Targeting
+{
+	float range;
+	TowerSettings::Targeting mode;
+	Handle current;  // in the EnemyStore
+
+	Targeting()
+	: range(0), mode(TowerSettings::Closest), current(NO_HANDLE)
+	{ }
+};
+
+// Attacks every cooldown seconds while awake
+struct Cooldown
+{
+	float cooldown;
+	float timer;
+	bool ready;  // attacks in this update
+
+	bool asleep;
+
+	Cooldown()
+	: cooldown(0), timer(0), ready(false), asleep(false)
+	{ }
+};
+
+// Shoots projectiles of the stage at the target
+struct Launcher
+{
+	const TowerSettings::Stage* stage;
+	Vector2f origin;  // the attack positions are relative to it
+
+	Launcher()
+	: stage(nullptr)
+	{ }
+};
+
+// Flies to its target and hits it
+struct Projectile
+{
+	Handle target;  // in the EnemyStore
+	Vector2f targetPosition;  // the last one seen, if the target is gone
+	float speed;
+	float power;
+	const Image* image;
+	bool hit;
+
+	Projectile()
+	: target(NO_HANDLE), speed(0), power(0), image(nullptr), hit(false)
+	{ }
+};
+
+// Also hits the enemies around the impact. Launchers pass it on to their projectiles.
+struct Splash
+{
+	float range;
+	float power;
+
+	Splash()
+	: range(0), power(0)
+	{ }
+};
+
+// Hits every enemy within range of the targeting
+struct Aura
+{
+	float power;
+
+	Aura()
+	: power(0)
+	{ }
+};
+
+template <typename T> struct ComponentType;
+
+template <> struct ComponentType<Transform>  { static const ComponentId id = TransformId; };
+template <> struct ComponentType<Targeting>  { static const ComponentId id = TargetingId; };
+template <> struct ComponentType<Cooldown>   { static const ComponentId id = CooldownId; };
+template <> struct ComponentType<Launcher>   { static const ComponentId id = LauncherId; };
+template <> struct ComponentType<Projectile> { static const ComponentId id = ProjectileId; };
+template <> struct ComponentType<Splash>     { static const ComponentId id = SplashId; };
+template <> struct ComponentType<Aura>       { static const ComponentId id = AuraId; };
+
+#endif //COMPONENTS_H
@@ -48,4 +48,9 @@ static inline boost::filesystem::path GetStatusFile()
 	return boost::filesystem::path("drachen.st");
 }
 
+static inline boost::filesystem::path GetReplayFile()
+{
+	return boost::filesystem::path("last-game.replay");
+}
+
 #endif //DATA_PATHS_H
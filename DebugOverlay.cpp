@@ -0,0 +1,201 @@
+#include "pch.h"
+#include "DebugOverlay.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "AllocTracker.h"
+#include "ResourceManager.h"
+
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+static const Vector2f POSITION(10, 50);
+static const float TEXT_SIZE = 11.f;
+static const float LINE_HEIGHT = 12.f;
+static const float NAME_WIDTH = 220.f;
+static const float COLUMN_WIDTH = 60.f;
+
+static const float GRAPH_HEIGHT = 60.f;
+static const float GRAPH_MS = 20.f;        // frame time at the top of the graph
+static const float BUDGET_MS = 10.f;       // frame limit is 100 fps
+static const float TEXT_UPDATE_TIME = 0.25f;
+
+static const Color BACKGROUND_COLOR(0, 0, 0, 160);
+static const Color TEXT_COLOR(255, 255, 255);
+static const Color OK_COLOR(0, 200, 0);
+static const Color SLOW_COLOR(255, 216, 0);
+static const Color HITCH_COLOR(255, 0, 0);
+
+static std::string FormatMs(double ns)
+{
+	std::ostringstream out;
+	out << std::fixed << std::setprecision(2) << ns / 1e6;
+	return out.str();
+}
+
+DebugOverlay::DebugOverlay()
+: textHeight(LINE_HEIGHT)
+{
+	String* texts[] = { &names, &averages, &maxima, &summary, &frameStats };
+	for (size_t i=0; i < 5; ++i) {
+		texts[i]->SetSize(TEXT_SIZE);
+		texts[i]->SetColor(TEXT_COLOR);
+	}
+
+	summary.SetPosition(POSITION);
+	names.SetPosition(POSITION + Vector2f(0, 2 * LINE_HEIGHT));
+	averages.SetPosition(POSITION + Vector2f(NAME_WIDTH, 2 * LINE_HEIGHT));
+	maxima.SetPosition(POSITION + Vector2f(NAME_WIDTH + COLUMN_WIDTH, 2 * LINE_HEIGHT));
+}
+
+void DebugOverlay::UpdateText()
+{
+	const Profiler& profiler = Profiler::Instance();
+	const auto& zones = profiler.GetZones();
+	const size_t numFrames = profiler.GetNumFrames();
+
+	if (numFrames == 0) {
+		summary.SetText("profiling...");
+		names.SetText("");
+		averages.SetText("");
+		maxima.SetText("");
+		textHeight = LINE_HEIGHT;
+		UpdateFrameStats();
+		return;
+	}
+
+	uint64_t total = 0, worst = 0;
+	for (size_t age=0; age < numFrames; ++age) {
+		total += profiler.GetFrameTime(age);
+		worst = std::max(worst, profiler.GetFrameTime(age));
+	}
+
+	std::ostringstream sum;
+	sum << "frame: " << FormatMs(static_cast<double>(total) / numFrames) << " ms avg, "
+	    << FormatMs(static_cast<double>(worst)) << " ms worst (" << numFrames << " frames)";
+	summary.SetText(sum.str());
+
+	// list the zones depth first, so children are below their parent
+	std::string nameText = "zone\n", avgText = "avg ms\n", maxText = "max ms\n";
+
+	std::function<void (size_t)> addChildren = [&](size_t parent) {
+		for (size_t i=0; i < zones.size(); ++i) {
+			if (zones[i].parent != parent || !zones[i].placed)
+				continue;
+
+			uint64_t zoneTotal = 0, zoneMax = 0;
+			for (size_t age=0; age < numFrames; ++age) {
+				uint64_t t = profiler.GetZoneFrameTime(age, i);
+				zoneTotal += t;
+				zoneMax = std::max(zoneMax, t);
+			}
+			if (zoneMax == 0)
+				continue;
+
+			nameText += std::string(2 * zones[i].depth, ' ') + zones[i].name + "\n";
+			avgText  += FormatMs(static_cast<double>(zoneTotal) / numFrames) + "\n";
+			maxText  += FormatMs(static_cast<double>(zoneMax)) + "\n";
+
+			addChildren(i);
+		}
+	};
+	addChildren(Profiler::NO_PARENT);
+
+	names.SetText(nameText);
+	averages.SetText(avgText);
+	maxima.SetText(maxText);
+
+	// summary, an empty line and the zones
+	textHeight = (std::count(nameText.begin(), nameText.end(), '\n') + 2) * LINE_HEIGHT;
+
+	UpdateFrameStats();
+}
+
+void DebugOverlay::UpdateFrameStats()
+{
+	const RenderStats& stats = RenderStats::Instance();
+
+	std::ostringstream out;
+	size_t lines = 0;
+
+	auto addRenderLine = [&](const std::string& name, const RenderStats::Counters& c) {
+		out << name << ": " << c.drawCalls << " draws, " << c.postFxPasses << " postfx, " << c.imageChanges << " image changes\n";
+		lines++;
+	};
+
+	addRenderLine("render total", stats.GetFrameTotal());
+	for (size_t i=0; i < RenderStats::NUM_CATEGORIES; ++i) {
+		auto category = static_cast<RenderStats::Category>(i);
+		if (stats.GetFrame(category).drawCalls != 0)
+			addRenderLine(std::string("  ") + RenderStats::GetCategoryName(category), stats.GetFrame(category));
+	}
+
+	auto addAllocLine = [&](const std::string& name, const AllocTracker::Counters& c) {
+		out << name << ": " << c.allocations << " allocs, " << c.bytes << " bytes, " << c.frees << " frees\n";
+		lines++;
+	};
+
+	addAllocLine("allocations total", AllocTracker::GetFrameTotal());
+	for (size_t i=0; i < AllocTracker::GetNumTags(); ++i) {
+		AllocTracker::Counters c = AllocTracker::GetFrame(i);
+		if (c.allocations != 0 || c.frees != 0)
+			addAllocLine(std::string("  ") + AllocTracker::GetTagName(i), c);
+	}
+
+	out << "images: " << gImageManager.getNumResources() << ", " << gImageManager.getTotalBytes() / 1024 << " KiB, peak "
+	    << gImageManager.getPeakBytes() / 1024 << " KiB (F11 writes a report to the log)\n";
+	lines++;
+
+	frameStats.SetText(out.str());
+
+	// the frame stats start below the graph
+	float statsTop = textHeight + GRAPH_HEIGHT + LINE_HEIGHT;
+	frameStats.SetPosition(POSITION + Vector2f(0, statsTop));
+
+	float height = statsTop + lines * LINE_HEIGHT + 5;
+	background = Shape::Rectangle(POSITION - Vector2f(5, 5), POSITION + Vector2f(NAME_WIDTH + 2 * COLUMN_WIDTH, height), BACKGROUND_COLOR);
+}
+
+void DebugOverlay::UpdateGraph()
+{
+	const Profiler& profiler = Profiler::Instance();
+	const float scale = GRAPH_HEIGHT / GRAPH_MS;
+
+	const float bottom = POSITION.y + textHeight + GRAPH_HEIGHT;
+	const float width = (NAME_WIDTH + 2 * COLUMN_WIDTH) / Profiler::HISTORY;
+
+	graph.clear();
+	graph.reserve(profiler.GetNumFrames() + 1);
+
+	// newest frame on the right
+	for (size_t age=0; age < profiler.GetNumFrames(); ++age) {
+		float ms = profiler.GetFrameTime(age) / 1e6f;
+		float x = POSITION.x + (Profiler::HISTORY - 1 - age) * width;
+
+		Color color = ms <= BUDGET_MS ? OK_COLOR : (ms <= 1000.f / 60 ? SLOW_COLOR : HITCH_COLOR);
+		graph.push_back(Shape::Rectangle(x, bottom - std::min(ms, GRAPH_MS) * scale, x + width, bottom, color));
+	}
+
+	float budget = bottom - BUDGET_MS * scale;
+	graph.push_back(Shape::Line(POSITION.x, budget, POSITION.x + NAME_WIDTH + 2 * COLUMN_WIDTH, budget, 1.f, TEXT_COLOR));
+}
+
+void DebugOverlay::Draw(RenderTarget& target)
+{
+	if (textUpdateClock.GetElapsedTime() > TEXT_UPDATE_TIME) {
+		UpdateText();
+		textUpdateClock.Reset();
+	}
+	UpdateGraph();
+
+	RenderStats::Draw(target, background);
+	RenderStats::Draw(target, summary);
+	RenderStats::Draw(target, names);
+	RenderStats::Draw(target, averages);
+	RenderStats::Draw(target, maxima);
+	RenderStats::Draw(target, frameStats);
+
+	boost::for_each(graph, [&](const Shape& s) {
+		RenderStats::Draw(target, s);
+	});
+}
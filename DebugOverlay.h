@@ -0,0 +1,32 @@
+#ifndef DEBUG_OVERLAY_H
+#define DEBUG_OVERLAY_H
+
+// Shows the profiler zones of the last frames: the average and maximal time per
+// zone, the worst frame and a graph of the frame times. Below the graph the render
+// stats and allocations of the last frame and the memory held by the images are listed.
+// Drawn while debug is on (F12).
+class DebugOverlay
+{
+	String names, averages, maxima;
+	String summary;
+	String frameStats;
+
+	float textHeight;
+
+	Shape background;
+	std::vector<Shape> graph;
+
+	sf::Clock textUpdateClock;
+
+public:
+	DebugOverlay();
+
+	void Draw(RenderTarget& target);
+
+private:
+	void UpdateText();
+	void UpdateFrameStats();
+	void UpdateGraph();
+};
+
+#endif //DEBUG_OVERLAY_H
@@ -0,0 +1,275 @@
+#include "pch.h"
+#include "EnemyIndex.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+
+// An insertion sort moving more entries than this per enemy gives up, the order changed
+// too much (e.g. when towers in maze mode changed the way) and gets sorted from scratch.
+static const size_t MAX_MOVES_PER_ENEMY = 8;
+
+// Edge length of the grid cells, about the size of an enemy and a fraction of a tower range
+static const float DEFAULT_CELL_SIZE = 32.0f;
+
+/*static*/ const size_t EnemyIndex::RANGE_BATCH;
+
+EnemyIndex::EnemyIndex(const EnemyStore& store)
+: store(store), cellSize(DEFAULT_CELL_SIZE), gridWidth(1), gridHeight(1)
+{
+	cellStart.assign(3, 0);
+}
+
+void EnemyIndex::Clear()
+{
+	entries.clear();
+	itemX.clear();
+	itemY.clear();
+	itemEntry.clear();
+	cellStart.assign(cellStart.size(), 0);
+}
+
+void EnemyIndex::Reserve(size_t n)
+{
+	ALLOC_TAG("targeting");
+	entries.reserve(n);
+	itemX.reserve(n);
+	itemY.reserve(n);
+	itemEntry.reserve(n);
+	unsorted.reserve(n);
+}
+
+void EnemyIndex::SetArea(float width, float height)
+{
+	gridWidth = std::max(static_cast<int>(std::ceil(width / cellSize)), 1);
+	gridHeight = std::max(static_cast<int>(std::ceil(height / cellSize)), 1);
+	BuildGrid();
+}
+
+void EnemyIndex::Add(Handle enemy)
+{
+	Entry entry;
+	entry.row = static_cast<uint32_t>(store.Find(enemy));
+	entry.remaining = store.GetRemainingDistance(entry.row);
+	entry.enemy = enemy;
+	entries.push_back(entry);
+}
+
+void EnemyIndex::Update()
+{
+	PROFILE_ZONE("EnemyIndex::Update");
+	ALLOC_TAG("targeting");
+
+	auto end = entries.begin();
+	for (auto it = entries.begin(); it != entries.end(); ++it) {
+		const size_t row = store.Find(it->enemy);
+		if (row == EnemyStore::NO_ROW || store.IsIrrelevant(row))
+			continue;
+		it->row = static_cast<uint32_t>(row);
+		it->remaining = store.GetRemainingDistance(row);
+		*end++ = *it;
+	}
+	entries.erase(end, entries.end());
+
+	auto cmp = [](const Entry& a, const Entry& b) {
+		return a.remaining < b.remaining;
+	};
+
+	size_t moves = 0;
+	const size_t maxMoves = MAX_MOVES_PER_ENEMY * entries.size();
+	for (size_t i=1; i < entries.size(); ++i) {
+		if (!cmp(entries[i], entries[i-1]))
+			continue;
+
+		Entry entry = std::move(entries[i]);
+		size_t j = i;
+		for (; j > 0 && cmp(entry, entries[j-1]); --j)
+			entries[j] = std::move(entries[j-1]);
+		entries[j] = std::move(entry);
+
+		moves += i - j;
+		if (moves > maxMoves) {
+			std::sort(entries.begin(), entries.end(), cmp);
+			break;
+		}
+	}
+
+	BuildGrid();
+}
+
+int EnemyIndex::GetCellX(float x) const
+{
+	return std::min(std::max(static_cast<int>(std::floor(x / cellSize)), 0), gridWidth - 1);
+}
+
+int EnemyIndex::GetCellY(float y) const
+{
+	return std::min(std::max(static_cast<int>(std::floor(y / cellSize)), 0), gridHeight - 1);
+}
+
+void EnemyIndex::GetCells(const Vector2f& pos, float range, int& x0, int& y0, int& x1, int& y1) const
+{
+	x0 = GetCellX(pos.x - range);
+	y0 = GetCellY(pos.y - range);
+	x1 = GetCellX(pos.x + range);
+	y1 = GetCellY(pos.y + range);
+}
+
+void EnemyIndex::BuildGrid()
+{
+	PROFILE_ZONE("EnemyIndex::BuildGrid");
+
+	// counting sort by cell, stable so every cell keeps the progress order. The enemies
+	// outside the grid go into the overflow cell behind the others.
+	const size_t numCells = gridWidth * gridHeight + 1;
+	const float width = gridWidth * cellSize, height = gridHeight * cellSize;
+	cellStart.assign(numCells + 1, 0);
+	unsorted.resize(entries.size());
+	for (size_t i=0; i < entries.size(); ++i) {
+		Vector2f pos = store.GetPosition(entries[i].row);
+		unsorted[i].pos = pos;
+		if (pos.x >= 0 && pos.x < width && pos.y >= 0 && pos.y < height)
+			unsorted[i].entry = GetCellY(pos.y) * gridWidth + GetCellX(pos.x);  // the cell for now
+		else
+			unsorted[i].entry = static_cast<uint32_t>(GetOverflowCell());
+		cellStart[unsorted[i].entry + 1]++;
+	}
+	for (size_t c=0; c < numCells; ++c)
+		cellStart[c+1] += cellStart[c];
+
+	fill.assign(cellStart.begin(), cellStart.end() - 1);
+	itemX.resize(unsorted.size());
+	itemY.resize(unsorted.size());
+	itemEntry.resize(unsorted.size());
+	for (size_t i=0; i < unsorted.size(); ++i) {
+		const uint32_t item = fill[unsorted[i].entry]++;
+		itemX[item] = unsorted[i].pos.x;
+		itemY[item] = unsorted[i].pos.y;
+		itemEntry[item] = static_cast<uint32_t>(i);
+	}
+}
+
+Handle EnemyIndex::FindFirst(const Vector2f& pos, float range) const
+{
+	int x0, y0, x1, y1;
+	GetCells(pos, range, x0, y0, x1, y1);
+	const float rangeSq = range * range;
+
+	uint32_t best = static_cast<uint32_t>(entries.size());
+	auto scan = [&](size_t cell) {
+		for (uint32_t i = cellStart[cell]; i < cellStart[cell+1] && itemEntry[i] < best; ++i) {
+			if (distSq(GetItemPosition(i), pos) <= rangeSq && !store.IsIrrelevant(entries[itemEntry[i]].row)) {
+				best = itemEntry[i];
+				break;
+			}
+		}
+	};
+	for (int y=y0; y <= y1; ++y) {
+		for (int x=x0; x <= x1; ++x)
+			scan(y * gridWidth + x);
+	}
+	scan(GetOverflowCell());
+	if (best == entries.size())
+		return NO_HANDLE;
+	return entries[best].enemy;
+}
+
+Handle EnemyIndex::FindLast(const Vector2f& pos, float range) const
+{
+	int x0, y0, x1, y1;
+	GetCells(pos, range, x0, y0, x1, y1);
+	const float rangeSq = range * range;
+
+	uint32_t best = static_cast<uint32_t>(entries.size());
+	auto scan = [&](size_t cell) {
+		for (uint32_t i = cellStart[cell+1]; i > cellStart[cell]; --i) {
+			const uint32_t entry = itemEntry[i-1];
+			if (best != entries.size() && entry <= best)
+				break;
+			if (distSq(GetItemPosition(i-1), pos) <= rangeSq && !store.IsIrrelevant(entries[entry].row)) {
+				best = entry;
+				break;
+			}
+		}
+	};
+	for (int y=y0; y <= y1; ++y) {
+		for (int x=x0; x <= x1; ++x)
+			scan(y * gridWidth + x);
+	}
+	scan(GetOverflowCell());
+	if (best == entries.size())
+		return NO_HANDLE;
+	return entries[best].enemy;
+}
+
+Handle EnemyIndex::FindStrongest(const Vector2f& pos, float range) const
+{
+	int x0, y0, x1, y1;
+	GetCells(pos, range, x0, y0, x1, y1);
+	const float rangeSq = range * range;
+
+	uint32_t best = static_cast<uint32_t>(entries.size());
+	float bestLife = 0;
+	auto scan = [&](size_t cell) {
+		for (uint32_t i = cellStart[cell]; i < cellStart[cell+1]; ++i) {
+			const uint32_t row = entries[itemEntry[i]].row;
+			const float life = store.GetLife(row);
+			if (life < bestLife || (life == bestLife && itemEntry[i] > best))
+				continue;
+			if (distSq(GetItemPosition(i), pos) <= rangeSq && !store.IsIrrelevant(row)) {
+				best = itemEntry[i];
+				bestLife = life;
+			}
+		}
+	};
+	for (int y=y0; y <= y1; ++y) {
+		for (int x=x0; x <= x1; ++x)
+			scan(y * gridWidth + x);
+	}
+	scan(GetOverflowCell());
+	if (best == entries.size())
+		return NO_HANDLE;
+	return entries[best].enemy;
+}
+
+Handle EnemyIndex::FindClosest(const Vector2f& pos, float range) const
+{
+	// search the overflow cell first, then the cells in growing rings around the cell of
+	// pos. All enemies in the rings are inside the grid, where the distance to pos is at
+	// least the distance to pos moved into the grid, so a ring further out than the best
+	// enemy so far cannot hold a closer one.
+	const int cx = GetCellX(pos.x), cy = GetCellY(pos.y);
+	const int maxRing = static_cast<int>(std::ceil(range / cellSize)) + 1;
+
+	uint32_t best = static_cast<uint32_t>(entries.size());
+	float bestDistSq = range * range;
+	auto scan = [&](size_t cell) {
+		for (uint32_t i = cellStart[cell]; i < cellStart[cell+1]; ++i) {
+			float d = distSq(GetItemPosition(i), pos);
+			if (d > bestDistSq || (d == bestDistSq && itemEntry[i] > best))
+				continue;
+			if (!store.IsIrrelevant(entries[itemEntry[i]].row)) {
+				best = itemEntry[i];
+				bestDistSq = d;
+			}
+		}
+	};
+	scan(GetOverflowCell());
+	for (int ring=0; ring <= maxRing; ++ring) {
+		const float inner = (ring - 1) * cellSize;
+		if (best != entries.size() && ring > 1 && inner * inner > bestDistSq)
+			break;
+
+		for (int y = cy - ring; y <= cy + ring; ++y) {
+			if (y < 0 || y >= gridHeight)
+				continue;
+			// only the first and the last column on the rows in between
+			const int step = (y == cy - ring || y == cy + ring) ? 1 : std::max(2 * ring, 1);
+			for (int x = cx - ring; x <= cx + ring; x += step) {
+				if (x >= 0 && x < gridWidth)
+					scan(y * gridWidth + x);
+			}
+		}
+	}
+	if (best == entries.size())
+		return NO_HANDLE;
+	return entries[best].enemy;
+}
@@ -0,0 +1,137 @@
+#ifndef ENEMY_INDEX_H
+#define ENEMY_INDEX_H
+
+#include "EnemyStore.h"
+#include "Utility.h"
+#include "Kernels.h"
+
+#include <cstdint>
+
+// The live enemies ordered by their progress along the path: the enemy with the least
+// way left to its target comes first. The order hardly changes from one tick to the
+// next, so it is kept and only repaired in Update.
+// For the range queries the enemies are also sorted into a uniform grid over the map.
+// The enemies of a cell keep the progress order, a search for the first or the last
+// enemy in range stops at the first hit in every cell.
+class EnemyIndex
+{
+	// items ForEachInRange tests at once
+	static const size_t RANGE_BATCH = 256;
+
+	struct Entry
+	{
+		float remaining;  // distance to the target
+		Handle enemy;
+		uint32_t row;  // in the store, as of the last update
+	};
+
+	struct Item
+	{
+		Vector2f pos;
+		uint32_t entry;
+	};
+
+	const EnemyStore& store;
+	std::vector<Entry> entries;
+
+	float cellSize;
+	int gridWidth, gridHeight;
+	std::vector<uint32_t> cellStart;  // items of cell i are [cellStart[i], cellStart[i+1])
+	std::vector<float> itemX, itemY;  // one array per value, for the range kernel
+	std::vector<uint32_t> itemEntry;
+	std::vector<Item> unsorted;  // used while building, entry is the cell there
+	std::vector<uint32_t> fill;
+
+public:
+	explicit EnemyIndex(const EnemyStore& store);
+
+	void Clear();
+
+	// Make room for n enemies at the same time
+	void Reserve(size_t n);
+
+	// Size of the area covered by the grid, enemies outside are kept in an
+	// overflow cell every query looks at
+	void SetArea(float width, float height);
+
+	// New enemies are inserted by the next update
+	void Add(Handle enemy);
+
+	// Drop the irrelevant enemies, restore the order after they moved and sort them into
+	// the grid. The queries use the positions of this update and the rows of the store
+	// until enemies get removed from it.
+	void Update();
+
+	size_t GetSize() const
+	{
+		return entries.size();
+	}
+
+	// Call f with the row of every relevant enemy within range of pos
+	template <typename F>
+	void ForEachInRange(const Vector2f& pos, float range, F f) const
+	{
+		int x0, y0, x1, y1;
+		GetCells(pos, range, x0, y0, x1, y1);
+		const float rangeSq = range * range;
+
+		// the cells of a grid row are next to each other in the items
+		for (int y=y0; y <= y1; ++y)
+			ForEachItemInRange(cellStart[y * gridWidth + x0], cellStart[y * gridWidth + x1 + 1], pos, rangeSq, f);
+		const size_t overflow = GetOverflowCell();
+		ForEachItemInRange(cellStart[overflow], cellStart[overflow + 1], pos, rangeSq, f);
+	}
+
+	// The enemy with the least way left within range of pos, or NO_HANDLE
+	Handle FindFirst(const Vector2f& pos, float range) const;
+
+	// The enemy with the most way left within range of pos
+	Handle FindLast(const Vector2f& pos, float range) const;
+
+	// The enemy with the most life within range of pos, the first one among equals
+	Handle FindStrongest(const Vector2f& pos, float range) const;
+
+	// The enemy closest to pos if it is within range, the first one among equals
+	Handle FindClosest(const Vector2f& pos, float range) const;
+
+private:
+	EnemyIndex(const EnemyIndex&) /*= delete*/;
+	EnemyIndex& operator=(const EnemyIndex&) /*= delete*/;
+
+	Vector2f GetItemPosition(size_t i) const
+	{
+		return Vector2f(itemX[i], itemY[i]);
+	}
+
+	// Test the items from begin to end in batches by the kernel
+	template <typename F>
+	void ForEachItemInRange(uint32_t begin, uint32_t end, const Vector2f& pos, float rangeSq, F& f) const
+	{
+		uint32_t found[RANGE_BATCH];
+		for (; begin < end; begin += RANGE_BATCH) {
+			const size_t n = std::min<size_t>(end - begin, RANGE_BATCH);
+			const size_t numFound = SelectInRange(&itemX[begin], &itemY[begin], n, pos, rangeSq, found);
+			for (size_t k=0; k < numFound; ++k) {
+				const uint32_t row = entries[itemEntry[begin + found[k]]].row;
+				if (!store.IsIrrelevant(row))
+					f(row);
+			}
+		}
+	}
+
+	// The cell behind the grid holding the enemies outside of it
+	size_t GetOverflowCell() const
+	{
+		return gridWidth * gridHeight;
+	}
+
+	int GetCellX(float x) const;
+	int GetCellY(float y) const;
+
+	// The cells touched by the circle around pos
+	void GetCells(const Vector2f& pos, float range, int& x0, int& y0, int& x1, int& y1) const;
+
+	void BuildGrid();
+};
+
+#endif //ENEMY_INDEX_H
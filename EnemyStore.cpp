@@ -0,0 +1,209 @@
+#include "pch.h"
+#include "EnemyStore.h"
+#include "Map.h"
+#include "WalkPath.h"
+#include "Utility.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+
+EnemyStore::EnemyStore()
+: map(nullptr), clock(nullptr), settings(nullptr)
+{ }
+
+void EnemyStore::Init(const Map& m, const SimClock& c, const std::vector<EnemySettings>& s)
+{
+	map = &m;
+	clock = &c;
+	settings = &s;
+}
+
+void EnemyStore::Clear()
+{
+	x.clear();
+	y.clear();
+	speed.clear();
+	life.clear();
+	distance.clear();
+	segment.clear();
+	type.clear();
+	flags.clear();
+	facing.clear();
+	spawnTime.clear();
+	path.clear();
+	pathVersion.clear();
+	target.clear();
+	lead.clear();
+	handle.clear();
+	handles.Clear();
+}
+
+void EnemyStore::Reserve(size_t n)
+{
+	ALLOC_TAG("enemies");
+
+	x.reserve(n);
+	y.reserve(n);
+	speed.reserve(n);
+	life.reserve(n);
+	distance.reserve(n);
+	segment.reserve(n);
+	type.reserve(n);
+	flags.reserve(n);
+	facing.reserve(n);
+	spawnTime.reserve(n);
+	path.reserve(n);
+	pathVersion.reserve(n);
+	target.reserve(n);
+	lead.reserve(n);
+	handle.reserve(n);
+	handles.Reserve(n);
+	rows.reserve(n);
+	keep.reserve(n);
+}
+
+Handle EnemyStore::Spawn(size_t tp, const Vector2f& pos, const Vector2f& tgt)
+{
+	const EnemySettings& s = (*settings)[tp];
+	const size_t i = GetSize();
+
+	x.push_back(pos.x);
+	y.push_back(pos.y);
+	speed.push_back(s.speed);
+	life.push_back(ENEMY_LIFE);
+	distance.push_back(0);
+	segment.push_back(0);
+	type.push_back(static_cast<uint16_t>(tp));
+	flags.push_back(0);
+	facing.push_back(AnimSprite::Up);
+	spawnTime.push_back(static_cast<float>(clock->GetTime()));
+	path.push_back(nullptr);
+	pathVersion.push_back(0);
+	target.push_back(map->PositionToBlock(tgt));
+	lead.push_back(Vector2f(0, 0));
+
+	const Handle h = handles.Allocate();
+	handle.push_back(h);
+	rows.resize(handles.GetNumSlots());
+	rows[HandlePool::GetSlot(h)] = static_cast<uint32_t>(i);
+
+	// walk on the way all enemies starting here take
+	FollowPath(i, map->GetWalkPath(pos, target[i]));
+	return h;
+}
+
+void EnemyStore::FollowPath(size_t i, const std::shared_ptr<const WalkPath>& p)
+{
+	path[i] = p;
+	distance[i] = 0;
+	segment[i] = 0;
+	pathVersion[i] = map->GetPathVersion();
+	lead[i] = Vector2f(0, 0);
+}
+
+void EnemyStore::Reroute(size_t i)
+{
+	const Vector2f pos = GetPosition(i);
+	FollowPath(i, map->GetBlockPath(map->PositionToBlock(pos), target[i]));
+
+	// start behind the path by the way to its start
+	const Vector2f d = pos - path[i]->GetStart();
+	const float len = norm(d);
+	if (len > 0) {
+		distance[i] = -len;
+		lead[i] = d / len;
+	}
+}
+
+float EnemyStore::GetRemainingDistance(size_t i) const
+{
+	if (!path[i])
+		return std::numeric_limits<float>::max();
+	return std::max(path[i]->GetLength() - distance[i], 0.0f);
+}
+
+void EnemyStore::Update(float elapsed)
+{
+	const size_t version = map->GetPathVersion();
+	const size_t n = GetSize();
+	for (size_t i=0; i < n; ++i) {
+		if (life[i] <= 0 || (flags[i] & AtTarget))
+			continue;
+
+		if (path[i] && pathVersion[i] != version)
+			Reroute(i);
+
+		const WalkPath* p = path[i].get();
+		if (p && distance[i] < p->GetLength()) {
+			distance[i] += speed[i] * elapsed;
+			if (distance[i] < 0) {
+				// still on the way to the start of the path
+				Vector2f pos = p->GetStart() - lead[i] * distance[i];
+				x[i] = pos.x;
+				y[i] = pos.y;
+				facing[i] = static_cast<uint8_t>(AnimSprite::GetDirection(-lead[i]));
+			}
+			else {
+				size_t seg = segment[i];
+				Vector2f pos = p->GetPosition(distance[i], seg);
+				segment[i] = static_cast<uint32_t>(seg);
+				x[i] = pos.x;
+				y[i] = pos.y;
+				facing[i] = static_cast<uint8_t>(p->GetFacing(seg));
+			}
+		}
+
+		if (map->IsInTargetArea(GetPosition(i)))
+			flags[i] |= AtTarget;
+	}
+}
+
+size_t EnemyStore::Strike()
+{
+	size_t struck = 0;
+	for (size_t i=0; i < flags.size(); ++i) {
+		if ((flags[i] & (AtTarget | Striked)) == AtTarget) {
+			flags[i] |= Striked;
+			struck++;
+		}
+	}
+	return struck;
+}
+
+void EnemyStore::RemoveIrrelevant()
+{
+	PROFILE_ZONE("EnemyStore::RemoveIrrelevant");
+	ALLOC_TAG("enemies");
+
+	keep.resize(GetSize());
+	bool removeAny = false;
+	for (size_t i=0; i < keep.size(); ++i) {
+		keep[i] = !IsIrrelevant(i);
+		removeAny |= !keep[i];
+	}
+	if (!removeAny)
+		return;
+
+	for (size_t i=0; i < handle.size(); ++i) {
+		if (!keep[i])
+			handles.Release(handle[i]);
+	}
+
+	Compact(x, keep);
+	Compact(y, keep);
+	Compact(speed, keep);
+	Compact(life, keep);
+	Compact(distance, keep);
+	Compact(segment, keep);
+	Compact(type, keep);
+	Compact(flags, keep);
+	Compact(facing, keep);
+	Compact(spawnTime, keep);
+	Compact(path, keep);
+	Compact(pathVersion, keep);
+	Compact(target, keep);
+	Compact(lead, keep);
+	Compact(handle, keep);
+
+	for (size_t i=0; i < handle.size(); ++i)
+		rows[HandlePool::GetSlot(handle[i])] = static_cast<uint32_t>(i);
+}
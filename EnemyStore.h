@@ -0,0 +1,172 @@
+#ifndef ENEMY_STORE_H
+#define ENEMY_STORE_H
+
+#include "AnimSprite.h"
+#include "EnemySettings.h"
+#include "HandlePool.h"
+#include "SimClock.h"
+
+#include <cstdint>
+
+class Map;
+class WalkPath;
+
+// Life of every new enemy, the life in the enemy settings is not used yet
+static const float ENEMY_LIFE = 10.0f;
+
+// The simulation state of all enemies, one array per value in the order of spawning.
+// Movement, damage, death checks and removal run as loops over these arrays. Removal
+// moves the enemies to other rows, so everyone holding on to an enemy keeps a handle
+// and looks up its row. The handle of a removed enemy is stale.
+class EnemyStore
+{
+public:
+	enum Flags {
+		AtTarget = 1,
+		Striked  = 2,
+	};
+
+private:
+	const Map* map;
+	const SimClock* clock;
+	const std::vector<EnemySettings>* settings;
+
+	std::vector<float> x, y;
+	std::vector<float> speed;
+	std::vector<float> life;
+	std::vector<float> distance;     // along the path, negative on the way to its start
+	std::vector<uint32_t> segment;   // of the path at distance
+	std::vector<uint16_t> type;      // index into the enemy settings
+	std::vector<uint8_t> flags;
+	std::vector<uint8_t> facing;     // AnimSprite::Direction
+	std::vector<float> spawnTime;    // the animation starts there
+	std::vector<std::shared_ptr<const WalkPath>> path;
+	std::vector<size_t> pathVersion;
+	std::vector<Vector2i> target;
+	std::vector<Vector2f> lead;      // unit vector from the start of the path to where the enemy joined it
+	std::vector<Handle> handle;
+
+	HandlePool handles;
+	std::vector<uint32_t> rows;  // by slot of the handles
+
+	std::vector<uint8_t> keep;  // used while removing
+
+public:
+	EnemyStore();
+
+	void Init(const Map& map, const SimClock& clock, const std::vector<EnemySettings>& settings);
+
+	static const size_t NO_ROW = static_cast<size_t>(-1);
+
+	// Drop all enemies, their handles get stale
+	void Clear();
+
+	// Make room for n enemies at the same time
+	void Reserve(size_t n);
+
+	// New enemy walking from pos to the target on the path all enemies of pos take
+	Handle Spawn(size_t type, const Vector2f& pos, const Vector2f& target);
+
+	// Move all enemies along their paths
+	void Update(float elapsed);
+
+	// Let the enemies in the target area strike, returns how many did
+	size_t Strike();
+
+	// Remove the dead enemies and the ones that struck, the others keep their order
+	void RemoveIrrelevant();
+
+	size_t GetSize() const
+	{
+		return x.size();
+	}
+
+	// The row of the enemy, NO_ROW if it was removed
+	size_t Find(Handle h) const
+	{
+		return handles.IsValid(h) ? rows[HandlePool::GetSlot(h)] : NO_ROW;
+	}
+
+	Handle GetHandle(size_t i) const
+	{
+		return handle[i];
+	}
+
+	Vector2f GetPosition(size_t i) const
+	{
+		return Vector2f(x[i], y[i]);
+	}
+
+	float GetLife(size_t i) const
+	{
+		return life[i];
+	}
+
+	void Hit(size_t i, float power)
+	{
+		life[i] = std::max(life[i] - power, 0.0f);
+	}
+
+	bool IsDead(size_t i) const
+	{
+		return life[i] <= 0;
+	}
+
+	bool IsAtTarget(size_t i) const
+	{
+		return (flags[i] & AtTarget) != 0;
+	}
+
+	bool DidStrike(size_t i) const
+	{
+		return (flags[i] & Striked) != 0;
+	}
+
+	bool IsIrrelevant(size_t i) const
+	{
+		return life[i] <= 0 || (flags[i] & Striked) != 0;
+	}
+
+	size_t GetType(size_t i) const
+	{
+		return type[i];
+	}
+
+	const EnemySettings& GetSettings(size_t i) const
+	{
+		return (*settings)[type[i]];
+	}
+
+	const std::shared_ptr<const WalkPath>& GetPath(size_t i) const
+	{
+		return path[i];
+	}
+
+	float GetDistance(size_t i) const
+	{
+		return distance[i];
+	}
+
+	// Way left along the path to the target, the progress the towers target by
+	float GetRemainingDistance(size_t i) const;
+
+	AnimSprite::Direction GetFacing(size_t i) const
+	{
+		return static_cast<AnimSprite::Direction>(facing[i]);
+	}
+
+	// Time since the enemy got spawned
+	float GetAge(size_t i) const
+	{
+		return static_cast<float>(clock->GetTime()) - spawnTime[i];
+	}
+
+private:
+	void FollowPath(size_t i, const std::shared_ptr<const WalkPath>& p);
+
+	// Towers in maze mode changed the way. The enemy walks to the center of its block and
+	// goes on from there on the path everyone in the block takes.
+	void Reroute(size_t i);
+};
+
+#endif //ENEMY_STORE_H
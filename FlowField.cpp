@@ -0,0 +1,212 @@
+#include "pch.h"
+#include "FlowField.h"
+#include "NavGrid.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+
+// left, right, up, down
+static const int OFFSET_X[] = { -1, 1, 0, 0 };
+static const int OFFSET_Y[] = { 0, 0, -1, 1 };
+static const size_t NUM_NEIGHBORS = 4;
+
+FlowField::FlowField()
+: width(0), height(0), target(-1, -1)
+{ }
+
+void FlowField::Compute(const NavGrid& grid, const Vector2i& tgt)
+{
+	PROFILE_ZONE("FlowField::Compute");
+	ALLOC_TAG("pathfinding");
+
+	width = grid.GetWidth();
+	height = grid.GetHeight();
+	target = tgt;
+
+	distance.assign(width * height, static_cast<uint32_t>(UNREACHABLE));
+	next.assign(width * height, -1);
+
+	if (!Contains(target) || !grid.IsWalkable(target.x, target.y))
+		return;
+
+	// every step costs the same, so the blocks leave the queue in order of their distance
+	std::vector<size_t> queue;
+	queue.reserve(width * height);
+	queue.push_back(target.x + target.y * width);
+	distance[queue.front()] = 0;
+
+	for (size_t i=0; i < queue.size(); ++i) {
+		size_t cur = queue[i];
+		int x = static_cast<int>(cur % width);
+		int y = static_cast<int>(cur / width);
+
+		const uint8_t walkable = grid.GetNeighbors(x, y);
+		for (size_t n=0; n < NUM_NEIGHBORS; ++n) {
+			if (!(walkable & (1 << n)))
+				continue;
+
+			size_t idx = (x + OFFSET_X[n]) + (y + OFFSET_Y[n]) * width;
+			if (distance[idx] != UNREACHABLE)
+				continue;
+
+			distance[idx] = distance[cur] + 1;
+			queue.push_back(idx);
+		}
+	}
+
+	for (size_t idx=0; idx < distance.size(); ++idx)
+		UpdateNext(idx);
+}
+
+void FlowField::Block(const NavGrid& grid, const Vector2i& blk)
+{
+	PROFILE_ZONE("FlowField::Block");
+
+	if (!Contains(blk) || distance[blk.x + blk.y * width] == UNREACHABLE)
+		return; // no way led over it
+
+	// all blocks whose way led over blk lose their distance, they form a tree below blk
+	std::vector<size_t> affected;
+	affected.push_back(blk.x + blk.y * width);
+	for (size_t i=0; i < affected.size(); ++i) {
+		size_t cur = affected[i];
+		int x = static_cast<int>(cur % width);
+		int y = static_cast<int>(cur / width);
+
+		const uint8_t walkable = grid.GetNeighbors(x, y);
+		for (size_t n=0; n < NUM_NEIGHBORS; ++n) {
+			Vector2i nb(x + OFFSET_X[n], y + OFFSET_Y[n]);
+			if ((walkable & (1 << n)) && distance[nb.x + nb.y * width] != UNREACHABLE && GetNext(nb) == Vector2i(x, y))
+				affected.push_back(nb.x + nb.y * width);
+		}
+	}
+	for (size_t i=0; i < affected.size(); ++i) {
+		distance[affected[i]] = UNREACHABLE;
+		next[affected[i]] = -1;
+	}
+
+	// search them again, starting at the unaffected blocks around them
+	typedef std::pair<uint32_t, size_t> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+	for (size_t i=1; i < affected.size(); ++i) {
+		size_t cur = affected[i];
+		Vector2i pos(static_cast<int>(cur % width), static_cast<int>(cur / width));
+
+		uint32_t best = UNREACHABLE;
+		for (size_t n=0; n < NUM_NEIGHBORS; ++n)
+			best = std::min(best, GetDistance(Vector2i(pos.x + OFFSET_X[n], pos.y + OFFSET_Y[n])));
+		if (best != UNREACHABLE) {
+			distance[cur] = best + 1;
+			open.push(Entry(distance[cur], cur));
+		}
+	}
+
+	while (!open.empty()) {
+		Entry e = open.top();
+		open.pop();
+		if (e.first != distance[e.second])
+			continue; // got closer in the meantime
+
+		int x = static_cast<int>(e.second % width);
+		int y = static_cast<int>(e.second / width);
+		const uint8_t walkable = grid.GetNeighbors(x, y);
+		for (size_t n=0; n < NUM_NEIGHBORS; ++n) {
+			if (!(walkable & (1 << n)))
+				continue;
+
+			size_t idx = (x + OFFSET_X[n]) + (y + OFFSET_Y[n]) * width;
+			if (distance[idx] > e.first + 1) {
+				distance[idx] = e.first + 1;
+				open.push(Entry(distance[idx], idx));
+			}
+		}
+	}
+
+	// only the affected blocks changed, the others still point to a block that did not
+	for (size_t i=0; i < affected.size(); ++i)
+		UpdateNext(affected[i]);
+}
+
+void FlowField::Unblock(const NavGrid& grid, const Vector2i& blk)
+{
+	PROFILE_ZONE("FlowField::Unblock");
+
+	if (!Contains(blk))
+		return;
+
+	size_t start = blk.x + blk.y * width;
+	if (blk == target) {
+		distance[start] = 0;
+	}
+	else {
+		uint32_t best = UNREACHABLE;
+		for (size_t n=0; n < NUM_NEIGHBORS; ++n)
+			best = std::min(best, GetDistance(Vector2i(blk.x + OFFSET_X[n], blk.y + OFFSET_Y[n])));
+		if (best == UNREACHABLE)
+			return; // still cut off
+		distance[start] = best + 1;
+	}
+
+	// the distances only shrink, spreading out from blk they shrink in order
+	std::vector<size_t> changed;
+	changed.push_back(start);
+	for (size_t i=0; i < changed.size(); ++i) {
+		size_t cur = changed[i];
+		int x = static_cast<int>(cur % width);
+		int y = static_cast<int>(cur / width);
+
+		const uint8_t walkable = grid.GetNeighbors(x, y);
+		for (size_t n=0; n < NUM_NEIGHBORS; ++n) {
+			if (!(walkable & (1 << n)))
+				continue;
+
+			size_t idx = (x + OFFSET_X[n]) + (y + OFFSET_Y[n]) * width;
+			if (distance[idx] > distance[cur] + 1) {
+				distance[idx] = distance[cur] + 1;
+				changed.push_back(idx);
+			}
+		}
+	}
+
+	for (size_t i=0; i < changed.size(); ++i)
+		UpdateNext(changed[i]);
+}
+
+void FlowField::UpdateNext(size_t idx)
+{
+	// point the block to its first neighbor one step closer to the target
+	next[idx] = -1;
+	if (distance[idx] == UNREACHABLE || distance[idx] == 0)
+		return;
+
+	Vector2i blk(static_cast<int>(idx % width), static_cast<int>(idx / width));
+	for (size_t n=0; n < NUM_NEIGHBORS; ++n) {
+		if (GetDistance(Vector2i(blk.x + OFFSET_X[n], blk.y + OFFSET_Y[n])) == distance[idx] - 1) {
+			next[idx] = static_cast<int8_t>(n);
+			break;
+		}
+	}
+}
+
+Vector2i FlowField::GetNext(const Vector2i& blk) const
+{
+	if (Contains(blk)) {
+		size_t idx = blk.x + blk.y * width;
+		if (next[idx] >= 0)
+			return Vector2i(blk.x + OFFSET_X[next[idx]], blk.y + OFFSET_Y[next[idx]]);
+		if (distance[idx] == 0)
+			return blk;
+	}
+
+	// not part of the field, e.g. a spawn place beside the path: step onto the closest neighbor
+	Vector2i best = blk;
+	uint32_t bestDistance = UNREACHABLE;
+	for (size_t n=0; n < NUM_NEIGHBORS; ++n) {
+		Vector2i nb(blk.x + OFFSET_X[n], blk.y + OFFSET_Y[n]);
+		uint32_t d = GetDistance(nb);
+		if (d < bestDistance) {
+			best = nb;
+			bestDistance = d;
+		}
+	}
+	return best;
+}
@@ -0,0 +1,70 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <cstdint>
+
+class NavGrid;
+
+// Distance of every block of the path grid to one target block, computed once with a
+// breadth first search from the target. All enemies walking to the target share it:
+// from any block they step to the neighbor closest to the target. When a block gets
+// blocked or opened again, only the blocks whose distance changes are updated.
+class FlowField
+{
+public:
+	static const uint32_t UNREACHABLE = 0xffffffff;
+
+private:
+	size_t width, height;
+	Vector2i target;
+
+	std::vector<uint32_t> distance;
+	std::vector<int8_t> next;  // index into the neighbor offsets, -1 at the target or if unreachable
+
+public:
+	FlowField();
+
+	// Compute the field over the walkable blocks of grid
+	void Compute(const NavGrid& grid, const Vector2i& target);
+
+	// Update the field after blk was made unwalkable in grid. Only the blocks whose way
+	// led over blk are searched again.
+	void Block(const NavGrid& grid, const Vector2i& blk);
+
+	// Update the field after blk was made walkable again in grid. Only the blocks that
+	// get closer to the target are visited.
+	void Unblock(const NavGrid& grid, const Vector2i& blk);
+
+	const Vector2i& GetTarget() const
+	{
+		return target;
+	}
+
+	// Steps to the target, UNREACHABLE outside of the grid or if there is no path
+	uint32_t GetDistance(const Vector2i& blk) const
+	{
+		if (!Contains(blk))
+			return UNREACHABLE;
+		return distance[blk.x + blk.y * width];
+	}
+
+	bool IsReachable(const Vector2i& blk) const
+	{
+		return GetDistance(blk) != UNREACHABLE;
+	}
+
+	// Next block on a shortest path to the target, the block itself at the target or if
+	// the target cannot be reached from it. Blocks that are not walkable step onto their
+	// closest walkable neighbor.
+	Vector2i GetNext(const Vector2i& blk) const;
+
+private:
+	void UpdateNext(size_t idx);
+
+	bool Contains(const Vector2i& blk) const
+	{
+		return blk.x >= 0 && blk.y >= 0 && static_cast<size_t>(blk.x) < width && static_cast<size_t>(blk.y) < height;
+	}
+};
+
+#endif //FLOW_FIELD_H
@@ -1,40 +1,52 @@
 #include "pch.h"
 #include "Game.h"
 #include "Utility.h"
-#include "Tower.h"
-#include "DataPaths.h"
+#include "TowerStore.h"
 #include "TowerSettings.h"
 #include "ResourceManager.h"
+#include "DataPaths.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+#include "RenderStats.h"
 
-#include "json_spirit/json_spirit.h"
-#include "jsex.h"
+#include <ctime>
 
-namespace fs = boost::filesystem;
-namespace js = json_spirit;
+static const float LOADING_BAR_WIDTH = 500;
 
-static const float SPAWN_TIME = .5f;
+static const float HP_BAR_WIDTH = 30.0f;
 
-static const float LOADING_BAR_WIDTH = 500;
+// Do not simulate more than this many ticks per frame (at normal speed). If a frame took
+// longer than that, the game slows down instead of trying to catch up forever.
+static const int MAX_TICKS_PER_FRAME = 10;
+
+// When running as fast as possible, simulate for this many seconds of real time per frame
+static const float MAX_SPEED_FRAME_BUDGET = 0.015f;
 
 #pragma warning (disable: 4355)
 Game::Game(RenderWindow& win, GlobalStatus& gs)
-: window(win), globalStatus(gs), userInterface(this, window, globalStatus, gameStatus, &map), running(true), loadingScreenBar(LOADING_BAR_WIDTH, 20)
-{ }
-
-// Compare towers by their y position, to ensure lower towers (= higher y pos) are drawn
-// later, so the overlap is displayed correctly.
-static bool CompByY(const std::shared_ptr<sf::Drawable>& a, const std::shared_ptr<sf::Drawable>& b)
+: window(win), globalStatus(gs), nightMode(false), loadingScreenBar(LOADING_BAR_WIDTH, 20), hpBarGreen(HP_BAR_WIDTH, 2.0f), hpBarRed(0.0f, 2.0f),
+  simulation(gs), tickAccumulator(0), userInterface(this, window, globalStatus, simulation.GetStatus(), &simulation.GetMap(), &simulation.GetTowers())
 {
-	return a->GetPosition().y < b->GetPosition().y;
+	simulation.SetRecorder(&replay);
+
+	hpBarGreen.SetColor(Color::Green);
+	hpBarRed.SetColor(Color::Red);
 }
 
 void Game::Reset()
 {
-	postfx.LoadFromFile("data/postfx.sfx");
-	postfx.SetTexture("framebuffer", nullptr);
+	PROFILE_ZONE("Game::Reset");
+	ALLOC_TAG("loading");
+
+	{
+		PROFILE_ZONE("Game::Reset/shaders");
+		postfx.LoadFromFile("data/postfx.sfx");
+		postfx.SetTexture("framebuffer", nullptr);
 
-	nightModeFx.LoadFromFile("data/night.sfx");
-	nightModeFx.SetTexture("framebuffer", nullptr);
+		nightModeFx.LoadFromFile("data/night.sfx");
+		nightModeFx.SetTexture("framebuffer", nullptr);
+	}
 
 	loadingScreenBackground.SetImage(gImageManager.getResource(gTheme.GetFileName("main-menu/background")));
 	loadingScreenBackground.SetPosition(0, 0);
@@ -42,69 +54,151 @@ void Game::Reset()
 	loadingScreenBar.SetColor(Color(255, 216, 0));
 	UpdateLoadingScreen(0.1f);
 
-	enemies.clear();
-	towers.clear();
-	projectiles.clear();
-
-	gameStatus.Reset(globalStatus);
-	UpdateLoadingScreen(0.2f);
-
-	auto levelPath = GetLevelPath(globalStatus.runTime.level);
-	auto levelFile = GetLevelFile(globalStatus.runTime.level);
-	level.LoadFromFile(levelPath / levelFile);
-	UpdateLoadingScreen(0.3f);
-
-	LoadEnemySettings();
-	UpdateLoadingScreen(0.4f);
+	unsigned int seed = static_cast<unsigned int>(std::time(nullptr));
+	simulation.Reset(globalStatus.runTime.level, seed, boost::bind(&Game::UpdateLoadingScreen, this, _1));
+	tickAccumulator = 0;
 
-	LoadFromFile(map, level.map);
-	map.Reset();
-	UpdateLoadingScreen(0.7f);
+	const Level& level = simulation.GetLevel();
+	nightMode = level.nightMode;
 
-	fireEffects.clear();
-	boost::for_each(map.GetFirePlaces(), [&](const Vector2f& pos) {
-		std::shared_ptr<FireEffect> fire(new FireEffect(window.GetWidth(), window.GetHeight()));
-		fire->SetFireTexture(&gImageManager.getResource("data/effects/fire.png"));
-		fire->SetNoiseTexture(&gImageManager.getResource("data/effects/noise.png"));
-		fire->SetAlphaTexture(&gImageManager.getResource("data/effects/alpha.png"));
+	{
+		PROFILE_ZONE("Game::Reset/fires");
+		fireEffects.clear();
+		boost::for_each(simulation.GetMap().GetFirePlaces(), [&](const Vector2f& pos) {
+			std::shared_ptr<FireEffect> fire(new FireEffect(window.GetWidth(), window.GetHeight()));
+			fire->SetFireTexture(&gImageManager.getResource("data/effects/fire.png"));
+			fire->SetNoiseTexture(&gImageManager.getResource("data/effects/noise.png"));
+			fire->SetAlphaTexture(&gImageManager.getResource("data/effects/alpha.png"));
 
-		fire->SetWidth(25);
-		fire->SetHeight(25);
-		fire->SetPosition(pos - Vector2f(12.5, 22));
+			fire->SetWidth(25);
+			fire->SetHeight(25);
+			fire->SetPosition(pos - Vector2f(12.5, 22));
 
-		fireEffects.emplace_back(std::move(fire));
-	});
-	boost::sort(fireEffects, CompByY);
-
-	gTheme.LoadTheme(level.theme);
-	userInterface.Reset(level);
-	UpdateLoadingScreen(0.9f);
+			fireEffects.emplace_back(std::move(fire));
+		});
+		boost::sort(fireEffects, CompByY);
+	}
 
-	// reset countdown and spawn timer here for the first wave
-	gameStatus.spawnTimer.Reset();
-	gameStatus.countdownTimer.Reset();
+	{
+		PROFILE_ZONE("Game::Reset/interface");
+		userInterface.Reset(level);
+	}
 	UpdateLoadingScreen(1.f);
-
-	running = true;
 }
 
 void Game::UpdateLoadingScreen(float pct)
 {
+	PROFILE_ZONE("Game::UpdateLoadingScreen");
+
 	loadingScreenBar.SetWidth(pct * LOADING_BAR_WIDTH);
 
-	window.Draw(loadingScreenBackground);
-	window.Draw(loadingScreenBar);
+	RenderStats::Draw(window, loadingScreenBackground);
+	RenderStats::Draw(window, loadingScreenBar);
 	window.Display();
 }
 
-static bool IsAtPoint(const std::shared_ptr<Tower>& twr, Vector2f pt)
+static bool IsAtPoint(const Tower& twr, Vector2f pt)
 {
-	return PointInRect(pt, twr->GetPosition() - twr->GetCenter(), static_cast<float>(twr->GetWidth()), static_cast<float>(twr->GetHeight()));
+	return PointInRect(pt, twr.GetPosition() - twr.GetCenter(), static_cast<float>(twr.GetWidth()), static_cast<float>(twr.GetHeight()));
 }
 
 // Main function of the game class, this gets called every frame.
 void Game::Run()
 {
+	// the profiler only runs while debug is on, otherwise the zones cost next to nothing
+	Profiler& profiler = Profiler::Instance();
+	profiler.SetEnabled(globalStatus.debug.enabled);
+	profiler.BeginFrame();
+
+	RenderStats& renderStats = RenderStats::Instance();
+	renderStats.SetEnabled(globalStatus.debug.enabled);
+	AllocTracker::SetEnabled(globalStatus.debug.enabled);
+
+	{
+		PROFILE_ZONE("Game::Run");
+
+		HandleEvents();
+
+		float elapsed = window.GetFrameTime();
+
+		UpdateSimulation(elapsed);
+		if (!simulation.IsRunning())
+			SaveReplay();
+
+		if (nightMode) {
+			PROFILE_ZONE("FireEffect::Update");
+			ALLOC_TAG("effects");
+			boost::for_each(fireEffects, [&](const std::shared_ptr<FireEffect>& fire) {
+				fire->Update(elapsed);
+			});
+		}
+
+		userInterface.Update();
+
+		Draw();
+	}
+
+	profiler.EndFrame();
+	renderStats.EndFrame();
+	AllocTracker::EndFrame();
+}
+
+void Game::UpdateSimulation(float elapsed)
+{
+	PROFILE_ZONE("Game::UpdateSimulation");
+
+	const SimClock& clock = simulation.GetStatus().clock;
+
+	if (clock.IsPaused()) {
+		tickAccumulator = 0;
+		return;
+	}
+
+	if (clock.GetSpeed() == SimClock::AsFastAsPossible) {
+		// Simulate as many ticks as fit into the frame budget
+		Clock budget;
+		do {
+			simulation.Update(SIM_TICK);
+		} while (budget.GetElapsedTime() < MAX_SPEED_FRAME_BUDGET && simulation.IsRunning());
+
+		tickAccumulator = 0;
+		return;
+	}
+
+	// Advance the simulation in fixed steps, keep the remainder for the next frame
+	float scale = clock.GetScale();
+	int maxTicks = static_cast<int>(MAX_TICKS_PER_FRAME * scale);
+
+	tickAccumulator += elapsed * scale;
+	int ticks = 0;
+	while (tickAccumulator >= SIM_TICK && ticks < maxTicks) {
+		simulation.Update(SIM_TICK);
+		tickAccumulator -= SIM_TICK;
+		ticks++;
+	}
+	if (ticks == maxTicks)
+		tickAccumulator = 0;
+}
+
+void Game::SaveReplay()
+{
+	auto fn = GetReplayFile();
+	LOG(Msg, "Game ended, saving replay to " << fn.string());
+
+	// a failed replay should not take the game down
+	try {
+		replay.WriteToFile(fn);
+	}
+	catch (boost::exception&) {
+		LOG(Error, "Failed to write replay " << fn.string());
+	}
+}
+
+void Game::HandleEvents()
+{
+	PROFILE_ZONE("Game::HandleEvents");
+	ALLOC_TAG("input");
+
 	// Handle all SFML events
 	Event event;
 	while (window.GetEvent(event)) {
@@ -115,16 +209,46 @@ void Game::Run()
 		if (userInterface.HandleEvent(event))
 			continue;
 
+		// game speed
+		if (event.Type == Event::KeyReleased) {
+			SimClock& clock = simulation.GetStatus().clock;
+
+			switch (event.Key.Code) {
+			case Key::Num1:
+				clock.SetSpeed(SimClock::Normal);
+				break;
+
+			case Key::Num2:
+				clock.SetSpeed(SimClock::Double);
+				break;
+
+			case Key::Num3:
+				clock.SetSpeed(SimClock::Quadruple);
+				break;
+
+			case Key::Num4:
+				clock.SetSpeed(SimClock::AsFastAsPossible);
+				break;
+
+			case Key::Space:
+				clock.SetPaused(!clock.IsPaused());
+				break;
+
+			case Key::Return:
+				simulation.SkipCountdown();
+				break;
+			}
+		}
+
 		// some debug keys
 		if (event.Type == Event::KeyReleased) {
 			switch (event.Key.Code) {
 			case Key::G:
-				SpawnEnemy(0, 0);
+				simulation.SpawnEnemy(0, 0);
 				break;
 
 			case Key::Q:
-				gameStatus.lives = 1;
-				LooseLife();
+				simulation.Forfeit();
 				break;
 
 			case Key::X:
@@ -132,265 +256,164 @@ void Game::Run()
 				break;
 
 			case Key::N:
-				level.nightMode = !level.nightMode;
+				nightMode = !nightMode;
 			}
 		}
 		else if (event.Type == Event::MouseButtonReleased && event.MouseButton.Button == Mouse::Left) {
 			Vector2f pos(static_cast<float>(event.MouseButton.X), static_cast<float>(event.MouseButton.Y));
 
-			// make a reversed copy of the towers so that the lowest one gets selected
-			std::vector<std::shared_ptr<Tower>> revTowers = towers;
-			boost::reverse(revTowers);
-
-			auto it = boost::find_if(revTowers, boost::bind(IsAtPoint, _1, pos));
-			if (it != revTowers.end())
-				userInterface.TowerSelected(*it);
-			else
-				userInterface.TowerSelected(nullptr);
+			// go through the towers backwards so that the lowest one gets selected
+			const TowerStore& towers = simulation.GetTowers();
+			Handle selected = NO_HANDLE;
+			for (size_t i = towers.GetSize(); i > 0 && selected == NO_HANDLE; --i) {
+				if (IsAtPoint(towers.Get(i-1), pos))
+					selected = towers.GetHandle(i-1);
+			}
+			userInterface.TowerSelected(selected);
 
 		}
 	}
+}
 
-	float elapsed = window.GetFrameTime();
+void Game::Draw()
+{
+	PROFILE_ZONE("Game::Draw");
+	ALLOC_TAG("rendering");
+
+	const TowerStore& towers = simulation.GetTowers();
+	const EnemyStore& enemies = simulation.GetEnemies();
+	const std::vector<uint32_t>& enemiesByY = simulation.GetEnemiesByY();
+	const World& world = simulation.GetWorld();
+
+	{
+		PROFILE_ZONE("Map::Draw");
+		RenderCategory category(RenderStats::Map);
+		window.Clear();
+		simulation.GetMap().Draw(window);
+		userInterface.PreDraw();
+	}
 
-	// Update the wave state
-	UpdateWave();
+	{
+		PROFILE_ZONE("Game::DrawSprites");
+		RenderCategory category(RenderStats::Sprites);
 
-	// Go through all enemies, projectiles and towers and update them
-	for (auto it = enemies.begin(); it != enemies.end(); ++it) {
-		std::shared_ptr<Enemy> e = *it;
-		e->Update(elapsed);
-		// If an enemy reached the target area and did not strike yet,
-		// let them strike and loose a life. Poor player )-:
-		if (e->IsAtTarget() && !e->DidStrike()) {
-			e->Strike();
-			LooseLife();
+		// draw the night mode shader before the towers, so they do not get too dark
+		if (nightMode) {
+			RenderCategory category(RenderStats::Effects);
+			RenderStats::Draw(window, nightModeFx);
 		}
-	}
-	for (auto it = projectiles.begin(); it != projectiles.end(); ++it)
-		(*it)->Update(elapsed);
-	for (auto it = towers.begin(); it != towers.end(); ++it)
-		(*it)->Update(elapsed);
-
-	if (level.nightMode) {
-		boost::for_each(fireEffects, [&](const std::shared_ptr<FireEffect>& fire) {
-			fire->Update(elapsed);
-		});
-	}
 
-	// grant money for dead enemies
-	boost::for_each(enemies, [&](const std::shared_ptr<Enemy>& e) {
-		if (e->IsDead())
-			gameStatus.money += gStatus.moneyPerEnemy * e->GetMoneyFactor();
-	});
-
-	// Remove all the things no longer needed
-	projectiles.erase(boost::remove_if(projectiles, [](const std::unique_ptr<Projectile>& p) {
-			return p->DidHit();
-		}), projectiles.end());
-	enemies.erase(boost::remove_if(enemies, [](const std::shared_ptr<Enemy>& e) {
-			return e->IsIrrelevant();
-		}), enemies.end());
-	towers.erase(boost::remove_if(towers, [&](const std::shared_ptr<Tower>& t) mutable -> bool {
-			if (t->IsSold()) {
-				this->map.RemoveTower(t->GetPosition());
-				return true;
+		// merge towers, enemies and possibly fires by their y position to correctly treat
+		// overlap, on the same position towers go first and enemies last
+		const size_t numFires = nightMode ? fireEffects.size() : 0;
+		const float end = std::numeric_limits<float>::max();
+		size_t t = 0, f = 0, e = 0;
+		while (t < towers.GetSize() || f < numFires || e < enemiesByY.size()) {
+			const float ty = t < towers.GetSize() ? towers.Get(t).GetPosition().y : end;
+			const float fy = f < numFires ? fireEffects[f]->GetPosition().y : end;
+			const float ey = e < enemiesByY.size() ? enemies.GetPosition(enemiesByY[e]).y : end;
+
+			if (t < towers.GetSize() && ty <= fy && ty <= ey)
+				RenderStats::Draw(window, towers.Get(t++));
+			else if (f < numFires && fy <= ey) {
+				// the fires are sorted in between the sprites, but count as effects
+				RenderCategory category(RenderStats::Effects);
+				RenderStats::Draw(window, *fireEffects[f++]);
 			}
-			return false;
-		}), towers.end());
-
-	userInterface.Update();
-
-	boost::sort(enemies, CompByY);
-
-	// And draw all the stuff
-	window.Clear();
-	map.Draw(window);
-	userInterface.PreDraw();
-
-	// keep towers, enemies and possibly fires sorted by their y position to correctly treat overlap
-	std::vector<std::shared_ptr<Drawable>> sprites;
-
-	if (level.nightMode) {
-		sprites.reserve(towers.size() + enemies.size() + fireEffects.size());
+			else
+				DrawEnemy(enemies, enemiesByY[e++]);
+		}
 
-		std::vector<std::shared_ptr<Drawable>> towersAndFires;
-		boost::merge(towers, fireEffects, std::back_inserter(towersAndFires), CompByY);
-		boost::merge(towersAndFires, enemies, std::back_inserter(sprites), CompByY);
-	}
-	else {
-		sprites.reserve(towers.size() + enemies.size());
-		boost::merge(towers, enemies, std::back_inserter(sprites), CompByY);
+		RenderCategory projectileCategory(RenderStats::Projectiles);
+		world.ForEach(Bit(TransformId) | Bit(ProjectileId), [&](const World::Archetype& a) {
+			const std::vector<Transform>& transforms = world.Read<Transform>(a);
+			const std::vector<Projectile>& projectiles = world.Read<Projectile>(a);
+			for (size_t i=0; i < a.GetSize(); ++i) {
+				const Image& img = *projectiles[i].image;
+				projectileSprite.SetImage(img);
+				projectileSprite.SetSubRect(IntRect(0, 0, img.GetWidth(), img.GetHeight()));
+				projectileSprite.SetCenter(img.GetWidth() / 2.0f, img.GetHeight() / 2.0f);
+				projectileSprite.SetPosition(transforms[i].pos);
+				projectileSprite.SetRotation(transforms[i].rotation);
+				RenderStats::Draw(window, projectileSprite);
+			}
+		});
 	}
 
-	// draw the night mode shader before the towers, so they do not get too dark
-	if (level.nightMode)
-		window.Draw(nightModeFx);
-
-	boost::for_each(sprites, [&](const std::shared_ptr<Drawable>& sprite) {
-		std::shared_ptr<Enemy> e = std::dynamic_pointer_cast<Enemy>(sprite);
-		if (e)
-			e->DrawHpBar(window);
-		window.Draw(*sprite);
-	});
-	
-	for (auto it = projectiles.begin(); it != projectiles.end(); ++it)
-		window.Draw(*(*it));
-
-	if (gStatus.settings.useShader)
-		window.Draw(postfx);
+	if (gStatus.settings.useShader) {
+		PROFILE_ZONE("Game::DrawPostFX");
+		RenderCategory category(RenderStats::Effects);
+		RenderStats::Draw(window, postfx);
+	}
 
 	// Draw the user interface at last, so it does not get hidden by any objects
-	userInterface.Draw();
-
-	window.Display();
-}
-
-void Game::UpdateWave()
-{
-	if (gameStatus.currentWave >= level.waves.size()) {
-		// if we finished the last wave, the game has ended
-		if (enemies.size() == 0)
-			running = false;
-
-		// return even if there are still enemies, there is nothing wave related to handle 
-		// anymore (and currentWave points to the wave after the end of gameStatus.waves (-; )
-		return;
+	{
+		RenderCategory category(RenderStats::UserInterface);
+		userInterface.Draw();
 	}
 
-	Level::Wave& currentWave = level.waves[gameStatus.currentWave];
-
-	switch (gameStatus.waveState) {
-	case GameStatus::InCountdown:
-		// We are in the InCountdown state. If the countdown has elapsed, begin to spawn
-		// the enemies by proceeding to the InSpawn state;
-		if (gameStatus.countdownTimer.GetElapsedTime() > currentWave.countdown) {
-			gameStatus.waveState = GameStatus::InSpawn;
-
-			// copy the enemies to spawn to a stack
-			enemiesToSpawn.clear();
-			enemiesToSpawn.resize(currentWave.enemies.size());
-			for (size_t spawnPt = 0; spawnPt < currentWave.enemies.size(); ++spawnPt) {
-				boost::for_each(currentWave.enemies[spawnPt], [&](size_t tp) {
-					enemiesToSpawn[spawnPt].push(tp);
-				});
-			}
-
-			gameStatus.waveTimer.Reset();
-		}
-		break;
-	case GameStatus::InSpawn:
-		// In the spawn state see if the spawn timer has elapsed and then spawn an enemy.
-		// If all enemies for this wave are spawned proceed to the InWave state
-		if (gameStatus.spawnTimer.GetElapsedTime() > SPAWN_TIME) {
-
-			bool spawned = false;
-			for (size_t spawnPt = 0; spawnPt < std::min(enemiesToSpawn.size(), map.GetNumSpawns()); ++spawnPt) {
-				if (enemiesToSpawn[spawnPt].size() > 0) {
-					SpawnEnemy(enemiesToSpawn[spawnPt].front(), spawnPt);
-					enemiesToSpawn[spawnPt].pop();
-					gameStatus.spawnTimer.Reset();
-					spawned = true;
-				}
-			}
-
-			// everything is spawned, proceeed to InWave
-			if (!spawned) {
-				gameStatus.waveState = GameStatus::InWave;
-			}
-		}
-		break;
-	case GameStatus::InWave:
-		// In the InWave state wait untill all enemies are killed or the maximal time for the wave has 
-		// elapsed, then proceed to the next wave.
-		// Reset both countdownTimer and spawnTimer here, so the first spawn will happen immediatly when
-		// the wave countdown finished (as long as countdown > SPAWN_TIME).
-		if (enemies.size() == 0 || (currentWave.maxTime != 0 && gameStatus.waveTimer.GetElapsedTime() > currentWave.maxTime)) {
-			gameStatus.currentWave++;
-			gameStatus.waveState = GameStatus::InCountdown;
-			gameStatus.countdownTimer.Reset();
-			gameStatus.spawnTimer.Reset();
-		}
-		break;
+	if (globalStatus.debug.enabled) {
+		PROFILE_ZONE("DebugOverlay::Draw");
+		ALLOC_TAG("debug overlay");
+		RenderCategory category(RenderStats::Overlay);
+		debugOverlay.Draw(window);
 	}
+
+	PROFILE_ZONE("RenderWindow::Display");
+	window.Display();
 }
 
-void Game::LooseLife()
+void Game::DrawEnemy(const EnemyStore& enemies, size_t i)
 {
-	gameStatus.lives--;
-	if (gameStatus.lives <= 0) {
-		running = false;
+	const EnemySettings& settings = enemies.GetSettings(i);
+	const Vector2f pos = enemies.GetPosition(i);
+
+	{
+		RenderCategory category(RenderStats::HpBars);
+		float greenPct = enemies.GetLife(i) / ENEMY_LIFE;
+		hpBarGreen.SetWidth(greenPct * HP_BAR_WIDTH);
+		hpBarRed.SetWidth((1 - greenPct) * HP_BAR_WIDTH);
+
+		hpBarGreen.SetPosition(pos + Vector2f(HP_BAR_WIDTH / -2.0f, -static_cast<float>(settings.height) - 5.0f));
+		hpBarRed.SetPosition(hpBarGreen.GetPosition() + Vector2f(hpBarGreen.GetWidth(), 0));
+		RenderStats::Draw(window, hpBarGreen);
+		RenderStats::Draw(window, hpBarRed);
 	}
+
+	enemySprite.SetImage(*settings.image);
+	enemySprite.SetSize(settings.width, settings.height);
+	enemySprite.SetOffset(settings.offset);
+	enemySprite.SetFrameTime(settings.frameTime);
+	enemySprite.SetNumFrames(settings.numFrames);
+	enemySprite.SetDirection(enemies.GetFacing(i));
+	enemySprite.SetTime(enemies.GetAge(i));
+	enemySprite.SetPosition(pos);
+	RenderStats::Draw(window, enemySprite);
 }
 
 bool Game::IsRunning()
 {
-	return running;
+	return simulation.IsRunning();
 }
 
 State Game::GetNextState()
 {
-	if (gameStatus.lives > 0)
+	if (simulation.GetStatus().lives > 0)
 		return ST_WIN;
 	return ST_LOOSE;
 }
 
-void Game::LoadEnemySettings()
+void Game::AddTower(const TowerSettings* settings, Vector2f pos)
 {
-	if (level.theme == prevTheme)
-		return; // already loaded
-
-	fs::path themePath = GetThemePath(level.theme);
-	fs::path enemyDef = themePath / EnemyDefinitionFile;
-
-	std::ifstream in(enemyDef.string());
-	js::mValue rootValue;
-	try {
-		js::read_or_throw(in, rootValue);
-	}
-	catch (js::Error_position err) {
-		throw GameError() << ErrorInfo::Desc("Invalid json file") << ErrorInfo::Note(err.reason_) << boost::errinfo_at_line(err.line_) << boost::errinfo_file_name(enemyDef.string());
-	}
-
-	if (rootValue.type() != js::obj_type)
-		throw GameError() << ErrorInfo::Desc("Root value is not an object") << boost::errinfo_file_name(enemyDef.string());
-
-	js::mObject rootObj = rootValue.get_obj();
-
-	js::mArray& enemies = rootObj["enemies"].get_array();
-	enemySettings.clear();
-	enemySettings.resize(enemies.size());
-	for (size_t i=0; i < enemies.size(); ++i) {
-		js::mObject& def = enemies[i].get_obj();
-
-		enemySettings[i].image     = &gImageManager.getResource((themePath / def["image"].get_str()).string());
-		enemySettings[i].width     = def["width"].get_int();
-		enemySettings[i].height    = def["height"].get_int();
-		enemySettings[i].offset    = def["offset"].get_int();
-		enemySettings[i].numFrames = def["frames"].get_int();
-		enemySettings[i].frameTime = jsex::get<float>(def["frame-time"]);
-		
-		enemySettings[i].life  = def["life"].get_int();
-		enemySettings[i].speed = jsex::get<float>(def["speed"]);
-		enemySettings[i].moneyFactor = def["money-factor"].get_int();
-	}
+	simulation.AddTower(settings, pos);
 }
 
-void Game::SpawnEnemy(size_t type, size_t spawn)
+void Game::UpgradeTower(Vector2f pos)
 {
-	std::shared_ptr<Enemy> e(new Enemy(enemySettings[type], &map));
-	e->SetPosition(map.GetSpawnPosition(spawn));
-	e->SetTarget(map.GetDefaultTarget());
-	enemies.push_back(e);
+	simulation.UpgradeTower(pos);
 }
 
-void Game::AddTower(const TowerSettings* settings, Vector2f pos)
+void Game::SellTower(Vector2f pos)
 {
-	gameStatus.money -= settings->baseCost;
-
-	std::shared_ptr<Tower> tower = Tower::CreateTower(settings, enemies, projectiles, map.IsHighRange(pos));
-	tower->SetPosition(pos);
-	towers.emplace_back(std::move(tower));
-	boost::sort(towers, CompByY);
-	map.PlaceTower(pos);
+	simulation.SellTower(pos);
 }
@@ -5,19 +5,17 @@
 #include "GameStatus.h"
 #include "GlobalStatus.h"
 #include "State.h"
-#include "Enemy.h"
-#include "Map.h"
-#include "Tower.h"
-#include "Projectile.h"
+#include "Simulation.h"
+#include "Replay.h"
 #include "Theme.h"
 #include "LevelMetaInfo.h"
-#include "EnemySettings.h"
 #include "Rectangle.h"
 #include "FireEffect.h"
-#include "Level.h"
+#include "DebugOverlay.h"
 
 struct TowerSettings;
 
+// Renders the simulation and feeds the player input into it.
 class Game
 {
 	RenderWindow& window;
@@ -33,23 +31,22 @@ class Game
 	Sprite loadingScreenBackground;
 	sfext::Rectangle loadingScreenBar;
 
-	std::string prevTheme;
-	std::vector<EnemySettings> enemySettings;
-	std::vector<std::shared_ptr<Enemy>> enemies;
+	std::vector<std::shared_ptr<FireEffect>> fireEffects;
 
-	// TODO: replace by std::set?
-	std::vector<std::shared_ptr<Tower>> towers;
+	// drawn once for every enemy and projectile
+	AnimSprite enemySprite;
+	sfext::Rectangle hpBarGreen, hpBarRed;
+	Sprite projectileSprite;
 
-	std::vector<std::unique_ptr<Projectile>> projectiles;
+	Simulation simulation;
+	float tickAccumulator;
 
-	std::vector<std::shared_ptr<FireEffect>> fireEffects;
+	// the current game gets recorded and saved when it ends
+	Replay replay;
 
-	Map map;
-	GameStatus gameStatus;
 	GameUserInterface userInterface;
-	
-	Level level;
-	std::vector<std::queue<size_t>> enemiesToSpawn;
+
+	DebugOverlay debugOverlay;
 
 public:
 	Game(RenderWindow& win, GlobalStatus& gs);
@@ -61,18 +58,17 @@ public:
 	State GetNextState();
 
 	void AddTower(const TowerSettings* settings, Vector2f pos);
+	void UpgradeTower(Vector2f pos);
+	void SellTower(Vector2f pos);
 
 private:
-	bool running;
-
-	void UpdateWave();
-	void SpawnEnemy(size_t type, size_t spawn);
-
-	void LooseLife();
-
-	void LoadEnemySettings();
+	void HandleEvents();
+	void UpdateSimulation(float elapsed);
+	void Draw();
+	void DrawEnemy(const EnemyStore& enemies, size_t i);
 
 	void UpdateLoadingScreen(float pct);
+	void SaveReplay();
 };
 
 #endif //GAME_H
@@ -2,6 +2,7 @@
 #define GAME_STATUS_H
 
 #include "GlobalStatus.h"
+#include "SimClock.h"
 
 struct GameStatus
 {
@@ -13,15 +14,22 @@ struct GameStatus
 		InCountdown, InSpawn, InWave,
 	} waveState;
 
-	Clock spawnTimer, waveTimer, countdownTimer;
+	// all wave timers run on the simulation clock
+	SimClock clock;
+	SimTimer spawnTimer, waveTimer, countdownTimer;
 
-	// Call reset at the begin of Game::Reset before loading the level data
+	GameStatus()
+	: spawnTimer(clock), waveTimer(clock), countdownTimer(clock)
+	{ }
+
+	// Call reset at the begin of Simulation::Reset before loading the level data
 	void Reset(const GlobalStatus& gs)
 	{
 		lives = gs.startLives;
 		money = gs.startMoney;
 		currentWave = 0;
 		waveState = InCountdown;
+		clock.Reset();
 	}
 };
 
@@ -7,9 +7,13 @@
 #include "Level.h"
 #include "TowerPlacer.h"
 #include "TowerSettings.h"
+#include "TowerStore.h"
 #include "ResourceManager.h"
 #include "Utility.h"
 #include "UiHelper.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+#include "RenderStats.h"
 
 using boost::lexical_cast;
 
@@ -19,8 +23,8 @@ static const float TEXT_UPDATE_TIME = 0.2f;
 static const float MARKER_RADIUS = 12.5f;
 static const Color ColorMarker(0, 0, 255, 32);
 
-GameUserInterface::GameUserInterface(Game* game, RenderWindow& window, GlobalStatus& globalStatus, GameStatus& gameStatus, const Map* map)
-: game(game), window(window), globalStatus(globalStatus), gameStatus(gameStatus), map(map)
+GameUserInterface::GameUserInterface(Game* game, RenderWindow& window, GlobalStatus& globalStatus, GameStatus& gameStatus, const Map* map, const TowerStore* towers)
+: window(window), globalStatus(globalStatus), gameStatus(gameStatus), map(map), towers(towers), game(game), selectedTower(NO_HANDLE)
 { }
 
 void GameUserInterface::Reset(const Level& metaInfo)
@@ -54,7 +58,7 @@ void GameUserInterface::Reset(const Level& metaInfo)
 
 	InitButton(btnUpgrade, "buttons/upgrade");
 	InitButton(btnSell, "buttons/sell");
-	TowerSelected(nullptr);
+	TowerSelected(NO_HANDLE);
 
 	levelName.SetFont(gTheme.GetMainFont());
 	levelName.SetText(metaInfo.name);
@@ -77,6 +81,9 @@ void GameUserInterface::Reset(const Level& metaInfo)
 
 void GameUserInterface::Update()
 {
+	PROFILE_ZONE("GameUserInterface::Update");
+	ALLOC_TAG("interface");
+
 	if (textUpdateClock.GetElapsedTime() > TEXT_UPDATE_TIME) {
 		UpdateText();
 		textUpdateClock.Reset();
@@ -85,7 +92,7 @@ void GameUserInterface::Update()
 	tooltip.Clear();
 	for (size_t i=0; i < towerButtons.size(); ++i) {
 		if (towerButtons[i].WasClicked()) {
-			TowerSelected(nullptr); // clear selected tower when placing a new one
+			TowerSelected(NO_HANDLE); // clear selected tower when placing a new one
 			StartPlacingTower(i);
 		}
 
@@ -104,60 +111,63 @@ void GameUserInterface::Update()
 		}
 	}
 
-	if (selectedTower) {
-		if (btnUpgrade.MouseOver() && selectedTower->CanUpgrade()) // FIXME: Buttons should handle visibility state
-			tooltip.SetTower(selectedTower->GetSettings(), Tooltip::Upgrade);
+	if (const Tower* tower = GetSelectedTower()) {
+		if (btnUpgrade.MouseOver() && tower->CanUpgrade()) // FIXME: Buttons should handle visibility state
+			tooltip.SetTower(tower->GetSettings(), Tooltip::Upgrade);
 		else if (btnSell.MouseOver())
-			tooltip.SetTower(selectedTower->GetSettings(), Tooltip::Sell);
+			tooltip.SetTower(tower->GetSettings(), Tooltip::Sell);
 		else if (tooltip.GetMode() == Tooltip::Hidden)
-			tooltip.SetTower(selectedTower->GetSettings(), Tooltip::Selected);
+			tooltip.SetTower(tower->GetSettings(), Tooltip::Selected);
 
-		if (btnUpgrade.WasClicked() && selectedTower->CanUpgrade()) {
-			selectedTower->Upgrade();
-			btnUpgrade.SetVisible(selectedTower->CanUpgrade());
+		if (btnUpgrade.WasClicked() && tower->CanUpgrade()) {
+			game->UpgradeTower(tower->GetPosition());
+			btnUpgrade.SetVisible(tower->CanUpgrade());
 		}
 		if (btnSell.WasClicked()) {
-			gameStatus.money += selectedTower->Sell();
-			TowerSelected(nullptr);
+			game->SellTower(tower->GetPosition());
+			TowerSelected(NO_HANDLE);
 		}
 	}
 }
 
 void GameUserInterface::PreDraw()
 {
-	if (selectedTower)
-		selectedTower->DrawRangeCircle(window);
+	if (const Tower* tower = GetSelectedTower())
+		tower->DrawRangeCircle(window);
 }
 
 void GameUserInterface::Draw()
 {
+	PROFILE_ZONE("GameUserInterface::Draw");
+	ALLOC_TAG("interface");
+
 	if (towerPlacer) {
 		boost::for_each(towerMarkers, [&](const Shape& s) {
-			window.Draw(s);
+			RenderStats::Draw(window, s);
 		});
 		towerPlacer->DrawRangeCircle(window, map->IsHighRange(towerPlacer->GetPosition()));
-		window.Draw(*towerPlacer);
+		RenderStats::Draw(window, *towerPlacer);
 	}
 
-	window.Draw(topPanel);
-	window.Draw(bottomPanel);
+	RenderStats::Draw(window, topPanel);
+	RenderStats::Draw(window, bottomPanel);
 
-	window.Draw(levelName);
-	window.Draw(lives);
-	window.Draw(money);
+	RenderStats::Draw(window, levelName);
+	RenderStats::Draw(window, lives);
+	RenderStats::Draw(window, money);
 
 	boost::for_each(decoration, [&](const Sprite& sp) {
-		window.Draw(sp);
+		RenderStats::Draw(window, sp);
 	});
 
-	window.Draw(btnUpgrade);
-	window.Draw(btnSell);
+	RenderStats::Draw(window, btnUpgrade);
+	RenderStats::Draw(window, btnSell);
 
 	for (auto it = towerButtons.begin(); it != towerButtons.end(); ++it)
-		window.Draw(*it);
+		RenderStats::Draw(window, *it);
 
 	if (showCountdown)
-		window.Draw(countdown);
+		RenderStats::Draw(window, countdown);
 
 	tooltip.Draw(window);
 }
@@ -218,16 +228,13 @@ void GameUserInterface::StartPlacingTower(size_t id)
 	}
 }
 
-void GameUserInterface::TowerSelected(std::shared_ptr<Tower> tower)
+void GameUserInterface::TowerSelected(Handle tower)
 {
-	if (selectedTower)
-		selectedTower.reset();
-
 	selectedTower = tower;
 
-	if (selectedTower) {
+	if (const Tower* selected = GetSelectedTower()) {
 		btnSell.Show();
-		btnUpgrade.SetVisible(selectedTower->CanUpgrade());
+		btnUpgrade.SetVisible(selected->CanUpgrade());
 	}
 	else {
 		btnSell.Hide();
@@ -235,6 +242,12 @@ void GameUserInterface::TowerSelected(std::shared_ptr<Tower> tower)
 	}
 }
 
+const Tower* GameUserInterface::GetSelectedTower() const
+{
+	const size_t row = towers->Find(selectedTower);
+	return row != TowerStore::NO_ROW ? &towers->Get(row) : nullptr;
+}
+
 void GameUserInterface::Tooltip::SetTower(const TowerSettings* tower, Mode md)
 {
 	using std::string;
@@ -279,7 +292,7 @@ void GameUserInterface::Tooltip::Clear()
 
 void GameUserInterface::Tooltip::Draw(RenderTarget& target)
 {
-	target.Draw(title);
+	RenderStats::Draw(target, title);
 
 	switch (mode) {
 	case Hidden:
@@ -287,8 +300,8 @@ void GameUserInterface::Tooltip::Draw(RenderTarget& target)
 
 	case Preview:
 		//target.Draw(title);
-		target.Draw(cost);
-		target.Draw(coin);
+		RenderStats::Draw(target, cost);
+		RenderStats::Draw(target, coin);
 		break;
 
 	case Selected:
@@ -297,16 +310,16 @@ void GameUserInterface::Tooltip::Draw(RenderTarget& target)
 
 	case Upgrade:
 		//target.Draw(title);
-		target.Draw(subtitle);
-		target.Draw(cost);
-		target.Draw(coin);
+		RenderStats::Draw(target, subtitle);
+		RenderStats::Draw(target, cost);
+		RenderStats::Draw(target, coin);
 		break;
 
 	case Sell:
 		//target.Draw(title);
-		target.Draw(subtitle);
-		target.Draw(cost);
-		target.Draw(coin);
+		RenderStats::Draw(target, subtitle);
+		RenderStats::Draw(target, cost);
+		RenderStats::Draw(target, coin);
 		break;
 	}
 }
@@ -4,12 +4,14 @@
 #include "Button.h"
 #include "Theme.h"
 #include "TowerPlacer.h"
+#include "HandlePool.h"
 #include "sfex.h"
 
 class Map;
 class Game;
 class Theme;
 class Tower;
+class TowerStore;
 struct GlobalStatus;
 struct GameStatus;
 struct Level;
@@ -21,6 +23,7 @@ class GameUserInterface
 	GlobalStatus& globalStatus;
 	GameStatus& gameStatus;
 	const Map* map;
+	const TowerStore* towers;
 	Game* game;
 
 	const Level* levelInfo;
@@ -79,10 +82,10 @@ class GameUserInterface
 	std::unique_ptr<TowerPlacer> towerPlacer;
 	std::vector<Shape> towerMarkers;
 
-	std::shared_ptr<Tower> selectedTower;
+	Handle selectedTower;
 
 public:
-	GameUserInterface(Game* game, RenderWindow& window, GlobalStatus& globalStatus, GameStatus& gameStatus, const Map *map);
+	GameUserInterface(Game* game, RenderWindow& window, GlobalStatus& globalStatus, GameStatus& gameStatus, const Map *map, const TowerStore* towers);
 
 	void Update();
 
@@ -90,13 +93,17 @@ public:
 	void Draw();
 	void Reset(const Level& metaInfo);
 
-	void TowerSelected(std::shared_ptr<Tower> tower);
+	// Select the tower or nothing with NO_HANDLE
+	void TowerSelected(Handle tower);
 
 	bool HandleEvent(sf::Event& event);
 
 private:
 	void UpdateText();
 
+	// The selected tower, nullptr if none is selected or it was removed
+	const Tower* GetSelectedTower() const;
+
 	void StartPlacingTower(size_t id);
 
 	void LoadDefinition();
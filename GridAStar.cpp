@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "GridAStar.h"
+#include "NavGrid.h"
+#include "Profiler.h"
+
+// left, right, up, down, the same order as the flow fields
+static const int OFFSET_X[] = { -1, 1, 0, 0 };
+static const int OFFSET_Y[] = { 0, 0, -1, 1 };
+static const size_t NUM_NEIGHBORS = 4;
+
+static const uint32_t NO_NODE = 0xffffffff;
+
+GridAStar::GridAStar()
+: grid(nullptr), width(0), height(0), generation(0), numExpanded(0)
+{ }
+
+void GridAStar::SetGrid(const NavGrid& gr)
+{
+	grid = &gr;
+	width = gr.GetWidth();
+	height = gr.GetHeight();
+
+	const size_t numNodes = width * height;
+	generation = 0;
+	nodeGeneration.assign(numNodes, 0);
+	g.resize(numNodes);
+	f.resize(numNodes);
+	parent.resize(numNodes);
+	heapIndex.resize(numNodes);
+	closed.assign((numNodes + 63) / 64, 0);
+	closedWords.clear();
+	closedWords.reserve(closed.size());
+
+	heap.clear();
+	heap.reserve(numNodes);
+}
+
+bool GridAStar::FindPath(const Vector2i& start, const Vector2i& goal, std::vector<Vector2i>& path)
+{
+	PROFILE_ZONE("GridAStar::FindPath");
+
+	path.clear();
+	numExpanded = 0;
+
+	if (!grid || !grid->Contains(start) || !grid->Contains(goal) || !grid->IsWalkable(goal.x, goal.y))
+		return false;
+
+	// a new generation marks all nodes as unvisited, start over once it wraps
+	if (++generation == 0) {
+		boost::fill(nodeGeneration, 0);
+		generation = 1;
+	}
+	for (auto it = closedWords.begin(); it != closedWords.end(); ++it)
+		closed[*it] = 0;
+	closedWords.clear();
+	heap.clear();
+
+	auto estimate = [&](int x, int y) {
+		return static_cast<uint32_t>(std::abs(x - goal.x) + std::abs(y - goal.y));
+	};
+
+	const uint32_t startNode = static_cast<uint32_t>(start.x + start.y * width);
+	const uint32_t goalNode = static_cast<uint32_t>(goal.x + goal.y * width);
+
+	nodeGeneration[startNode] = generation;
+	g[startNode] = 0;
+	f[startNode] = estimate(start.x, start.y);
+	parent[startNode] = NO_NODE;
+	Push(startNode);
+
+	while (!heap.empty()) {
+		uint32_t cur = Pop();
+		if (cur == goalNode)
+			break;
+
+		SetClosed(cur);
+		numExpanded++;
+
+		int x = static_cast<int>(cur % width);
+		int y = static_cast<int>(cur / width);
+		const uint8_t walkable = grid->GetNeighbors(x, y);
+		for (size_t n=0; n < NUM_NEIGHBORS; ++n) {
+			if (!(walkable & (1 << n)))
+				continue;
+
+			int nx = x + OFFSET_X[n];
+			int ny = y + OFFSET_Y[n];
+
+			uint32_t nb = static_cast<uint32_t>(nx + ny * width);
+			if (IsClosed(nb))
+				continue;
+
+			uint32_t newG = g[cur] + 1;
+			if (nodeGeneration[nb] != generation) {
+				nodeGeneration[nb] = generation;
+				g[nb] = newG;
+				f[nb] = newG + estimate(nx, ny);
+				parent[nb] = cur;
+				Push(nb);
+			}
+			else if (newG < g[nb]) {
+				// the heuristic is consistent, so only open nodes can get cheaper
+				f[nb] -= g[nb] - newG;
+				g[nb] = newG;
+				parent[nb] = cur;
+				SiftUp(heapIndex[nb]);
+			}
+		}
+	}
+
+	if (nodeGeneration[goalNode] != generation)
+		return false;
+
+	for (uint32_t n = goalNode; n != NO_NODE; n = parent[n])
+		path.push_back(Vector2i(static_cast<int>(n % width), static_cast<int>(n / width)));
+	boost::reverse(path);
+	return true;
+}
+
+bool GridAStar::Less(uint32_t a, uint32_t b) const
+{
+	// on equal estimates prefer the node further from the start, it is closer to the goal
+	if (f[a] != f[b])
+		return f[a] < f[b];
+	return g[a] > g[b];
+}
+
+void GridAStar::SiftUp(size_t pos)
+{
+	uint32_t node = heap[pos];
+	while (pos > 0) {
+		size_t up = (pos - 1) / 2;
+		if (!Less(node, heap[up]))
+			break;
+		heap[pos] = heap[up];
+		heapIndex[heap[pos]] = static_cast<uint32_t>(pos);
+		pos = up;
+	}
+	heap[pos] = node;
+	heapIndex[node] = static_cast<uint32_t>(pos);
+}
+
+void GridAStar::SiftDown(size_t pos)
+{
+	uint32_t node = heap[pos];
+	for (;;) {
+		size_t child = 2 * pos + 1;
+		if (child >= heap.size())
+			break;
+		if (child + 1 < heap.size() && Less(heap[child + 1], heap[child]))
+			child++;
+		if (!Less(heap[child], node))
+			break;
+		heap[pos] = heap[child];
+		heapIndex[heap[pos]] = static_cast<uint32_t>(pos);
+		pos = child;
+	}
+	heap[pos] = node;
+	heapIndex[node] = static_cast<uint32_t>(pos);
+}
+
+void GridAStar::Push(uint32_t node)
+{
+	heap.push_back(node);
+	SiftUp(heap.size() - 1);
+}
+
+uint32_t GridAStar::Pop()
+{
+	uint32_t top = heap.front();
+	heap.front() = heap.back();
+	heap.pop_back();
+	if (!heap.empty())
+		SiftDown(0);
+	return top;
+}
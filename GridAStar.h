@@ -0,0 +1,70 @@
+#ifndef GRID_ASTAR_H
+#define GRID_ASTAR_H
+
+#include <cstdint>
+
+class NavGrid;
+
+// A* over the 4-connected walkable blocks of a path grid. The node data lives in arrays
+// sized for the grid and allocated once in SetGrid. Every search gets a new generation,
+// nodes stamped with an older one count as unvisited, and only the words of the closed
+// bitset the last search set bits in are cleared. The open list is a binary heap indexed
+// by node, so a shorter way to an open node is a decrease-key instead of a second entry.
+class GridAStar
+{
+	const NavGrid* grid;
+	size_t width, height;
+
+	uint32_t generation;
+	std::vector<uint32_t> nodeGeneration;
+	std::vector<uint32_t> g;          // steps from the start
+	std::vector<uint32_t> f;          // g plus the estimated steps to the goal
+	std::vector<uint32_t> parent;
+	std::vector<uint32_t> heapIndex;  // position in the heap while the node is open
+	std::vector<uint64_t> closed;     // one bit per node
+	std::vector<uint32_t> closedWords;  // indices of the words of closed with bits set
+
+	std::vector<uint32_t> heap;
+
+	size_t numExpanded;
+
+public:
+	GridAStar();
+
+	// Use the walkable blocks of grid. Only a reference to grid is kept, it has to
+	// outlive the searches.
+	void SetGrid(const NavGrid& grid);
+
+	// Find a shortest path from start to goal. The start block does not need to be
+	// walkable. Returns false if the goal cannot be reached, otherwise path holds the
+	// blocks from start to goal.
+	bool FindPath(const Vector2i& start, const Vector2i& goal, std::vector<Vector2i>& path);
+
+	// Nodes expanded by the last search
+	size_t GetNumExpanded() const
+	{
+		return numExpanded;
+	}
+
+private:
+	bool IsClosed(uint32_t node) const
+	{
+		return (closed[node / 64] >> (node % 64)) & 1;
+	}
+
+	void SetClosed(uint32_t node)
+	{
+		uint64_t& word = closed[node / 64];
+		if (!word)
+			closedWords.push_back(node / 64);
+		word |= uint64_t(1) << (node % 64);
+	}
+
+	bool Less(uint32_t a, uint32_t b) const;
+	void SiftUp(size_t pos);
+	void SiftDown(size_t pos);
+	void Push(uint32_t node);
+	uint32_t Pop();
+};
+
+#endif //GRID_ASTAR_H
@@ -0,0 +1,57 @@
+#include "pch.h"
+#include "HandlePool.h"
+#include "Error.h"
+
+/*static*/ const uint32_t HandlePool::MAX_SLOTS;
+
+void HandlePool::Reserve(size_t n)
+{
+	generations.reserve(std::min<size_t>(n, MAX_SLOTS));
+}
+
+void HandlePool::Clear()
+{
+	std::vector<uint8_t> isFree(generations.size(), 0);
+	while (!freeSlots.empty()) {
+		isFree[freeSlots.front()] = 1;
+		freeSlots.pop();
+	}
+	for (uint32_t slot=0; slot < generations.size(); ++slot) {
+		if (isFree[slot] || (generations[slot] != RETIRED && NextGeneration(slot)))
+			freeSlots.push(slot);
+	}
+}
+
+Handle HandlePool::Allocate()
+{
+	if (!freeSlots.empty()) {
+		const uint32_t slot = freeSlots.front();
+		freeSlots.pop();
+		return MakeHandle(slot, generations[slot]);
+	}
+
+	if (generations.size() >= MAX_SLOTS)
+		throw GameError() << ErrorInfo::Desc("Too many objects") << ErrorInfo::Note(boost::lexical_cast<std::string>(MAX_SLOTS));
+	generations.push_back(0);
+	return MakeHandle(static_cast<uint32_t>(generations.size() - 1), 0);
+}
+
+void HandlePool::Release(Handle h)
+{
+	assert(IsValid(h));
+	const uint32_t slot = GetSlot(h);
+	if (NextGeneration(slot))
+		freeSlots.push(slot);
+}
+
+bool HandlePool::NextGeneration(uint32_t slot)
+{
+	// a retired slot is never handed out again, that costs one of the MAX_SLOTS after
+	// 4096 objects lived there
+	if (generations[slot] == GENERATION_MASK) {
+		generations[slot] = RETIRED;
+		return false;
+	}
+	generations[slot]++;
+	return true;
+}
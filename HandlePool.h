@@ -0,0 +1,72 @@
+#ifndef HANDLE_POOL_H
+#define HANDLE_POOL_H
+
+#include <cstdint>
+
+// Reference to an object in a pool: the slot in the low bits, the generation of the
+// slot in the high bits
+typedef uint32_t Handle;
+
+static const Handle NO_HANDLE = static_cast<Handle>(-1);
+
+// Hands out the handles for a pool. Releasing a slot moves it on to the next generation,
+// a handle to the object that was there no longer matches and is recognized as stale.
+// The slots are reused in the order they were released, so a slot comes back only after
+// all other free ones. A slot whose generations ran out is retired instead of starting
+// over, so a generation never repeats.
+class HandlePool
+{
+	static const int SLOT_BITS = 20;
+	static const uint32_t SLOT_MASK = (1u << SLOT_BITS) - 1;
+	static const uint32_t GENERATION_MASK = (1u << (32 - SLOT_BITS)) - 1;
+	static const uint32_t RETIRED = GENERATION_MASK + 1;  // matches no handle
+
+	std::vector<uint32_t> generations;  // by slot
+	std::queue<uint32_t> freeSlots;
+
+public:
+	// the last slot is left out, its last generation would be NO_HANDLE
+	static const uint32_t MAX_SLOTS = SLOT_MASK;
+
+	// Make room for n slots in use at the same time
+	void Reserve(size_t n);
+
+	// Release all slots, the handles handed out so far stay stale
+	void Clear();
+
+	Handle Allocate();
+	void Release(Handle h);
+
+	bool IsValid(Handle h) const
+	{
+		const uint32_t slot = GetSlot(h);
+		return slot < generations.size() && generations[slot] == GetGeneration(h);
+	}
+
+	static uint32_t GetSlot(Handle h)
+	{
+		return h & SLOT_MASK;
+	}
+
+	// Slots that were ever used, the slots of all handles are below
+	size_t GetNumSlots() const
+	{
+		return generations.size();
+	}
+
+private:
+	// Move the slot on to the next generation, returns false if it got retired
+	bool NextGeneration(uint32_t slot);
+
+	static uint32_t GetGeneration(Handle h)
+	{
+		return h >> SLOT_BITS;
+	}
+
+	static Handle MakeHandle(uint32_t slot, uint32_t generation)
+	{
+		return (generation << SLOT_BITS) | slot;
+	}
+};
+
+#endif //HANDLE_POOL_H
@@ -0,0 +1,87 @@
+#include "pch.h"
+#include "Headless.h"
+#include "Simulation.h"
+#include "Replay.h"
+#include "GlobalStatus.h"
+#include "Theme.h"
+#include "Error.h"
+
+#include <iostream>
+#include <iomanip>
+
+namespace fs = boost::filesystem;
+
+static void PrintResult(const Simulation& simulation, float wallTime)
+{
+	const GameStatus& status = simulation.GetStatus();
+	std::cout << "simulated: " << simulation.GetTick() * SIM_TICK << "s in " << simulation.GetTick() << " ticks\n"
+	          << "wall time: " << wallTime << "s\n"
+	          << "finished: " << (simulation.IsRunning() ? "no" : "yes") << "\n"
+	          << "wave: " << status.currentWave << "/" << simulation.GetLevel().waves.size() << "\n"
+	          << "lives: " << status.lives << "\n"
+	          << "money: " << status.money << std::endl;
+}
+
+int RunHeadless(const std::string& level, float seconds)
+{
+	// use the default status, so the result does not depend on the save file
+	gStatus.Reset();
+	gTheme.LoadTheme("default");
+
+	Simulation simulation(gStatus);
+	simulation.Reset(level, 0);
+
+	Clock clock;
+	while (simulation.IsRunning() && simulation.GetTick() * SIM_TICK < seconds)
+		simulation.Update(SIM_TICK);
+	float wallTime = clock.GetElapsedTime();
+
+	std::cout << "level: " << level << "\n";
+	PrintResult(simulation, wallTime);
+	return 0;
+}
+
+int RunReplay(const fs::path& replayFile, const fs::path& hashFile)
+{
+	Replay replay;
+	replay.LoadFromFile(replayFile);
+
+	std::ofstream hashes;
+	if (!hashFile.empty()) {
+		hashes.open(hashFile.string());
+		if (!hashes.is_open())
+			throw GameError() << ErrorInfo::Desc("Failed to open file") << boost::errinfo_file_name(hashFile.string());
+		hashes << std::hex << std::setfill('0');
+	}
+
+	gStatus.Reset();
+	gTheme.LoadTheme("default");
+
+	Simulation simulation(gStatus);
+	ReplayPlayer player(replay, simulation);
+
+	// one line per tick, the last Step may or may not have advanced the simulation
+	size_t hashedTick = static_cast<size_t>(-1);
+	auto writeHash = [&]() {
+		if (hashes.is_open() && simulation.GetTick() != hashedTick) {
+			hashedTick = simulation.GetTick();
+			hashes << std::dec << hashedTick << " " << std::hex << std::setw(16) << simulation.GetStateHash() << "\n";
+		}
+	};
+
+	Clock clock;
+	player.Start(gStatus);
+	writeHash();
+	while (player.Step())
+		writeHash();
+	writeHash();
+	float wallTime = clock.GetElapsedTime();
+
+	std::cout << "replay: " << replayFile.string() << "\n"
+	          << "level: " << replay.level << "\n"
+	          << "seed: " << replay.seed << "\n"
+	          << "commands: " << replay.commands.size() << "\n";
+	PrintResult(simulation, wallTime);
+	std::cout << "state hash: " << std::hex << std::setw(16) << std::setfill('0') << simulation.GetStateHash() << std::dec << std::endl;
+	return 0;
+}
@@ -0,0 +1,15 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Runs without a window, for automated tests and benchmarks. Errors are thrown
+// as GameError, the caller is responsible for reporting them.
+
+// Simulate the given level for at most the given number of seconds (simulation time)
+// without any player input and print the result.
+int RunHeadless(const std::string& level, float seconds);
+
+// Play back a replay as fast as possible and print the final state hash. If hashFile
+// is not empty, the state hash of every tick gets written to it, one "<tick> <hash>" per line.
+int RunReplay(const boost::filesystem::path& replayFile, const boost::filesystem::path& hashFile);
+
+#endif //HEADLESS_H
@@ -0,0 +1,326 @@
+#include "pch.h"
+#include "HierarchicalPath.h"
+#include "NavGrid.h"
+#include "Profiler.h"
+
+// left, right, up, down, the same order as the flow fields
+static const int OFFSET_X[] = { -1, 1, 0, 0 };
+static const int OFFSET_Y[] = { 0, 0, -1, 1 };
+static const size_t NUM_NEIGHBORS = 4;
+
+static const uint32_t NO_NODE = 0xffffffff;
+static const uint32_t UNREACHED = 0xffffffff;
+
+// wider entrances get a node pair at both ends instead of one in the middle
+static const size_t MAX_NARROW_ENTRANCE = 5;
+
+static uint32_t Estimate(const Vector2i& a, const Vector2i& b)
+{
+	return static_cast<uint32_t>(std::abs(a.x - b.x) + std::abs(a.y - b.y));
+}
+
+HierarchicalPath::HierarchicalPath()
+: grid(nullptr), width(0), height(0), clusterSize(DEFAULT_CLUSTER_SIZE), clustersX(0), clustersY(0), numEdges(0),
+  generation(0), localX(0), localY(0), localWidth(0), localHeight(0), numExpanded(0)
+{ }
+
+void HierarchicalPath::Build(const NavGrid& gr, size_t cs)
+{
+	PROFILE_ZONE("HierarchicalPath::Build");
+
+	assert(cs > 0);
+
+	grid = &gr;
+	width = gr.GetWidth();
+	height = gr.GetHeight();
+	clusterSize = cs;
+	clustersX = (width + clusterSize - 1) / clusterSize;
+	clustersY = (height + clusterSize - 1) / clusterSize;
+
+	nodeBlocks.clear();
+	nodeEdges.clear();
+	clusterNodes.assign(clustersX * clustersY, std::vector<uint32_t>());
+	blockNodes.assign(width * height, NO_NODE);
+	numEdges = 0;
+
+	// entrances on the vertical borders between clusters, then on the horizontal ones
+	for (size_t cy=0; cy < clustersY; ++cy) {
+		const size_t length = std::min(clusterSize, height - cy * clusterSize);
+		for (size_t cx=1; cx < clustersX; ++cx) {
+			Vector2i first(static_cast<int>(cx * clusterSize) - 1, static_cast<int>(cy * clusterSize));
+			AddEntrances(first, Vector2i(0, 1), Vector2i(1, 0), length);
+		}
+	}
+	for (size_t cy=1; cy < clustersY; ++cy) {
+		for (size_t cx=0; cx < clustersX; ++cx) {
+			const size_t length = std::min(clusterSize, width - cx * clusterSize);
+			Vector2i first(static_cast<int>(cx * clusterSize), static_cast<int>(cy * clusterSize) - 1);
+			AddEntrances(first, Vector2i(1, 0), Vector2i(0, 1), length);
+		}
+	}
+
+	// connect the nodes of every cluster by their shortest way inside it
+	for (size_t cluster=0; cluster < clusterNodes.size(); ++cluster) {
+		auto& nodes = clusterNodes[cluster];
+		for (size_t i=0; i < nodes.size(); ++i) {
+			SearchCluster(cluster, nodeBlocks[nodes[i]]);
+			for (size_t j=0; j < nodes.size(); ++j) {
+				uint32_t dist = GetLocalDist(nodeBlocks[nodes[j]]);
+				if (i != j && dist != UNREACHED) {
+					nodeEdges[nodes[i]].push_back(Edge(nodes[j], dist));
+					numEdges++;
+				}
+			}
+		}
+	}
+
+	// start and goal of a search are two more nodes
+	const size_t numSearchNodes = nodeBlocks.size() + 2;
+	generation = 0;
+	nodeGeneration.assign(numSearchNodes, 0);
+	g.resize(numSearchNodes);
+	parent.resize(numSearchNodes);
+}
+
+uint32_t HierarchicalPath::GetNode(const Vector2i& blk)
+{
+	uint32_t& node = blockNodes[blk.x + blk.y * width];
+	if (node == NO_NODE) {
+		node = static_cast<uint32_t>(nodeBlocks.size());
+		nodeBlocks.push_back(blk);
+		nodeEdges.push_back(std::vector<Edge>());
+		clusterNodes[GetCluster(blk)].push_back(node);
+	}
+	return node;
+}
+
+void HierarchicalPath::AddEntrances(const Vector2i& first, const Vector2i& step, const Vector2i& across, size_t length)
+{
+	auto addPair = [&](size_t i) {
+		Vector2i a(first.x + static_cast<int>(i) * step.x, first.y + static_cast<int>(i) * step.y);
+		Vector2i b(a.x + across.x, a.y + across.y);
+		uint32_t na = GetNode(a);
+		uint32_t nb = GetNode(b);
+		nodeEdges[na].push_back(Edge(nb, 1));
+		nodeEdges[nb].push_back(Edge(na, 1));
+		numEdges += 2;
+	};
+
+	// every run of blocks walkable on both sides is one entrance
+	size_t begin = 0;
+	for (size_t i=0; i <= length; ++i) {
+		bool open = false;
+		if (i < length) {
+			int x = first.x + static_cast<int>(i) * step.x;
+			int y = first.y + static_cast<int>(i) * step.y;
+			open = grid->IsWalkable(x, y) && grid->IsWalkable(x + across.x, y + across.y);
+		}
+		if (open)
+			continue;
+
+		if (i > begin) {
+			if (i - begin <= MAX_NARROW_ENTRANCE) {
+				addPair((begin + i - 1) / 2);
+			}
+			else {
+				addPair(begin);
+				addPair(i - 1);
+			}
+		}
+		begin = i + 1;
+	}
+}
+
+void HierarchicalPath::SearchCluster(size_t cluster, const Vector2i& from, const Vector2i* to)
+{
+	localX = static_cast<int>((cluster % clustersX) * clusterSize);
+	localY = static_cast<int>((cluster / clustersX) * clusterSize);
+	localWidth = std::min(clusterSize, width - localX);
+	localHeight = std::min(clusterSize, height - localY);
+
+	localDist.assign(localWidth * localHeight, UNREACHED);
+	localParent.resize(localWidth * localHeight);
+	localQueue.clear();
+
+	const uint32_t fromIdx = static_cast<uint32_t>((from.x - localX) + (from.y - localY) * localWidth);
+	const uint32_t toIdx = to ? static_cast<uint32_t>((to->x - localX) + (to->y - localY) * localWidth) : NO_NODE;
+	localDist[fromIdx] = 0;
+	localParent[fromIdx] = NO_NODE;
+	localQueue.push_back(fromIdx);
+
+	for (size_t head=0; head < localQueue.size(); ++head) {
+		uint32_t cur = localQueue[head];
+		if (cur == toIdx)
+			break;
+
+		int lx = static_cast<int>(cur % localWidth);
+		int ly = static_cast<int>(cur / localWidth);
+		const uint8_t walkable = grid->GetNeighbors(localX + lx, localY + ly);
+		for (size_t n=0; n < NUM_NEIGHBORS; ++n) {
+			int nx = lx + OFFSET_X[n];
+			int ny = ly + OFFSET_Y[n];
+			if (!(walkable & (1 << n)) || nx < 0 || ny < 0 || static_cast<size_t>(nx) >= localWidth || static_cast<size_t>(ny) >= localHeight)
+				continue;
+			uint32_t nb = static_cast<uint32_t>(nx + ny * localWidth);
+			if (localDist[nb] != UNREACHED)
+				continue;
+
+			localDist[nb] = localDist[cur] + 1;
+			localParent[nb] = cur;
+			localQueue.push_back(nb);
+		}
+	}
+}
+
+uint32_t HierarchicalPath::GetLocalDist(const Vector2i& blk) const
+{
+	return localDist[(blk.x - localX) + (blk.y - localY) * localWidth];
+}
+
+bool HierarchicalPath::AppendLocalPath(size_t cluster, const Vector2i& from, const Vector2i& to, std::vector<Vector2i>& path)
+{
+	SearchCluster(cluster, from, &to);
+	if (GetLocalDist(to) == UNREACHED)
+		return false;
+
+	// from is already on the path
+	const size_t end = path.size();
+	for (uint32_t n = static_cast<uint32_t>((to.x - localX) + (to.y - localY) * localWidth); localParent[n] != NO_NODE; n = localParent[n])
+		path.push_back(Vector2i(localX + static_cast<int>(n % localWidth), localY + static_cast<int>(n / localWidth)));
+	std::reverse(path.begin() + end, path.end());
+	return true;
+}
+
+void HierarchicalPath::ConnectToCluster(const Vector2i& blk, std::vector<Edge>& edges)
+{
+	const size_t cluster = GetCluster(blk);
+	SearchCluster(cluster, blk);
+
+	edges.clear();
+	auto& nodes = clusterNodes[cluster];
+	for (size_t i=0; i < nodes.size(); ++i) {
+		uint32_t dist = GetLocalDist(nodeBlocks[nodes[i]]);
+		if (dist != UNREACHED)
+			edges.push_back(Edge(nodes[i], dist));
+	}
+}
+
+bool HierarchicalPath::FindPath(const Vector2i& start, const Vector2i& goal, std::vector<Vector2i>& path)
+{
+	PROFILE_ZONE("HierarchicalPath::FindPath");
+
+	path.clear();
+	numExpanded = 0;
+
+	if (!grid || !grid->Contains(start) || !grid->Contains(goal) || !grid->IsWalkable(goal.x, goal.y))
+		return false;
+
+	path.push_back(start);
+
+	// inside one cluster the local way is taken if there is one
+	const size_t startCluster = GetCluster(start);
+	if (startCluster == GetCluster(goal) && AppendLocalPath(startCluster, start, goal, path))
+		return true;
+
+	if (!SearchAbstract(start, goal)) {
+		path.clear();
+		return false;
+	}
+
+	// refine every abstract step, the steps between clusters are single blocks
+	for (size_t i=1; i < abstractPath.size(); ++i) {
+		Vector2i from = path.back();
+		Vector2i to = abstractPath[i] < nodeBlocks.size() ? nodeBlocks[abstractPath[i]] : goal;
+		if (to == from)
+			continue;
+
+		const size_t cluster = GetCluster(from);
+		if (cluster != GetCluster(to)) {
+			path.push_back(to);
+		}
+		else if (!AppendLocalPath(cluster, from, to, path)) {
+			assert(false);
+			path.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool HierarchicalPath::SearchAbstract(const Vector2i& start, const Vector2i& goal)
+{
+	ConnectToCluster(start, startEdges);
+	ConnectToCluster(goal, goalEdges);
+	if (startEdges.empty() || goalEdges.empty())
+		return false;
+
+	const uint32_t startNode = static_cast<uint32_t>(nodeBlocks.size());
+	const uint32_t goalNode = startNode + 1;
+
+	// a new generation marks all nodes as unvisited, start over once it wraps
+	if (++generation == 0) {
+		boost::fill(nodeGeneration, 0);
+		generation = 1;
+	}
+
+	auto blockOf = [&](uint32_t node) -> Vector2i {
+		if (node == startNode)
+			return start;
+		if (node == goalNode)
+			return goal;
+		return nodeBlocks[node];
+	};
+
+	// lazy deletion, an entry is outdated if its node got cheaper since it was pushed
+	typedef std::pair<uint32_t, uint32_t> Entry;
+	std::greater<Entry> later;
+	auto relax = [&](uint32_t from, uint32_t to, uint32_t cost) {
+		uint32_t newG = (from == NO_NODE ? 0 : g[from]) + cost;
+		if (nodeGeneration[to] == generation && g[to] <= newG)
+			return;
+		nodeGeneration[to] = generation;
+		g[to] = newG;
+		parent[to] = from;
+		open.push_back(Entry(newG + Estimate(blockOf(to), goal), to));
+		std::push_heap(open.begin(), open.end(), later);
+	};
+
+	open.clear();
+	relax(NO_NODE, startNode, 0);
+
+	while (!open.empty()) {
+		std::pop_heap(open.begin(), open.end(), later);
+		Entry top = open.back();
+		open.pop_back();
+
+		uint32_t cur = top.second;
+		if (top.first != g[cur] + Estimate(blockOf(cur), goal))
+			continue;
+		if (cur == goalNode)
+			break;
+		numExpanded++;
+
+		if (cur == startNode) {
+			for (auto it = startEdges.begin(); it != startEdges.end(); ++it)
+				relax(cur, it->to, it->cost);
+			continue;
+		}
+
+		auto& edges = nodeEdges[cur];
+		for (auto it = edges.begin(); it != edges.end(); ++it)
+			relax(cur, it->to, it->cost);
+		for (auto it = goalEdges.begin(); it != goalEdges.end(); ++it) {
+			if (it->to == cur)
+				relax(cur, goalNode, it->cost);
+		}
+	}
+
+	if (nodeGeneration[goalNode] != generation)
+		return false;
+
+	abstractPath.clear();
+	for (uint32_t n = goalNode; n != NO_NODE; n = parent[n])
+		abstractPath.push_back(n);
+	boost::reverse(abstractPath);
+	return true;
+}
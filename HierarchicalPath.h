@@ -0,0 +1,109 @@
+#ifndef HIERARCHICAL_PATH_H
+#define HIERARCHICAL_PATH_H
+
+#include <cstdint>
+
+class NavGrid;
+
+// Hierarchical path finding (HPA*) over the 4-connected walkable blocks of a path grid.
+// The grid is cut into square clusters. Where the walkable blocks cross the border of
+// two clusters there are entrances, a pair of abstract nodes one on each side. The
+// nodes of a cluster are connected by their shortest way inside the cluster. A search
+// connects start and goal to the nodes of their clusters, runs A* over this small
+// graph and then refines every abstract step by a search inside a single cluster.
+// The paths are close to the shortest, but not always the shortest.
+class HierarchicalPath
+{
+public:
+	static const size_t DEFAULT_CLUSTER_SIZE = 10;
+
+private:
+	struct Edge
+	{
+		uint32_t to;
+		uint32_t cost;
+
+		Edge(uint32_t to, uint32_t cost)
+		: to(to), cost(cost)
+		{ }
+	};
+
+	const NavGrid* grid;
+	size_t width, height;
+	size_t clusterSize, clustersX, clustersY;
+
+	// the abstract graph
+	std::vector<Vector2i> nodeBlocks;
+	std::vector<std::vector<Edge>> nodeEdges;
+	std::vector<std::vector<uint32_t>> clusterNodes;
+	std::vector<uint32_t> blockNodes;  // node of every block, if it has one
+	size_t numEdges;
+
+	// search on the abstract graph, start and goal are appended as two extra nodes
+	uint32_t generation;
+	std::vector<uint32_t> nodeGeneration;
+	std::vector<uint32_t> g;
+	std::vector<uint32_t> parent;
+	std::vector<std::pair<uint32_t, uint32_t>> open;  // heap of estimate and node
+	std::vector<Edge> startEdges, goalEdges;
+	std::vector<uint32_t> abstractPath;
+
+	// breadth first search inside one cluster
+	std::vector<uint32_t> localDist;
+	std::vector<uint32_t> localParent;
+	std::vector<uint32_t> localQueue;
+	int localX, localY;
+	size_t localWidth, localHeight;
+
+	size_t numExpanded;
+
+public:
+	HierarchicalPath();
+
+	// Build the clusters and entrances over grid. Only a reference to grid is kept, it
+	// has to outlive the searches. Call it again after the grid changed.
+	void Build(const NavGrid& grid, size_t clusterSize = DEFAULT_CLUSTER_SIZE);
+
+	// Find a path from start to goal, the same as GridAStar::FindPath.
+	bool FindPath(const Vector2i& start, const Vector2i& goal, std::vector<Vector2i>& path);
+
+	// Abstract nodes expanded by the last search
+	size_t GetNumExpanded() const
+	{
+		return numExpanded;
+	}
+
+	size_t GetNumNodes() const
+	{
+		return nodeBlocks.size();
+	}
+
+	size_t GetNumEdges() const
+	{
+		return numEdges;
+	}
+
+	size_t GetClusterSize() const
+	{
+		return clusterSize;
+	}
+
+private:
+	size_t GetCluster(const Vector2i& blk) const
+	{
+		return blk.x / clusterSize + (blk.y / clusterSize) * clustersX;
+	}
+
+	uint32_t GetNode(const Vector2i& blk);
+	void AddEntrances(const Vector2i& first, const Vector2i& step, const Vector2i& across, size_t length);
+
+	// Distances from the block from to every block of the cluster, stops early once to is reached
+	void SearchCluster(size_t cluster, const Vector2i& from, const Vector2i* to = nullptr);
+	uint32_t GetLocalDist(const Vector2i& blk) const;
+	bool AppendLocalPath(size_t cluster, const Vector2i& from, const Vector2i& to, std::vector<Vector2i>& path);
+	void ConnectToCluster(const Vector2i& blk, std::vector<Edge>& edges);
+
+	bool SearchAbstract(const Vector2i& start, const Vector2i& goal);
+};
+
+#endif //HIERARCHICAL_PATH_H
@@ -0,0 +1,299 @@
+#include "pch.h"
+#include "Kernels.h"
+#include "Utility.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define KERNELS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KERNELS_SSE2
+#endif
+
+// acos(x) = sqrt(1 - x) * (a0 + a1 x + ... + a7 x^7) for x in [0, 1], off by at most 2e-8
+// (Abramowitz and Stegun 4.4.46). Unlike acosf it works on all lanes at once.
+static const float ACOS_COEFFS[] = {
+	1.5707963050f, -0.2145988016f, 0.0889789874f, -0.0501743046f,
+	0.0308918810f, -0.0170881256f, 0.0066700901f, -0.0012624911f
+};
+static const int NUM_ACOS_COEFFS = sizeof(ACOS_COEFFS) / sizeof(ACOS_COEFFS[0]);
+
+static const float DEGREES_PER_RADIAN = 180 / PI;
+
+// The operations the kernels need on a register of floats, for one instruction set
+#if defined(KERNELS_AVX2)
+struct Lanes
+{
+	typedef __m256 V;
+	static const size_t N = 8;
+
+	static const char* GetName()        { return "AVX2"; }
+
+	static V Load(const float* p)       { return _mm256_loadu_ps(p); }
+	static void Store(float* p, V v)    { _mm256_storeu_ps(p, v); }
+	static V Set(float f)               { return _mm256_set1_ps(f); }
+
+	static V Add(V a, V b)              { return _mm256_add_ps(a, b); }
+	static V Sub(V a, V b)              { return _mm256_sub_ps(a, b); }
+	static V Mul(V a, V b)              { return _mm256_mul_ps(a, b); }
+	static V Div(V a, V b)              { return _mm256_div_ps(a, b); }
+	static V Sqrt(V a)                  { return _mm256_sqrt_ps(a); }
+	static V Min(V a, V b)              { return _mm256_min_ps(a, b); }
+
+	static V Less(V a, V b)             { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static V LessEqual(V a, V b)        { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+
+	static V And(V a, V b)              { return _mm256_and_ps(a, b); }
+	static V AndNot(V a, V b)           { return _mm256_andnot_ps(a, b); }
+	static V Or(V a, V b)               { return _mm256_or_ps(a, b); }
+	static V Xor(V a, V b)              { return _mm256_xor_ps(a, b); }
+
+	// b in the lanes of mask, a in the others
+	static V Select(V mask, V a, V b)   { return _mm256_blendv_ps(a, b, mask); }
+
+	// one bit per lane of mask
+	static int GetBits(V mask)          { return _mm256_movemask_ps(mask); }
+
+	// the lanes of the flags not 0
+	static V LoadFlags(const uint8_t* p)
+	{
+		__m256i flags = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+		return _mm256_castsi256_ps(_mm256_cmpgt_epi32(flags, _mm256_setzero_si256()));
+	}
+};
+#define KERNELS_LANES
+#elif defined(KERNELS_SSE2)
+struct Lanes
+{
+	typedef __m128 V;
+	static const size_t N = 4;
+
+	static const char* GetName()        { return "SSE2"; }
+
+	static V Load(const float* p)       { return _mm_loadu_ps(p); }
+	static void Store(float* p, V v)    { _mm_storeu_ps(p, v); }
+	static V Set(float f)               { return _mm_set1_ps(f); }
+
+	static V Add(V a, V b)              { return _mm_add_ps(a, b); }
+	static V Sub(V a, V b)              { return _mm_sub_ps(a, b); }
+	static V Mul(V a, V b)              { return _mm_mul_ps(a, b); }
+	static V Div(V a, V b)              { return _mm_div_ps(a, b); }
+	static V Sqrt(V a)                  { return _mm_sqrt_ps(a); }
+	static V Min(V a, V b)              { return _mm_min_ps(a, b); }
+
+	static V Less(V a, V b)             { return _mm_cmplt_ps(a, b); }
+	static V LessEqual(V a, V b)        { return _mm_cmple_ps(a, b); }
+
+	static V And(V a, V b)              { return _mm_and_ps(a, b); }
+	static V AndNot(V a, V b)           { return _mm_andnot_ps(a, b); }
+	static V Or(V a, V b)               { return _mm_or_ps(a, b); }
+	static V Xor(V a, V b)              { return _mm_xor_ps(a, b); }
+
+	static V Select(V mask, V a, V b)   { return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a)); }
+
+	static int GetBits(V mask)          { return _mm_movemask_ps(mask); }
+
+	static V LoadFlags(const uint8_t* p)
+	{
+		int32_t bytes;
+		std::memcpy(&bytes, p, sizeof(bytes));
+		const __m128i zero = _mm_setzero_si128();
+		__m128i flags = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero), zero);
+		return _mm_castsi128_ps(_mm_cmpgt_epi32(flags, zero));
+	}
+};
+#define KERNELS_LANES
+#endif
+
+void HomingBatch::Reserve(size_t n)
+{
+	x.reserve(n);
+	y.reserve(n);
+	targetX.reserve(n);
+	targetY.reserve(n);
+	speed.reserve(n);
+	rotation.reserve(n);
+	hit.reserve(n);
+}
+
+void HomingBatch::Resize(size_t n)
+{
+	x.resize(n);
+	y.resize(n);
+	targetX.resize(n);
+	targetY.resize(n);
+	speed.resize(n);
+	rotation.resize(n);
+	hit.resize(n);
+}
+
+static float Acos(float c)
+{
+	const float a = std::min(std::abs(c), 1.0f);
+	float p = ACOS_COEFFS[NUM_ACOS_COEFFS - 1];
+	for (int k = NUM_ACOS_COEFFS - 2; k >= 0; --k)
+		p = p * a + ACOS_COEFFS[k];
+	p = p * std::sqrt(1.0f - a);
+	return c < 0 ? PI - p : p;
+}
+
+static void HomeProjectile(HomingBatch& b, size_t i, float elapsed)
+{
+	if (b.hit[i])
+		return;
+
+	const float dx = b.targetX[i] - b.x[i];
+	const float dy = b.targetY[i] - b.y[i];
+	const float r = std::sqrt(dx * dx + dy * dy);
+	if (r < HIT_DISTANCE) {
+		b.hit[i] = 1;
+		return;
+	}
+
+	const float nx = dx / r;
+	const float ny = dy / r;
+	const float angle = Acos(-nx);  // to the left
+	b.x[i] += nx * b.speed[i] * elapsed;
+	b.y[i] += ny * b.speed[i] * elapsed;
+	b.rotation[i] = (ny < 0 ? -angle : angle) * DEGREES_PER_RADIAN;
+}
+
+static size_t SelectInRangeFrom(const float* x, const float* y, size_t begin, size_t n, const Vector2f& pos, float rangeSq, uint32_t* out, size_t count)
+{
+	for (size_t i=begin; i < n; ++i) {
+		const float dx = x[i] - pos.x;
+		const float dy = y[i] - pos.y;
+		out[count] = static_cast<uint32_t>(i);
+		count += dx * dx + dy * dy <= rangeSq;
+	}
+	return count;
+}
+
+#ifdef KERNELS_LANES
+// The set bits of 4 lanes moved to the front and how many there are
+static const uint32_t PACKED_LANES[16][4] = {
+	{ 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 1, 0, 0, 0 }, { 0, 1, 0, 0 },
+	{ 2, 0, 0, 0 }, { 0, 2, 0, 0 }, { 1, 2, 0, 0 }, { 0, 1, 2, 0 },
+	{ 3, 0, 0, 0 }, { 0, 3, 0, 0 }, { 1, 3, 0, 0 }, { 0, 1, 3, 0 },
+	{ 2, 3, 0, 0 }, { 0, 2, 3, 0 }, { 1, 2, 3, 0 }, { 0, 1, 2, 3 }
+};
+static const size_t NUM_PACKED_LANES[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+// Write first plus the lane of every bit set in the low 4 bits to out, returns how many
+// there are. Always writes 4 indices, so no branch depends on the bits.
+static size_t StoreLanes(int bits, uint32_t first, uint32_t* out)
+{
+	const __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(PACKED_LANES[bits]));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_add_epi32(lanes, _mm_set1_epi32(first)));
+	return NUM_PACKED_LANES[bits];
+}
+
+// The same operations as Acos above, on all lanes
+static Lanes::V Acos(Lanes::V c)
+{
+	typedef Lanes L;
+	const L::V one = L::Set(1.0f);
+	const L::V a = L::Min(L::AndNot(L::Set(-0.0f), c), one);
+	L::V p = L::Set(ACOS_COEFFS[NUM_ACOS_COEFFS - 1]);
+	for (int k = NUM_ACOS_COEFFS - 2; k >= 0; --k)
+		p = L::Add(L::Mul(p, a), L::Set(ACOS_COEFFS[k]));
+	p = L::Mul(p, L::Sqrt(L::Sub(one, a)));
+	return L::Select(L::Less(c, L::Set(0.0f)), p, L::Sub(L::Set(PI), p));
+}
+
+// Returns the number of projectiles done, the rest does not fill a register. The lanes
+// already hit or hit now keep their values.
+static size_t HomeProjectileLanes(HomingBatch& b, float elapsed)
+{
+	typedef Lanes L;
+	const L::V hitDistance = L::Set(HIT_DISTANCE);
+	const L::V time = L::Set(elapsed);
+	const L::V degrees = L::Set(DEGREES_PER_RADIAN);
+	const L::V sign = L::Set(-0.0f);
+	const L::V zero = L::Set(0.0f);
+
+	const size_t n = b.GetSize() / L::N * L::N;
+	for (size_t i=0; i < n; i += L::N) {
+		const L::V x = L::Load(&b.x[i]);
+		const L::V y = L::Load(&b.y[i]);
+		const L::V dx = L::Sub(L::Load(&b.targetX[i]), x);
+		const L::V dy = L::Sub(L::Load(&b.targetY[i]), y);
+		const L::V r = L::Sqrt(L::Add(L::Mul(dx, dx), L::Mul(dy, dy)));
+		const L::V hit = L::Or(L::LoadFlags(&b.hit[i]), L::Less(r, hitDistance));
+
+		const L::V nx = L::Div(dx, r);
+		const L::V ny = L::Div(dy, r);
+		const L::V angle = Acos(L::Xor(nx, sign));
+		const L::V speed = L::Load(&b.speed[i]);
+		const L::V rotation = L::Mul(L::Xor(angle, L::And(L::Less(ny, zero), sign)), degrees);
+
+		L::Store(&b.x[i], L::Select(hit, L::Add(x, L::Mul(L::Mul(nx, speed), time)), x));
+		L::Store(&b.y[i], L::Select(hit, L::Add(y, L::Mul(L::Mul(ny, speed), time)), y));
+		L::Store(&b.rotation[i], L::Select(hit, rotation, L::Load(&b.rotation[i])));
+
+		const int bits = L::GetBits(hit);
+		for (size_t k=0; k < L::N; ++k)
+			b.hit[i + k] = static_cast<uint8_t>((bits >> k) & 1);
+	}
+	return n;
+}
+
+static size_t SelectInRangeLanes(const float* x, const float* y, size_t n, const Vector2f& pos, float rangeSq, uint32_t* out, size_t& count)
+{
+	typedef Lanes L;
+	const L::V px = L::Set(pos.x);
+	const L::V py = L::Set(pos.y);
+	const L::V range = L::Set(rangeSq);
+
+	const size_t end = n / L::N * L::N;
+	for (size_t i=0; i < end; i += L::N) {
+		const L::V dx = L::Sub(L::Load(x + i), px);
+		const L::V dy = L::Sub(L::Load(y + i), py);
+		const int bits = L::GetBits(L::LessEqual(L::Add(L::Mul(dx, dx), L::Mul(dy, dy)), range));
+		for (size_t k=0; k < L::N; k += 4)
+			count += StoreLanes((bits >> k) & 15, static_cast<uint32_t>(i + k), out + count);
+	}
+	return end;
+}
+#endif
+
+void HomeProjectiles(HomingBatch& batch, float elapsed)
+{
+	size_t i = 0;
+#ifdef KERNELS_LANES
+	i = HomeProjectileLanes(batch, elapsed);
+#endif
+	for (; i < batch.GetSize(); ++i)
+		HomeProjectile(batch, i, elapsed);
+}
+
+void HomeProjectilesScalar(HomingBatch& batch, float elapsed)
+{
+	for (size_t i=0; i < batch.GetSize(); ++i)
+		HomeProjectile(batch, i, elapsed);
+}
+
+size_t SelectInRange(const float* x, const float* y, size_t n, const Vector2f& pos, float rangeSq, uint32_t* out)
+{
+	size_t begin = 0, count = 0;
+#ifdef KERNELS_LANES
+	begin = SelectInRangeLanes(x, y, n, pos, rangeSq, out, count);
+#endif
+	return SelectInRangeFrom(x, y, begin, n, pos, rangeSq, out, count);
+}
+
+size_t SelectInRangeScalar(const float* x, const float* y, size_t n, const Vector2f& pos, float rangeSq, uint32_t* out)
+{
+	return SelectInRangeFrom(x, y, 0, n, pos, rangeSq, out, 0);
+}
+
+const char* GetKernelSet()
+{
+#ifdef KERNELS_LANES
+	return Lanes::GetName();
+#else
+	return "scalar";
+#endif
+}
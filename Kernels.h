@@ -0,0 +1,45 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstdint>
+
+// Distance to its target at which a projectile hits
+static const float HIT_DISTANCE = 10.f;
+
+// Math over batches of objects with one array per value. The kernels use AVX2 or SSE2
+// when the compiler targets them and plain loops otherwise. All variants do the same
+// operations in the same order, so they give the same results. The Scalar versions are
+// always the plain loops, for comparison.
+
+// The projectiles of one update
+struct HomingBatch
+{
+	std::vector<float> x, y;  // moved towards the target
+	std::vector<float> targetX, targetY;
+	std::vector<float> speed;
+	std::vector<float> rotation;  // in degrees, 0 is facing left
+	std::vector<uint8_t> hit;
+
+	void Reserve(size_t n);
+	void Resize(size_t n);
+
+	size_t GetSize() const
+	{
+		return x.size();
+	}
+};
+
+// Move every projectile not hit yet by speed * elapsed towards its target and turn it
+// that way. The ones closer to their target than HIT_DISTANCE get hit instead.
+void HomeProjectiles(HomingBatch& batch, float elapsed);
+void HomeProjectilesScalar(HomingBatch& batch, float elapsed);
+
+// Write the indices of the n points within range of pos to out in ascending order,
+// returns how many there are. rangeSq is the squared range, out needs room for n indices.
+size_t SelectInRange(const float* x, const float* y, size_t n, const Vector2f& pos, float rangeSq, uint32_t* out);
+size_t SelectInRangeScalar(const float* x, const float* y, size_t n, const Vector2f& pos, float rangeSq, uint32_t* out);
+
+// "AVX2", "SSE2" or "scalar"
+const char* GetKernelSet();
+
+#endif //KERNELS_H
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "Level.h"
 #include "Error.h"
+#include "Profiler.h"
 
 #include "json_spirit/json_spirit.h"
 #include "jsex.h"
@@ -16,6 +17,7 @@ void Level::LoadFromFile(const fs::path& path)
 	"map": <string>,                  // map to use
 	"theme": <string>,                // theme to use
 	"night-time": [bool=false],       // does the level play at night?
+	"maze": [bool=false],             // can towers be placed on the path to block it?
 								      
 	"waves": [                        // list of waves
 		{						      
@@ -43,13 +45,18 @@ void Level::LoadFromFile(const fs::path& path)
 */
 	using std::string;
 
-	auto rootObj = jsex::load_root_from_file(path);
+	js::mObject rootObj;
+	{
+		PROFILE_ZONE_DETAIL("Level::LoadFromFile/json", path.string());
+		rootObj = jsex::load_root_from_file(path);
+	}
 
 	try {
 		name  = jsex::get<string>(rootObj["name"]);
 		map   = jsex::get<string>(rootObj["map"]);
 		theme = jsex::get<string>(rootObj["theme"]);
 		nightMode = jsex::get_opt<bool>(rootObj, "night-mode", false);
+		mazeMode = jsex::get_opt<bool>(rootObj, "maze", false);
 
 
 		waves.clear();
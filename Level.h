@@ -15,6 +15,7 @@ struct Level
 	std::string theme;
 
 	bool nightMode;
+	bool mazeMode;  // towers can be placed on the path and block it
 
 	std::vector<Wave> waves;
 
@@ -6,6 +6,7 @@
 #include "DataPaths.h"
 #include "Utility.h"
 #include "UiHelper.h"
+#include "Profiler.h"
 
 #include "json_spirit/json_spirit.h"
 #include "jsex.h"
@@ -214,6 +215,7 @@ void LevelPicker::LoadLevelPacks()
 	std::ifstream in(LevelPacksFile.string());
 	js::mValue rootValue;
 	try {
+		PROFILE_ZONE_DETAIL("LevelPicker::LoadLevelPacks/json", LevelPacksFile.string());
 		js::read_or_throw(in, rootValue);
 	}
 	catch (js::Error_position err) {
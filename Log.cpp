@@ -1,11 +1,12 @@
 #include "pch.h"
 #include "Log.h"
 
-using namespace Log;
+#include <chrono>
+#include <cstring>
 
-namespace pt = boost::posix_time;
+using namespace Log;
 
-static std::string levelName[Logger::NUM_LEVELS] = {
+static const char* levelName[Logger::NUM_LEVELS] = {
 	"[Crt]",
 	"[Err]",
 	"[Wrn]",
@@ -14,19 +15,161 @@ static std::string levelName[Logger::NUM_LEVELS] = {
 	"[Trc]",
 };
 
+// the writer looks for new messages this often while the queue is empty
+static const std::chrono::milliseconds WRITER_IDLE(5);
+static const std::chrono::seconds FLUSH_TIMEOUT(1);
+
+/*static*/ const size_t MessageBuffer::SIZE;
+
 Logger::Logger()
-: out("log.txt"), loglvl(Msg)
+: head(0), out("log.txt")
+{
+	loglvl.store(Msg);
+	dropPolicy.store(DropNewest);
+	tail.store(0);
+	flushed.store(0);
+	dropped.store(0);
+
+	for (size_t i=0; i < CAPACITY; ++i)
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+
+	running.store(true);
+	writer = std::thread(&Logger::Run, this);
+}
+
+Logger::~Logger()
+{
+	Shutdown();
+}
+
+void Logger::Write(int lvl, const char* text, size_t length)
+{
+	length = std::min(length, MessageBuffer::SIZE);
+
+	if (!running.load(std::memory_order_acquire)) {
+		std::lock_guard<std::mutex> lock(directMutex);
+		WriteLine(lvl, std::time(nullptr), text, length);
+		out.flush();
+		return;
+	}
+
+	// claim a slot, the sequence of a free slot equals the position it is claimed for
+	Slot* slot;
+	size_t pos = tail.load(std::memory_order_relaxed);
+	for (;;) {
+		slot = &slots[pos & (CAPACITY - 1)];
+		size_t seq = slot->sequence.load(std::memory_order_acquire);
+		ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+
+		if (diff == 0) {
+			if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0) {
+			// full, the writer has not written this slot one round ago yet
+			if (GetDropPolicy() == DropNewest && lvl > Error) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			std::this_thread::yield();
+			pos = tail.load(std::memory_order_relaxed);
+		}
+		else {
+			pos = tail.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->level = lvl;
+	slot->time = std::time(nullptr);
+	slot->length = length;
+	std::memcpy(slot->text, text, length);
+
+	// publish it to the writer
+	slot->sequence.store(pos + 1, std::memory_order_release);
+
+	// Shutdown may have drained the queue before the message got published, then it is
+	// written here. Shutdown holds the mutex until the writer is gone.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!running.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(directMutex);
+		WriteQueued();
+		out.flush();
+	}
+}
+
+bool Logger::WriteQueued()
+{
+	bool wrote = false;
+	for (;;) {
+		Slot& slot = slots[head & (CAPACITY - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+			break;
+
+		WriteLine(slot.level, slot.time, slot.text, slot.length);
+
+		// free the slot for the next round
+		slot.sequence.store(head + CAPACITY, std::memory_order_release);
+		head++;
+		wrote = true;
+	}
+	return wrote;
+}
+
+void Logger::WriteLine(int lvl, std::time_t time, const char* text, size_t length)
 {
-	pt::time_facet *facet = new pt::time_facet("%H:%M:%S");
-	out.imbue(std::locale(out.getloc(), facet));
+	// only the writer or the single direct writer gets here, localtime is not reentrant
+	char timeText[16];
+	std::strftime(timeText, sizeof(timeText), "%H:%M:%S", std::localtime(&time));
+
+	out << timeText << ' ' << levelName[lvl] << ' ';
+	out.write(text, length);
+	out << '\n';
+}
+
+void Logger::Run()
+{
+	size_t reportedDrops = 0;
+
+	for (;;) {
+		bool stopping = !running.load(std::memory_order_acquire);
+
+		if (!WriteQueued()) {
+			size_t drops = dropped.load(std::memory_order_relaxed);
+			if (drops != reportedDrops) {
+				out << "         " << levelName[Warning] << ' ' << drops - reportedDrops << " messages dropped, the log buffer was full\n";
+				reportedDrops = drops;
+			}
+
+			out.flush();
+			flushed.store(head, std::memory_order_release);
+
+			if (stopping)
+				break;
+			std::this_thread::sleep_for(WRITER_IDLE);
+		}
+	}
+}
+
+void Logger::Flush()
+{
+	if (!running.load(std::memory_order_acquire))
+		return;
+
+	size_t target = tail.load(std::memory_order_acquire);
+	auto start = std::chrono::steady_clock::now();
+	while (flushed.load(std::memory_order_acquire) < target && std::chrono::steady_clock::now() - start < FLUSH_TIMEOUT)
+		std::this_thread::yield();
 }
 
-std::ostream& Logger::GetStream(int lvl)
+void Logger::Shutdown()
 {
-	if (lvl > loglvl)
-		return std::cerr;
+	if (!running.exchange(false))
+		return;
 
-	pt::ptime now = pt::second_clock::local_time();
-	out << now << ' ' << levelName[lvl] <<  ' ';
-	return out;
+	// the writer drains the queue once more before it returns, the messages published
+	// while it did are drained here
+	std::lock_guard<std::mutex> lock(directMutex);
+	writer.join();
+	WriteQueued();
+	out.flush();
 }
@@ -1,20 +1,90 @@
 #ifndef LOG_H
 #define LOG_H
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <ctime>
+
 namespace Log
 {
 
-class Logger
+// Stream buffer over a fixed array, so a message is formatted without touching the
+// heap. Longer messages are cut off.
+class MessageBuffer : public std::streambuf
 {
-	int loglvl;
+public:
+	static const size_t SIZE = 480;
+
+private:
+	char text[SIZE];
 
-	std::ofstream out;
+public:
+	MessageBuffer()
+	{
+		setp(text, text + SIZE);
+	}
+
+	const char* GetText() const
+	{
+		return pbase();
+	}
+
+	size_t GetLength() const
+	{
+		return pptr() - pbase();
+	}
+
+private:
+	MessageBuffer(const MessageBuffer&) /*= delete*/;
+	MessageBuffer& operator=(const MessageBuffer&) /*= delete*/;
+};
+
+// The messages are queued in a lock-free ring buffer and written to log.txt by a
+// background thread, which flushes the file whenever the queue runs empty. Write is
+// safe to call from any thread.
+class Logger
+{
 public:
 	enum LogLevel
 	{
 		Crit, Error, Warning, Msg, Debug, Trace, NUM_LEVELS,
 	};
 
+	// What happens to a message while the ring buffer is full
+	enum DropPolicy
+	{
+		DropNewest,  // the message is dropped and counted, Crit and Error wait for a free slot
+		Block,       // the caller waits until the writer made room
+	};
+
+	static const size_t CAPACITY = 512;  // slots in the ring buffer, a power of two
+
+private:
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		int level;
+		std::time_t time;
+		size_t length;
+		char text[MessageBuffer::SIZE];
+	};
+
+	std::atomic<int> loglvl;
+	std::atomic<int> dropPolicy;
+
+	Slot slots[CAPACITY];
+	std::atomic<size_t> tail;     // next slot to fill
+	size_t head;                  // next slot to write, by the writer or under directMutex
+	std::atomic<size_t> flushed;  // messages written and flushed so far
+	std::atomic<size_t> dropped;
+
+	std::ofstream out;
+	std::mutex directMutex;       // guards out and head once the writer stopped
+	std::atomic<bool> running;
+	std::thread writer;
+
+public:
 	static Logger& Instance()
 	{
 		static Logger instance;
@@ -23,18 +93,47 @@ public:
 
 	int GetLogLevel() const
 	{
-		return loglvl;
+		return loglvl.load(std::memory_order_relaxed);
 	}
 
 	void SetLogLevel(int lvl)
 	{
-		loglvl = lvl;
+		loglvl.store(lvl, std::memory_order_relaxed);
 	}
 
-	std::ostream& GetStream(int lvl);
+	DropPolicy GetDropPolicy() const
+	{
+		return static_cast<DropPolicy>(dropPolicy.load(std::memory_order_relaxed));
+	}
+
+	void SetDropPolicy(DropPolicy policy)
+	{
+		dropPolicy.store(policy, std::memory_order_relaxed);
+	}
+
+	// Number of messages dropped because the ring buffer was full
+	size_t GetNumDropped() const
+	{
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+	// Queue a message, use the LOG macro instead of calling it directly
+	void Write(int lvl, const char* text, size_t length);
+
+	// Wait until everything queued so far is in the file, gives up after a second so a
+	// crash path cannot hang on it
+	void Flush();
+
+	// Write the remaining messages and stop the writer, later messages are written directly
+	void Shutdown();
 
 private:
+	void Run();
+	bool WriteQueued();
+	void WriteLine(int lvl, std::time_t time, const char* text, size_t length);
+
 	Logger();
+	~Logger();
 	Logger(const Logger&) /*= delete*/;
 	Logger& operator=(const Logger&) /*= delete*/;
 };
@@ -45,7 +144,10 @@ private:
 	do { \
 		Log::Logger& L_ = Log::Logger::Instance(); \
 		if (Log::Logger::lvl_ <= L_.GetLogLevel()) { \
-			L_.GetStream(Log::Logger::lvl_) << msg_ << std::endl; \
+			Log::MessageBuffer B_; \
+			std::ostream S_(&B_); \
+			S_ << msg_; \
+			L_.Write(Log::Logger::lvl_, B_.GetText(), B_.GetLength()); \
 		} \
 	} while (0)
 
@@ -4,6 +4,10 @@
 #include "Utility.h"
 #include "DataPaths.h"
 #include "ResourceManager.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+#include "WalkPath.h"
+#include "TowerSettings.h"
 
 #include "json_spirit/json_spirit.h"
 #include "jsex.h"
@@ -13,7 +17,7 @@ namespace js = json_spirit;
 
 namespace sf {
 
-	// Compare operator for the Map::towerPlaces and Map::towers sets.
+	// Compare operator for the Map::towers set and the keys of Map::blockPaths.
 	bool operator < (const sf::Vector2i& a, const sf::Vector2i& b)
 	{
 		if (a.x == b.x) {
@@ -23,6 +27,43 @@ namespace sf {
 	}
 }
 
+Map::Map()
+: blockSize(0), pathVersion(0), mazeMode(false), spawnCheckVersion(static_cast<size_t>(-1))
+{ }
+
+// The path is either a list of rows, '#' for a path block and '.' for the others, or a
+// list of bools for all blocks with an optional width, by default that of the background.
+static void ReadPathGrid(js::mObject& path, size_t defaultWidth, NavGrid& grid)
+{
+	if (path.count("rows")) {
+		js::mArray& rows = path["rows"].get_array();
+		const size_t width = rows.empty() ? 0 : rows[0].get_str().size();
+		grid.Create(width, rows.size());
+		for (size_t y=0; y < rows.size(); ++y) {
+			const std::string& row = rows[y].get_str();
+			if (row.size() != width)
+				throw std::runtime_error("path rows differ in length");
+			for (size_t x=0; x < width; ++x) {
+				if (row[x] == '#')
+					grid.SetWalkable(Vector2i(static_cast<int>(x), static_cast<int>(y)), true);
+				else if (row[x] != '.')
+					throw std::runtime_error("invalid block in path row");
+			}
+		}
+		return;
+	}
+
+	js::mArray& cells = path["grid"].get_array();
+	const size_t width = jsex::get_opt<size_t>(path, "width", defaultWidth);
+	if (width == 0 || cells.size() % width != 0)
+		throw std::runtime_error("path grid does not match its width");
+	grid.Create(width, cells.size() / width);
+	for (size_t i=0; i < cells.size(); ++i) {
+		if (cells[i].get_bool())
+			grid.SetWalkable(Vector2i(static_cast<int>(i % width), static_cast<int>(i / width)), true);
+	}
+}
+
 bool Map::LoadFromFile(const std::string& map)
 {
 	if (map == prevMap)
@@ -36,6 +77,7 @@ bool Map::LoadFromFile(const std::string& map)
 	std::ifstream in(filePath.string());
 	js::mValue rootValue;
 	try {
+		PROFILE_ZONE_DETAIL("Map::LoadFromFile/json", filePath.string());
 		js::read_or_throw(in, rootValue);
 	}
 	catch (js::Error_position err) {
@@ -67,12 +109,21 @@ bool Map::LoadFromFile(const std::string& map)
 		js::mObject& path = rootObj["path"].get_obj();
 		blockSize = jsex::get<size_t>(path["block-size"]);
 
-		pathGrid = jsex::read_vector<bool>(path["grid"].get_array());
+		ReadPathGrid(path, bg.GetImage()->GetWidth() / blockSize, pathGrid);
+		origPathGrid = pathGrid;
+		towers.clear();
 	}
 	catch (std::runtime_error err) {
 		throw GameError() << ErrorInfo::Desc("Json error") << ErrorInfo::Note(err.what()) << boost::errinfo_file_name(filePath.string());
 	}
 
+	flowFields.clear();
+	GetFlowField(PositionToBlock(defaultTarget));
+	walkPaths.clear();
+	blockPaths.clear();
+	coverage.clear();
+	pathVersion++;
+
 	prevMap = map;
 	
 	return true;
@@ -81,20 +132,183 @@ bool Map::LoadFromFile(const std::string& map)
 void Map::Reset()
 {
 	towerPlaces = origTowerPlaces;
+
+	// open the path again, the flow fields start over
+	if (!towers.empty()) {
+		pathGrid = origPathGrid;
+		towers.clear();
+		for (auto it = flowFields.begin(); it != flowFields.end(); ++it)
+			it->Compute(pathGrid, it->GetTarget());
+		walkPaths.clear();
+		blockPaths.clear();
+		coverage.clear();
+		pathVersion++;
+	}
+}
+
+Vector2f Map::SnapToPathBlock(Vector2f pos) const
+{
+	Vector2i blk = PositionToBlock(pos);
+	return mazeMode && IsPathBlock(blk) ? BlockToPosition(blk) : pos;
+}
+
+Map::TowerPlace Map::CheckTowerPlace(Vector2f pos) const
+{
+	if (boost::range::find(towerPlaces, pos) != towerPlaces.end())
+		return FreePlace;
+
+	// only the center of a free path block, which is neither the target nor a spawn
+	Vector2i blk = PositionToBlock(pos);
+	if (!mazeMode || !IsPathBlock(blk) || BlockToPosition(blk) != pos || IsInTargetArea(pos))
+		return InvalidPlace;
+	for (size_t i=0; i < spawnPlaces.size(); ++i) {
+		if (PositionToBlock(spawnPlaces[i]) == blk)
+			return InvalidPlace;
+	}
+
+	PROFILE_ZONE("Map::CheckTowerPlace");
+
+	const FlowField& field = GetFlowField(PositionToBlock(defaultTarget));
+	for (size_t i=0; i < spawnPlaces.size(); ++i) {
+		// a block beside the way of a spawn does not change the distance of the spawn
+		Vector2i spawn = PositionToBlock(spawnPlaces[i]);
+		Vector2i cur = spawn;
+		bool onWay = cur == blk;
+		for (Vector2i next = field.GetNext(cur); !onWay && next != cur; cur = next, next = field.GetNext(cur))
+			onWay = next == blk;
+		if (!onWay)
+			continue;
+
+		// otherwise search a way around it
+		if (spawnCheckVersion != pathVersion) {
+			spawnCheckGrid = pathGrid;
+			spawnCheck.SetGrid(spawnCheckGrid);
+			spawnCheckVersion = pathVersion;
+		}
+		spawnCheckGrid.SetWalkable(blk, false);
+		const bool found = spawnCheck.FindPath(spawn, field.GetTarget(), spawnCheckPath);
+		spawnCheckGrid.SetWalkable(blk, true);
+		if (!found)
+			return BlocksSpawn;
+	}
+	return FreePlace;
+}
+
+bool Map::IsPathBlock(const Vector2i& blk) const
+{
+	return pathGrid.Contains(blk) && pathGrid.IsWalkable(blk.x, blk.y);
 }
 
 void Map::PlaceTower(Vector2f pos)
 {
-	assert(boost::range::find(towerPlaces, pos) != towerPlaces.end());
-	towerPlaces.erase(boost::remove(towerPlaces, pos), towerPlaces.end());
+	if (boost::range::find(towerPlaces, pos) != towerPlaces.end()) {
+		towerPlaces.erase(boost::remove(towerPlaces, pos), towerPlaces.end());
+		return;
+	}
+
+	// a tower on the path, the enemies have to walk around it
+	assert(CheckTowerPlace(pos) == FreePlace);
+	Vector2i blk = PositionToBlock(pos);
+	pathGrid.SetWalkable(blk, false);
+	towers.insert(blk);
+	for (auto it = flowFields.begin(); it != flowFields.end(); ++it)
+		it->Block(pathGrid, blk);
+	walkPaths.clear();
+	blockPaths.clear();
+	coverage.clear();
+	pathVersion++;
 }
 
 void Map::RemoveTower(Vector2f pos)
 {
-	towerPlaces.push_back(pos);
+	Vector2i blk = PositionToBlock(pos);
+	if (towers.count(blk) == 0 || BlockToPosition(blk) != pos) {
+		towerPlaces.push_back(pos);
+		return;
+	}
+
+	towers.erase(blk);
+	pathGrid.SetWalkable(blk, true);
+	for (auto it = flowFields.begin(); it != flowFields.end(); ++it)
+		it->Unblock(pathGrid, blk);
+	walkPaths.clear();
+	blockPaths.clear();
+	coverage.clear();
+	pathVersion++;
+}
+
+const FlowField& Map::GetFlowField(const Vector2i& target) const
+{
+	for (auto it = flowFields.begin(); it != flowFields.end(); ++it) {
+		if (it->GetTarget() == target)
+			return *it;
+	}
+
+	flowFields.push_back(FlowField());
+	flowFields.back().Compute(pathGrid, target);
+	return flowFields.back();
+}
+
+std::shared_ptr<const WalkPath> Map::GetWalkPath(const Vector2f& start, const Vector2i& target) const
+{
+	for (auto it = walkPaths.begin(); it != walkPaths.end(); ++it) {
+		if ((*it)->GetStart() == start && (*it)->GetTarget() == target)
+			return *it;
+	}
+
+	std::shared_ptr<WalkPath> path(new WalkPath());
+	path->Build(pathGrid, blockSize, GetFlowField(target), start);
+	walkPaths.push_back(path);
+	return path;
+}
+
+std::shared_ptr<const WalkPath> Map::GetBlockPath(const Vector2i& blk, const Vector2i& target) const
+{
+	std::shared_ptr<const WalkPath>& path = blockPaths[std::make_pair(blk, target)];
+	if (!path) {
+		std::shared_ptr<WalkPath> p(new WalkPath());
+		p->Build(pathGrid, blockSize, GetFlowField(target), BlockToPosition(blk));
+		path = p;
+	}
+	return path;
+}
+
+std::shared_ptr<const WalkPath> Map::GetSpawnPath(size_t spawn) const
+{
+	return GetWalkPath(spawnPlaces[spawn], PositionToBlock(defaultTarget));
+}
+
+const Map::Coverage& Map::GetCoverage(const Vector2f& place, float range) const
+{
+	for (auto it = coverage.begin(); it != coverage.end(); ++it) {
+		if (it->place == place && it->range == range)
+			return *it;
+	}
+
+	PROFILE_ZONE("Map::GetCoverage");
+
+	coverage.push_back(Coverage());
+	Coverage& cov = coverage.back();
+	cov.place = place;
+	cov.range = range;
+	cov.spawns.resize(spawnPlaces.size());
+	for (size_t i=0; i < spawnPlaces.size(); ++i)
+		GetSpawnPath(i)->GetCoverage(place, range, cov.spawns[i]);
+	return cov;
+}
+
+void Map::PrecomputeCoverage(const std::vector<float>& ranges)
+{
+	PROFILE_ZONE("Map::PrecomputeCoverage");
+
+	for (auto place = origTowerPlaces.begin(); place != origTowerPlaces.end(); ++place) {
+		const float factor = IsHighRange(*place) ? HIGH_RANGE_FACTOR : 1.0f;
+		for (auto range = ranges.begin(); range != ranges.end(); ++range)
+			GetCoverage(*place, *range * factor);
+	}
 }
 
-void Map::Draw(RenderTarget& target)
+void Map::Draw(RenderTarget& target) const
 {
-	target.Draw(bg);
+	RenderStats::Draw(target, bg);
 }
@@ -1,17 +1,34 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include "FlowField.h"
+#include "GridAStar.h"
+#include "NavGrid.h"
+#include "WalkPath.h"
+
+#include <map>
+
 class Map
 {
+public:
+	// The stretches of the walk paths from the spawns within range of a tower place
+	struct Coverage
+	{
+		Vector2f place;
+		float range;
+		std::vector<std::vector<WalkPath::Interval>> spawns;  // by spawn
+	};
+
+private:
 	std::string prevMap;
 
 	Sprite bg;
 
 	size_t blockSize;
-	std::vector<bool> pathGrid;
+	NavGrid pathGrid, origPathGrid;
 
 	// Only access these sets in Map.cpp, the operator < for Vector2i is only defined there.
-	std::set<Vector2i> towers;
+	std::set<Vector2i> towers;  // path blocks blocked by towers in maze mode
 	std::vector<Vector2f> towerPlaces, origTowerPlaces;
 	std::vector<Vector2f> highRangePlaces;
 	std::vector<Vector2f> firePlaces;
@@ -21,15 +38,69 @@ class Map
 
 	std::vector<Vector2f> spawnPlaces;
 
+	// computed on first use, a deque keeps the references handed out valid
+	mutable std::deque<FlowField> flowFields;
+
+	// walk paths from the spawns, towers in maze mode throw them away and change the version
+	mutable std::vector<std::shared_ptr<const WalkPath>> walkPaths;
+	// walk paths from the centers of blocks, by block and target, thrown away with the
+	// others (only access it in Map.cpp, like the sets above)
+	mutable std::map<std::pair<Vector2i, Vector2i>, std::shared_ptr<const WalkPath>> blockPaths;
+	size_t pathVersion;
+
+	// coverage of the tower places, thrown away together with the walk paths
+	mutable std::deque<Coverage> coverage;
+
+	bool mazeMode;
+
+	// checks if a tower would cut off a spawn, on a copy of the path grid as of
+	// spawnCheckVersion where the block of the tower is closed during the search
+	mutable GridAStar spawnCheck;
+	mutable NavGrid spawnCheckGrid;
+	mutable size_t spawnCheckVersion;
+	mutable std::vector<Vector2i> spawnCheckPath;
+
 public:
+	enum TowerPlace {
+		InvalidPlace, FreePlace, BlocksSpawn,
+	};
+
+	Map();
+
 	bool LoadFromFile(const std::string& map);
 	void Reset();
 
-	void Draw(RenderTarget& target);
+	void Draw(RenderTarget& target) const;
+
+	// In maze mode towers can also be placed on the center of a path block, the enemies
+	// then walk around them
+	void SetMazeMode(bool maze)
+	{
+		mazeMode = maze;
+	}
+
+	bool IsMazeMode() const
+	{
+		return mazeMode;
+	}
+
+	// FreePlace for a free tower place or in maze mode for the center of a free path
+	// block, unless the block would cut a spawn off the target
+	TowerPlace CheckTowerPlace(Vector2f pos) const;
+
+	// Center of the path block at pos if a tower could block it in maze mode, otherwise pos
+	Vector2f SnapToPathBlock(Vector2f pos) const;
 
 	void PlaceTower(Vector2f pos);
 	void RemoveTower(Vector2f pos);
 
+	// Add a new place for towers, until the map gets loaded again (used for benchmarks)
+	void AddTowerPlace(Vector2f pos)
+	{
+		towerPlaces.push_back(pos);
+		origTowerPlaces.push_back(pos);
+	}
+
 	const std::vector<Vector2f>& GetTowerPlaces() const
 	{
 		return towerPlaces;
@@ -85,11 +156,38 @@ public:
 		return Vector2i(static_cast<int>(pos.x / blockSize), static_cast<int>(pos.y / blockSize));
 	}
 
-	const std::vector<bool>& GetPathGrid() const
+	const NavGrid& GetPathGrid() const
 	{
 		return pathGrid;
 	}
 
+	// Flow field to the given target block, shared by all enemies walking there. The
+	// field to the default target is computed while loading the map.
+	const FlowField& GetFlowField(const Vector2i& target) const;
+
+	// Smoothed path from start to the target block, kept for everyone else starting at
+	// the same position, like all enemies of a spawn.
+	std::shared_ptr<const WalkPath> GetWalkPath(const Vector2f& start, const Vector2i& target) const;
+
+	// Smoothed path from the center of blk to the target block, kept for everyone in the
+	// block. The enemies go on there when towers in maze mode changed their way.
+	std::shared_ptr<const WalkPath> GetBlockPath(const Vector2i& blk, const Vector2i& target) const;
+
+	// The shared walk path of the enemies of a spawn to the default target
+	std::shared_ptr<const WalkPath> GetSpawnPath(size_t spawn) const;
+
+	// The parts of the spawn paths within range of a tower at place. The tower places
+	// get their coverage for the given tower ranges up front, HIGH_RANGE_FACTOR applied
+	// to the high range places, any other is computed on first use.
+	const Coverage& GetCoverage(const Vector2f& place, float range) const;
+	void PrecomputeCoverage(const std::vector<float>& ranges);
+
+	// Changes whenever towers change the ways, the walk paths have to be fetched again
+	size_t GetPathVersion() const
+	{
+		return pathVersion;
+	}
+
 	size_t GetBlockSize() const
 	{
 		return blockSize;
@@ -97,13 +195,16 @@ public:
 
 	size_t GetWidthBlocks() const
 	{
-		return bg.GetImage()->GetWidth() / blockSize;
+		return pathGrid.GetWidth();
 	}
 
 	size_t GetHeightBlocks() const
 	{
-		return bg.GetImage()->GetHeight() / blockSize;
+		return pathGrid.GetHeight();
 	}
+
+private:
+	bool IsPathBlock(const Vector2i& blk) const;
 };
 
 #endif //MAP_H
@@ -0,0 +1,52 @@
+#include "pch.h"
+#include "NavGrid.h"
+
+#include <cstring>
+
+NavGrid::NavGrid()
+: width(0), height(0), stride(0)
+{ }
+
+void NavGrid::Create(size_t w, size_t h)
+{
+	width = w;
+	height = h;
+	stride = (width + 2 + 7) & ~size_t(7);
+	cells.assign(stride * (height + 2), 0);
+}
+
+void NavGrid::SetWalkable(const Vector2i& blk, bool walkable)
+{
+	assert(Contains(blk));
+
+	// the neighbors see blk from the opposite side
+	const size_t idx = (blk.y + 1) * stride + (blk.x + 1);
+	const size_t neighbor[] = { idx - 1, idx + 1, idx - stride, idx + stride };
+	const uint8_t seenAs[] = { RightWalkable, LeftWalkable, DownWalkable, UpWalkable };
+
+	if (walkable) {
+		cells[idx] |= Walkable;
+		for (size_t n=0; n < 4; ++n)
+			cells[neighbor[n]] |= seenAs[n];
+	}
+	else {
+		cells[idx] &= static_cast<uint8_t>(~Walkable);
+		for (size_t n=0; n < 4; ++n)
+			cells[neighbor[n]] &= static_cast<uint8_t>(~seenAs[n]);
+	}
+}
+
+size_t NavGrid::CountWalkable() const
+{
+	// the border and the padding are never walkable, so all rows can be scanned in one go
+	static const uint64_t LOW_BITS = 0x0101010101010101ULL;
+
+	size_t count = 0;
+	for (size_t i=0; i < cells.size(); i += 8) {
+		uint64_t word;
+		std::memcpy(&word, &cells[i], sizeof(word));
+		// one bit per byte, the multiplication adds them up in the highest byte
+		count += static_cast<size_t>((((word >> 4) & LOW_BITS) * LOW_BITS) >> 56);
+	}
+	return count;
+}
@@ -0,0 +1,74 @@
+#ifndef NAV_GRID_H
+#define NAV_GRID_H
+
+#include <cstdint>
+
+// The walkable blocks of a map for the path searches. Every block is one byte with a
+// bit for itself and one for each walkable neighbor, in the order left, right, up,
+// down, the same as the offsets of the searches. The bytes are stored row by row with
+// a border of blocks that are never walkable, so the blocks next to any block of the
+// grid can be read without a bounds check. Rows are padded to a multiple of eight
+// bytes, scans read eight blocks at once.
+class NavGrid
+{
+public:
+	enum {
+		LeftWalkable  = 1,
+		RightWalkable = 2,
+		UpWalkable    = 4,
+		DownWalkable  = 8,
+		Walkable      = 16,
+	};
+
+private:
+	size_t width, height;
+	size_t stride;  // bytes per row, including the border and the padding
+	std::vector<uint8_t> cells;
+
+public:
+	NavGrid();
+
+	// Make the grid width * height blocks large, none of them walkable
+	void Create(size_t width, size_t height);
+
+	// Changes the bits of the neighbors as well, blk has to be in the grid
+	void SetWalkable(const Vector2i& blk, bool walkable);
+
+	size_t GetWidth() const
+	{
+		return width;
+	}
+
+	size_t GetHeight() const
+	{
+		return height;
+	}
+
+	bool Contains(const Vector2i& blk) const
+	{
+		return blk.x >= 0 && blk.y >= 0 && static_cast<size_t>(blk.x) < width && static_cast<size_t>(blk.y) < height;
+	}
+
+	// x and y may be one block outside of the grid, these blocks are not walkable
+	bool IsWalkable(int x, int y) const
+	{
+		return (GetCell(x, y) & Walkable) != 0;
+	}
+
+	// Bit n is set if the neighbor n is walkable, x and y have to be in the grid
+	uint8_t GetNeighbors(int x, int y) const
+	{
+		return GetCell(x, y) & (LeftWalkable | RightWalkable | UpWalkable | DownWalkable);
+	}
+
+	size_t CountWalkable() const;
+
+private:
+	uint8_t GetCell(int x, int y) const
+	{
+		assert(x >= -1 && y >= -1 && x <= static_cast<int>(width) && y <= static_cast<int>(height));
+		return cells[(y + 1) * stride + (x + 1)];
+	}
+};
+
+#endif //NAV_GRID_H
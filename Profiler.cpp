@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "Profiler.h"
+#include "Error.h"
+#include "Log.h"
+
+#include <cstring>
+#include <iomanip>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <chrono>
+#endif
+
+Profiler::Profiler()
+: enabled(false), frameStart(0), frames(HISTORY), nextFrame(0), numFrames(0), traceStart(0)
+{
+	stack.reserve(32);
+}
+
+Profiler::~Profiler()
+{
+	StopTrace();
+}
+
+size_t Profiler::GetZoneId(const char* name)
+{
+	for (size_t i=0; i < zones.size(); ++i) {
+		if (std::strcmp(zones[i].name, name) == 0)
+			return i;
+	}
+
+	zones.push_back(Zone(name));
+	return zones.size() - 1;
+}
+
+void Profiler::ResetStats()
+{
+	boost::for_each(zones, [](Zone& z) {
+		z.time = 0;
+		z.calls = 0;
+	});
+}
+
+void Profiler::BeginFrame()
+{
+	frameStart = enabled ? GetTime() : 0;
+
+	boost::for_each(zones, [](Zone& z) {
+		z.frameTime = 0;
+	});
+}
+
+void Profiler::EndFrame()
+{
+	// only record frames which were profiled completely
+	if (!enabled || !frameStart)
+		return;
+
+	Frame& frame = frames[nextFrame];
+	frame.time = GetTime() - frameStart;
+	frame.zoneTimes.resize(zones.size());
+	for (size_t i=0; i < zones.size(); ++i)
+		frame.zoneTimes[i] = zones[i].frameTime;
+
+	nextFrame = (nextFrame + 1) % HISTORY;
+	if (numFrames < HISTORY)
+		numFrames++;
+}
+
+static std::string EscapeJson(const std::string& str)
+{
+	std::string escaped;
+	escaped.reserve(str.size());
+	for (auto it = str.begin(); it != str.end(); ++it) {
+		if (*it == '"' || *it == '\\')
+			escaped += '\\';
+		escaped += *it;
+	}
+	return escaped;
+}
+
+void Profiler::StartTrace(const std::string& fileName)
+{
+	StopTrace();
+
+	std::unique_ptr<std::ofstream> out(new std::ofstream(fileName));
+	if (!out->is_open())
+		throw GameError() << ErrorInfo::Desc("Failed to open trace file") << boost::errinfo_file_name(fileName);
+
+	*out << "[\n"
+	     << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Drachen\"}},\n"
+	     << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}";
+	*out << std::fixed << std::setprecision(3);
+
+	trace = std::move(out);
+	traceStart = GetTime();
+
+	LOG(Msg, "Writing trace to " << fileName);
+}
+
+void Profiler::StopTrace()
+{
+	if (!trace)
+		return;
+
+	*trace << "\n]\n";
+	trace.reset();
+}
+
+void Profiler::WriteTraceEvent(size_t zone, char phase, uint64_t time, const std::string* detail)
+{
+	// the metadata events come first, so every event needs a separating comma,
+	// time stamps are in microseconds
+	std::ofstream& out = *trace;
+	out << ",\n{\"name\":\"" << zones[zone].name << "\",\"ph\":\"" << phase << "\",\"ts\":" << (time - traceStart) / 1000.0
+	    << ",\"pid\":1,\"tid\":1";
+	if (detail)
+		out << ",\"args\":{\"detail\":\"" << EscapeJson(*detail) << "\"}";
+	out << "}";
+}
+
+/*static*/ uint64_t Profiler::GetTime()
+{
+#ifdef WIN32
+	// high_resolution_clock only has a resolution of milliseconds in VS2012
+	static LARGE_INTEGER frequency = { 0 };
+	if (!frequency.QuadPart)
+		QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return static_cast<uint64_t>(now.QuadPart / frequency.QuadPart * 1000000000ull
+		+ now.QuadPart % frequency.QuadPart * 1000000000ull / frequency.QuadPart);
+#else
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
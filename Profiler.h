@@ -0,0 +1,221 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <memory>
+
+// Collects the time spent in named code zones. Zones get registered once (see
+// PROFILE_ZONE) and accumulate their time and number of calls until the stats are
+// reset. Zones nest, the parent of a zone is the zone it was first entered in.
+// Between BeginFrame and EndFrame the times per zone are also kept for the last
+// HISTORY frames. While the profiler is disabled, a zone costs a single branch.
+// Independent of that, every zone can be written as begin/end events to a trace
+// file in the Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+class Profiler
+{
+public:
+	static const size_t HISTORY = 240;
+	static const size_t NO_PARENT = static_cast<size_t>(-1);
+
+	struct Zone
+	{
+		const char* name;
+		size_t parent;
+		size_t depth;
+		bool placed;     // parent and depth are known
+
+		uint64_t time;   // nanoseconds
+		uint64_t calls;
+		uint64_t frameTime;
+
+		explicit Zone(const char* name)
+		: name(name), parent(NO_PARENT), depth(0), placed(false), time(0), calls(0), frameTime(0)
+		{ }
+	};
+
+	static Profiler& Instance()
+	{
+		static Profiler instance;
+		return instance;
+	}
+
+	bool IsEnabled() const
+	{
+		return enabled;
+	}
+
+	void SetEnabled(bool e)
+	{
+		enabled = e;
+	}
+
+	// Write all zones entered from now on to the trace file, throws a GameError
+	// if the file can not be opened
+	void StartTrace(const std::string& fileName);
+	// Finish the trace file, happens automatically on exit
+	void StopTrace();
+
+	bool IsTracing() const
+	{
+		return trace != nullptr;
+	}
+
+	// Zones get measured while profiling or tracing
+	bool IsActive() const
+	{
+		return enabled || trace;
+	}
+
+	// Get the id of the zone with the given name, registering it if necessary
+	size_t GetZoneId(const char* name);
+
+	// The detail (e.g. a file name) only shows up in the trace, it may be nullptr
+	void Enter(size_t zone, uint64_t time, const std::string* detail)
+	{
+		Zone& z = zones[zone];
+		if (!z.placed) {
+			z.placed = true;
+			if (!stack.empty()) {
+				z.parent = stack.back();
+				z.depth = zones[z.parent].depth + 1;
+			}
+		}
+		stack.push_back(zone);
+
+		if (trace)
+			WriteTraceEvent(zone, 'B', time, detail);
+	}
+
+	void Leave(size_t zone, uint64_t start, uint64_t end)
+	{
+		Zone& z = zones[zone];
+		z.time += end - start;
+		z.calls++;
+		z.frameTime += end - start;
+		stack.pop_back();
+
+		if (trace)
+			WriteTraceEvent(zone, 'E', end, nullptr);
+	}
+
+	const std::vector<Zone>& GetZones() const
+	{
+		return zones;
+	}
+
+	// Set the time and calls of all zones to zero
+	void ResetStats();
+
+	void BeginFrame();
+	void EndFrame();
+
+	// Number of frames in the history
+	size_t GetNumFrames() const
+	{
+		return numFrames;
+	}
+
+	// Time of the frame before the given number of frames (0 is the last finished frame)
+	uint64_t GetFrameTime(size_t age) const
+	{
+		return frames[HistoryIndex(age)].time;
+	}
+
+	// Time of the zone in the frame before the given number of frames
+	uint64_t GetZoneFrameTime(size_t age, size_t zone) const
+	{
+		const Frame& f = frames[HistoryIndex(age)];
+		return zone < f.zoneTimes.size() ? f.zoneTimes[zone] : 0;
+	}
+
+	// Monotonic time in nanoseconds
+	static uint64_t GetTime();
+
+private:
+	struct Frame
+	{
+		uint64_t time;
+		std::vector<uint64_t> zoneTimes;
+
+		Frame()
+		: time(0)
+		{ }
+	};
+
+	bool enabled;
+	std::vector<Zone> zones;
+	std::vector<size_t> stack;
+
+	uint64_t frameStart;
+	std::vector<Frame> frames;  // ring buffer
+	size_t nextFrame, numFrames;
+
+	std::unique_ptr<std::ofstream> trace;
+	uint64_t traceStart;
+
+	void WriteTraceEvent(size_t zone, char phase, uint64_t time, const std::string* detail);
+
+	size_t HistoryIndex(size_t age) const
+	{
+		assert(age < numFrames);
+		return (nextFrame + HISTORY - 1 - age) % HISTORY;
+	}
+
+	Profiler();
+	~Profiler();
+	Profiler(const Profiler&) /*= delete*/;
+	Profiler& operator=(const Profiler&) /*= delete*/;
+};
+
+// Measures the time until the end of the scope, use PROFILE_ZONE instead of using it directly
+class ProfileScope
+{
+	size_t zone;
+	uint64_t start;
+
+public:
+	explicit ProfileScope(size_t zone)
+	: zone(zone), start(0)
+	{
+		Profiler& profiler = Profiler::Instance();
+		if (profiler.IsActive()) {
+			start = Profiler::GetTime();
+			profiler.Enter(zone, start, nullptr);
+		}
+	}
+
+	ProfileScope(size_t zone, const std::string& detail)
+	: zone(zone), start(0)
+	{
+		Profiler& profiler = Profiler::Instance();
+		if (profiler.IsActive()) {
+			start = Profiler::GetTime();
+			profiler.Enter(zone, start, &detail);
+		}
+	}
+
+	~ProfileScope()
+	{
+		if (start)
+			Profiler::Instance().Leave(zone, start, Profiler::GetTime());
+	}
+
+private:
+	ProfileScope(const ProfileScope&) /*= delete*/;
+	ProfileScope& operator=(const ProfileScope&) /*= delete*/;
+};
+
+#define PROFILE_CONCAT_(a_, b_) a_##b_
+#define PROFILE_CONCAT(a_, b_) PROFILE_CONCAT_(a_, b_)
+
+// Profile the rest of the current scope as the zone with the given name (a string literal)
+#define PROFILE_ZONE(name_) \
+	static const size_t PROFILE_CONCAT(profileZone_, __LINE__) = Profiler::Instance().GetZoneId(name_); \
+	ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileZone_, __LINE__))
+
+// Same as PROFILE_ZONE, the detail string gets added to the trace events
+#define PROFILE_ZONE_DETAIL(name_, detail_) \
+	static const size_t PROFILE_CONCAT(profileZone_, __LINE__) = Profiler::Instance().GetZoneId(name_); \
+	ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileZone_, __LINE__), detail_)
+
+#endif //PROFILER_H
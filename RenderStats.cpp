@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "RenderStats.h"
+
+RenderStats::RenderStats()
+: enabled(false), category(Other), boundImage(nullptr)
+{
+}
+
+void RenderStats::Count(const Drawable& drawable)
+{
+	Counters& counters = current[category];
+	counters.drawCalls++;
+
+	// a PostFX binds the frame buffer and its own textures
+	if (dynamic_cast<const PostFX*>(&drawable)) {
+		counters.postFxPasses++;
+		boundImage = nullptr;
+		return;
+	}
+
+	// shapes draw without an image, so the next sprite needs to bind its image again
+	const Image* image = nullptr;
+	if (const Sprite* sprite = dynamic_cast<const Sprite*>(&drawable))
+		image = sprite->GetImage();
+	else if (const String* str = dynamic_cast<const String*>(&drawable))
+		image = &str->GetFont().GetImage();
+
+	if (image && image != boundImage)
+		counters.imageChanges++;
+	boundImage = image;
+}
+
+void RenderStats::EndFrame()
+{
+	lastFrame = current;
+	current.fill(Counters());
+	boundImage = nullptr;
+}
+
+RenderStats::Counters RenderStats::GetFrameTotal() const
+{
+	Counters total;
+	for (size_t i=0; i < NUM_CATEGORIES; ++i)
+		total += lastFrame[i];
+	return total;
+}
+
+/*static*/ const char* RenderStats::GetCategoryName(Category c)
+{
+	switch (c) {
+	case Map:
+		return "map";
+	case Sprites:
+		return "sprites";
+	case HpBars:
+		return "hp bars";
+	case Projectiles:
+		return "projectiles";
+	case Effects:
+		return "effects";
+	case UserInterface:
+		return "interface";
+	case Overlay:
+		return "overlay";
+	default:
+		return "other";
+	}
+}
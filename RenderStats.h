@@ -0,0 +1,120 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+// Counts the rendering work of a frame per category: draw calls, full screen PostFX
+// passes and changes of the bound image. Everything drawn in the game goes through
+// RenderStats::Draw, the category is set with a RenderCategory for the current scope.
+// While disabled, Draw only forwards to the render target.
+class RenderStats
+{
+public:
+	enum Category {
+		Map, Sprites, HpBars, Projectiles, Effects, UserInterface, Overlay, Other, NUM_CATEGORIES,
+	};
+
+	struct Counters
+	{
+		size_t drawCalls;
+		size_t postFxPasses;
+		size_t imageChanges;
+
+		Counters()
+		: drawCalls(0), postFxPasses(0), imageChanges(0)
+		{ }
+
+		Counters& operator+=(const Counters& other)
+		{
+			drawCalls += other.drawCalls;
+			postFxPasses += other.postFxPasses;
+			imageChanges += other.imageChanges;
+			return *this;
+		}
+	};
+
+private:
+	bool enabled;
+	Category category;
+
+	std::array<Counters, NUM_CATEGORIES> current, lastFrame;
+
+	const Image* boundImage;
+
+public:
+	static RenderStats& Instance()
+	{
+		static RenderStats instance;
+		return instance;
+	}
+
+	static void Draw(RenderTarget& target, const Drawable& drawable)
+	{
+		RenderStats& stats = Instance();
+		if (stats.enabled)
+			stats.Count(drawable);
+		target.Draw(drawable);
+	}
+
+	bool IsEnabled() const
+	{
+		return enabled;
+	}
+
+	void SetEnabled(bool e)
+	{
+		enabled = e;
+	}
+
+	Category GetCategory() const
+	{
+		return category;
+	}
+
+	void SetCategory(Category c)
+	{
+		category = c;
+	}
+
+	// Finish the current frame, its counters are kept until the next call
+	void EndFrame();
+
+	// Counters of the last finished frame
+	const Counters& GetFrame(Category c) const
+	{
+		return lastFrame[c];
+	}
+
+	Counters GetFrameTotal() const;
+
+	static const char* GetCategoryName(Category c);
+
+private:
+	void Count(const Drawable& drawable);
+
+	RenderStats();
+	RenderStats(const RenderStats&) /*= delete*/;
+	RenderStats& operator=(const RenderStats&) /*= delete*/;
+};
+
+// Sets the category of all draw calls until the end of the scope
+class RenderCategory
+{
+	RenderStats::Category previous;
+
+public:
+	explicit RenderCategory(RenderStats::Category category)
+	: previous(RenderStats::Instance().GetCategory())
+	{
+		RenderStats::Instance().SetCategory(category);
+	}
+
+	~RenderCategory()
+	{
+		RenderStats::Instance().SetCategory(previous);
+	}
+
+private:
+	RenderCategory(const RenderCategory&) /*= delete*/;
+	RenderCategory& operator=(const RenderCategory&) /*= delete*/;
+};
+
+#endif //RENDER_STATS_H
@@ -0,0 +1,239 @@
+#include "pch.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "GlobalStatus.h"
+#include "Error.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace fs = boost::filesystem;
+
+/* replay file layout (all integers are unsigned LEB128 varints)
+
+	"DRRP"                  magic
+	<uint8>                 format version
+	<varint> <bytes>        level name
+	<varint>                random seed
+	<varint> * 3            start lives, start money, money per enemy
+	<varint>                number of commands
+	commands:
+		<varint>            ticks since the previous command
+		<uint8>             command type
+		...                 arguments, depending on the type:
+		                    AddTower: <varint> tower, <float> x, <float> y
+		                    UpgradeTower, SellTower: <float> x, <float> y
+		                    SpawnEnemy: <varint> enemy, <varint> spawn
+*/
+
+static const char ReplayMagic[4] = { 'D', 'R', 'R', 'P' };
+static const uint8_t ReplayVersion = 1;
+
+static void WriteVarint(std::ostream& out, uint64_t v)
+{
+	do {
+		uint8_t byte = v & 0x7f;
+		v >>= 7;
+		if (v)
+			byte |= 0x80;
+		out.put(static_cast<char>(byte));
+	} while (v);
+}
+
+static uint64_t ReadVarint(std::istream& in)
+{
+	uint64_t v = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		int byte = in.get();
+		if (byte == EOF)
+			throw GameError() << ErrorInfo::Desc("Unexpected end of replay");
+
+		v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return v;
+	}
+	throw GameError() << ErrorInfo::Desc("Invalid varint in replay");
+}
+
+static void WriteFloat(std::ostream& out, float f)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &f, sizeof(bits));
+	for (int i=0; i < 4; ++i)
+		out.put(static_cast<char>((bits >> (i * 8)) & 0xff));
+}
+
+static float ReadFloat(std::istream& in)
+{
+	uint32_t bits = 0;
+	for (int i=0; i < 4; ++i) {
+		int byte = in.get();
+		if (byte == EOF)
+			throw GameError() << ErrorInfo::Desc("Unexpected end of replay");
+		bits |= static_cast<uint32_t>(byte) << (i * 8);
+	}
+
+	float f;
+	std::memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+void Replay::Begin(const std::string& lvl, unsigned int sd, const GlobalStatus& gs)
+{
+	level = lvl;
+	seed = sd;
+	startLives = gs.startLives;
+	startMoney = gs.startMoney;
+	moneyPerEnemy = gs.moneyPerEnemy;
+	commands.clear();
+}
+
+void Replay::ApplySettings(GlobalStatus& gs) const
+{
+	gs.startLives = startLives;
+	gs.startMoney = startMoney;
+	gs.moneyPerEnemy = moneyPerEnemy;
+}
+
+void Replay::WriteToFile(const fs::path& path) const
+{
+	std::ofstream out(path.string(), std::ios::binary);
+	if (!out.is_open())
+		throw GameError() << ErrorInfo::Desc("Failed to open file") << boost::errinfo_file_name(path.string());
+
+	out.write(ReplayMagic, sizeof(ReplayMagic));
+	out.put(static_cast<char>(ReplayVersion));
+
+	WriteVarint(out, level.size());
+	out.write(level.data(), level.size());
+
+	WriteVarint(out, seed);
+	WriteVarint(out, startLives);
+	WriteVarint(out, startMoney);
+	WriteVarint(out, moneyPerEnemy);
+
+	WriteVarint(out, commands.size());
+	size_t prevTick = 0;
+	for (auto& cmd: commands) {
+		WriteVarint(out, cmd.tick - prevTick);
+		prevTick = cmd.tick;
+
+		out.put(static_cast<char>(cmd.type));
+		switch (cmd.type) {
+		case SimCommand::AddTower:
+			WriteVarint(out, cmd.tower);
+			WriteFloat(out, cmd.pos.x);
+			WriteFloat(out, cmd.pos.y);
+			break;
+
+		case SimCommand::UpgradeTower:
+		case SimCommand::SellTower:
+			WriteFloat(out, cmd.pos.x);
+			WriteFloat(out, cmd.pos.y);
+			break;
+
+		case SimCommand::SpawnEnemy:
+			WriteVarint(out, cmd.enemy);
+			WriteVarint(out, cmd.spawn);
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+void Replay::LoadFromFile(const fs::path& path)
+{
+	std::ifstream in(path.string(), std::ios::binary);
+	if (!in.is_open())
+		throw GameError() << ErrorInfo::Desc("Failed to open file") << boost::errinfo_file_name(path.string());
+
+	try {
+		char magic[4];
+		in.read(magic, sizeof(magic));
+		if (!in || !std::equal(magic, magic + 4, ReplayMagic))
+			throw GameError() << ErrorInfo::Desc("Not a replay file");
+
+		int version = in.get();
+		if (version != ReplayVersion)
+			throw GameError() << ErrorInfo::Desc("Unsupported replay version") << ErrorInfo::Note(boost::lexical_cast<std::string>(version));
+
+		level.resize(static_cast<size_t>(ReadVarint(in)));
+		in.read(&level[0], level.size());
+
+		seed          = static_cast<unsigned int>(ReadVarint(in));
+		startLives    = static_cast<size_t>(ReadVarint(in));
+		startMoney    = static_cast<size_t>(ReadVarint(in));
+		moneyPerEnemy = static_cast<size_t>(ReadVarint(in));
+
+		size_t numCommands = static_cast<size_t>(ReadVarint(in));
+		commands.clear();
+		commands.reserve(numCommands);
+
+		size_t tick = 0;
+		for (size_t i=0; i < numCommands; ++i) {
+			tick += static_cast<size_t>(ReadVarint(in));
+
+			int type = in.get();
+			if (type < 0 || type >= SimCommand::NUM_TYPES)
+				throw GameError() << ErrorInfo::Desc("Invalid command in replay");
+
+			SimCommand cmd(static_cast<SimCommand::Type>(type));
+			cmd.tick = tick;
+
+			switch (cmd.type) {
+			case SimCommand::AddTower:
+				cmd.tower = static_cast<size_t>(ReadVarint(in));
+				cmd.pos.x = ReadFloat(in);
+				cmd.pos.y = ReadFloat(in);
+				break;
+
+			case SimCommand::UpgradeTower:
+			case SimCommand::SellTower:
+				cmd.pos.x = ReadFloat(in);
+				cmd.pos.y = ReadFloat(in);
+				break;
+
+			case SimCommand::SpawnEnemy:
+				cmd.enemy = static_cast<size_t>(ReadVarint(in));
+				cmd.spawn = static_cast<size_t>(ReadVarint(in));
+				break;
+
+			default:
+				break;
+			}
+
+			commands.push_back(cmd);
+		}
+	}
+	catch (boost::exception& ex) {
+		ex << boost::errinfo_file_name(path.string());
+		throw;
+	}
+}
+
+ReplayPlayer::ReplayPlayer(const Replay& replay, Simulation& simulation)
+: replay(replay), simulation(simulation), nextCommand(0)
+{ }
+
+void ReplayPlayer::Start(GlobalStatus& gs)
+{
+	replay.ApplySettings(gs);
+	simulation.Reset(replay.level, replay.seed);
+	nextCommand = 0;
+}
+
+bool ReplayPlayer::Step()
+{
+	while (nextCommand < replay.commands.size() && replay.commands[nextCommand].tick <= simulation.GetTick()) {
+		simulation.Execute(replay.commands[nextCommand]);
+		nextCommand++;
+	}
+
+	if (!simulation.IsRunning())
+		return false;
+
+	simulation.Update(SIM_TICK);
+	return simulation.IsRunning();
+}
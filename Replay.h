@@ -0,0 +1,55 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "SimCommand.h"
+
+class Simulation;
+struct GlobalStatus;
+
+// Everything needed to re-run a game deterministically: the level, the random seed,
+// the global settings that influence the game and all commands with their tick.
+struct Replay
+{
+	std::string level;
+	unsigned int seed;
+
+	size_t startLives;
+	size_t startMoney;
+	size_t moneyPerEnemy;
+
+	std::vector<SimCommand> commands;
+
+	Replay()
+	: seed(0), startLives(0), startMoney(0), moneyPerEnemy(0)
+	{ }
+
+	// Start a new recording
+	void Begin(const std::string& level, unsigned int seed, const GlobalStatus& gs);
+
+	// Set the global settings recorded in the replay
+	void ApplySettings(GlobalStatus& gs) const;
+
+	void LoadFromFile(const boost::filesystem::path& path);
+	void WriteToFile(const boost::filesystem::path& path) const;
+};
+
+// Plays a replay on a simulation, one tick at a time.
+class ReplayPlayer
+{
+	const Replay& replay;
+	Simulation& simulation;
+
+	size_t nextCommand;
+
+public:
+	ReplayPlayer(const Replay& replay, Simulation& simulation);
+
+	// Reset the simulation to the start of the replay
+	void Start(GlobalStatus& gs);
+
+	// Execute the commands for the current tick and advance the simulation by one tick.
+	// Returns false once the game has ended.
+	bool Step();
+};
+
+#endif //REPLAY_H
@@ -31,32 +31,92 @@ OTHER DEALINGS IN THE SOFTWARE.
 
 #include <string>
 #include <map>
+#include <vector>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
 
 #include "Error.h"
 #include "Log.h"
+#include "Profiler.h"
+
+// Categories the memory of the resources is booked on, they follow from the data
+// directory a resource is loaded from
+struct ResourceUsage
+{
+    enum Category {
+        Theme, Map, LevelPack, Effects, Other, NUM_CATEGORIES,
+    };
+
+    static Category getCategory( const std::string& strId ) {
+        // the ids are native paths, on Windows with backslashes after the data directory
+        std::string id( strId );
+        std::replace( id.begin(), id.end(), '\\', '/' );
+
+        const char* prefixes[] = { "data/themes/", "data/maps/", "data/levels/", "data/effects/" };
+        for( size_t i=0; i < Other; ++i ) {
+            if( id.compare( 0, std::char_traits<char>::length( prefixes[i] ), prefixes[i] ) == 0 )
+                return static_cast<Category>( i );
+        }
+        return Other;
+    }
+
+    static const char* getCategoryName( Category c ) {
+        const char* names[] = { "theme", "map", "level packs", "effects", "other" };
+        return names[c];
+    }
+};
+
+// Resident memory of an image: SFML keeps the pixels in memory next to the uploaded texture.
+// Without support for non power of two textures the texture is larger than counted here.
+inline size_t getMemoryUsage( const sf::Image& image ) {
+    return 2 * image.GetWidth() * image.GetHeight() * 4;
+}
 
 template< class T >
 class ResourceManager {
 public:
-    typedef std::pair< std::string, T* >    Resource;
-    typedef std::map< std::string, T* >     ResourceMap;
+    struct Entry {
+        T* resource;
+        ResourceUsage::Category category;
+        size_t bytes;
+    };
+
+    typedef std::pair< std::string, Entry > Resource;
+    typedef std::map< std::string, Entry >  ResourceMap;
  
 private:
     ResourceMap m_resource;
+
+    size_t m_categoryBytes[ResourceUsage::NUM_CATEGORIES];
+    size_t m_categoryCount[ResourceUsage::NUM_CATEGORIES];
+    size_t m_totalBytes;
+    size_t m_peakBytes;
  
     T* find( const std::string& strId ) {
         T* resource = NULL;
         typename ResourceMap::iterator it = m_resource.find( strId );
         if( it != m_resource.end() ) {
-            resource = it->second;
+            resource = it->second.resource;
         }
  
         return resource;
     }
+
+    void release( typename ResourceMap::iterator it ) {
+        m_categoryBytes[it->second.category] -= it->second.bytes;
+        m_categoryCount[it->second.category]--;
+        m_totalBytes -= it->second.bytes;
+
+        delete it->second.resource;
+        m_resource.erase( it );
+    }
  
 protected:
     virtual T* load( const std::string& strId )
 	{
+		PROFILE_ZONE_DETAIL("ResourceManager::load", strId);
+
 		T* res = new T;
 
 		LOG(Debug, "Loading resource '" << strId << "'");
@@ -69,7 +129,10 @@ protected:
 	}
  
 public:
-    ResourceManager() {
+    ResourceManager()
+    : m_totalBytes( 0 ), m_peakBytes( 0 ) {
+        std::fill( m_categoryBytes, m_categoryBytes + ResourceUsage::NUM_CATEGORIES, 0 );
+        std::fill( m_categoryCount, m_categoryCount + ResourceUsage::NUM_CATEGORIES, 0 );
     }
  
     virtual ~ResourceManager() {
@@ -81,24 +144,81 @@ public:
         if( resource == NULL ) {
             resource = load( strId );
             // If the resource loaded successfully, add it do the resource map
-            if( resource != NULL )
-                m_resource.insert( Resource( strId, resource ) );
+            if( resource != NULL ) {
+                Entry entry;
+                entry.resource = resource;
+                entry.category = ResourceUsage::getCategory( strId );
+                entry.bytes = getMemoryUsage( *resource );
+                m_resource.insert( Resource( strId, entry ) );
+
+                m_categoryBytes[entry.category] += entry.bytes;
+                m_categoryCount[entry.category]++;
+                m_totalBytes += entry.bytes;
+                m_peakBytes = std::max( m_peakBytes, m_totalBytes );
+            }
         }
         return *resource;
     }
  
     void releaseResource( const std::string& strId ) {
-        T* resource = find( strId );
-        if( resource != NULL ) {
-            delete resource;
-            m_resource.erase( m_resource.find( strId ) );
-        }
+        typename ResourceMap::iterator it = m_resource.find( strId );
+        if( it != m_resource.end() )
+            release( it );
     }
  
     void releaseAllResources() {
-        while( m_resource.begin() != m_resource.end() ) {
-            delete m_resource.begin()->second;
-            m_resource.erase( m_resource.begin() );
+        while( m_resource.begin() != m_resource.end() )
+            release( m_resource.begin() );
+    }
+
+    // Bytes held by the resource, 0 if it is not loaded
+    size_t getResourceBytes( const std::string& strId ) const {
+        typename ResourceMap::const_iterator it = m_resource.find( strId );
+        return it != m_resource.end() ? it->second.bytes : 0;
+    }
+
+    size_t getCategoryBytes( ResourceUsage::Category c ) const {
+        return m_categoryBytes[c];
+    }
+
+    size_t getCategoryCount( ResourceUsage::Category c ) const {
+        return m_categoryCount[c];
+    }
+
+    size_t getTotalBytes() const {
+        return m_totalBytes;
+    }
+
+    // Highest total since the start
+    size_t getPeakBytes() const {
+        return m_peakBytes;
+    }
+
+    size_t getNumResources() const {
+        return m_resource.size();
+    }
+
+    // Write the totals per category and all resources, largest first
+    void writeReport( std::ostream& out ) const {
+        out << "resources: " << m_resource.size() << ", " << m_totalBytes / 1024 << " KiB, peak " << m_peakBytes / 1024 << " KiB\n";
+        for( size_t i=0; i < ResourceUsage::NUM_CATEGORIES; ++i ) {
+            ResourceUsage::Category c = static_cast<ResourceUsage::Category>( i );
+            out << "  " << std::left << std::setw( 12 ) << ResourceUsage::getCategoryName( c ) << std::right
+                << std::setw( 5 ) << m_categoryCount[c] << " resources " << std::setw( 8 ) << m_categoryBytes[c] / 1024 << " KiB\n";
+        }
+
+        typedef const typename ResourceMap::value_type* EntryPtr;
+        std::vector< EntryPtr > sorted;
+        sorted.reserve( m_resource.size() );
+        for( typename ResourceMap::const_iterator it = m_resource.begin(); it != m_resource.end(); ++it )
+            sorted.push_back( &*it );
+        std::sort( sorted.begin(), sorted.end(), []( EntryPtr a, EntryPtr b ) {
+            return a->second.bytes > b->second.bytes;
+        });
+
+        for( size_t i=0; i < sorted.size(); ++i ) {
+            out << "  " << std::setw( 8 ) << sorted[i]->second.bytes / 1024 << " KiB  "
+                << ResourceUsage::getCategoryName( sorted[i]->second.category ) << "  " << sorted[i]->first << "\n";
         }
     }
 };
@@ -0,0 +1,100 @@
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+// Time source of the simulation. It only advances when the simulation is updated,
+// so everything timed with it follows the game speed and stops while paused.
+class SimClock
+{
+public:
+	enum Speed {
+		Normal, Double, Quadruple, AsFastAsPossible, NUM_SPEEDS,
+	};
+
+private:
+	double time;
+
+	Speed speed;
+	bool paused;
+
+public:
+	SimClock()
+	: time(0), speed(Normal), paused(false)
+	{ }
+
+	void Reset()
+	{
+		time = 0;
+		speed = Normal;
+		paused = false;
+	}
+
+	void Advance(float dt)
+	{
+		time += dt;
+	}
+
+	// Simulation time in seconds since the last reset
+	double GetTime() const
+	{
+		return time;
+	}
+
+	void SetSpeed(Speed s)
+	{
+		speed = s;
+	}
+
+	Speed GetSpeed() const
+	{
+		return speed;
+	}
+
+	// Factor between simulation time and real time, 0 when running as fast as possible.
+	float GetScale() const
+	{
+		switch (speed) {
+		case Normal:
+			return 1.f;
+		case Double:
+			return 2.f;
+		case Quadruple:
+			return 4.f;
+		default:
+			return 0.f;
+		}
+	}
+
+	void SetPaused(bool p)
+	{
+		paused = p;
+	}
+
+	bool IsPaused() const
+	{
+		return paused;
+	}
+};
+
+// Replacement for sf::Clock that measures simulation time instead of real time.
+class SimTimer
+{
+	const SimClock* clock;
+	double start;
+
+public:
+	explicit SimTimer(const SimClock& clock)
+	: clock(&clock), start(clock.GetTime())
+	{ }
+
+	void Reset()
+	{
+		start = clock->GetTime();
+	}
+
+	float GetElapsedTime() const
+	{
+		return static_cast<float>(clock->GetTime() - start);
+	}
+};
+
+#endif //SIM_CLOCK_H
@@ -0,0 +1,31 @@
+#ifndef SIM_COMMAND_H
+#define SIM_COMMAND_H
+
+// A gameplay relevant input to the simulation. All player (and debug) actions that
+// change the game state go through these commands, so they can be recorded and replayed.
+struct SimCommand
+{
+	enum Type {
+		AddTower,      // tower: index of the tower settings, pos: tower place
+		UpgradeTower,  // pos: position of the tower
+		SellTower,     // pos: position of the tower
+		SpawnEnemy,    // enemy: enemy type, spawn: spawn place
+		SkipCountdown,
+		Forfeit,       // loose all lives
+		NUM_TYPES,
+	};
+
+	Type type;
+	size_t tick; // simulation tick the command was executed before
+
+	Vector2f pos;
+	size_t tower;
+	size_t enemy;
+	size_t spawn;
+
+	explicit SimCommand(Type t = SkipCountdown)
+	: type(t), tick(0), tower(0), enemy(0), spawn(0)
+	{ }
+};
+
+#endif //SIM_COMMAND_H
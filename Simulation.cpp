@@ -0,0 +1,538 @@
+#include "pch.h"
+#include "Simulation.h"
+#include "Utility.h"
+#include "Tower.h"
+#include "Systems.h"
+#include "DataPaths.h"
+#include "TowerSettings.h"
+#include "ResourceManager.h"
+#include "Theme.h"
+#include "Replay.h"
+#include "Error.h"
+#include "Log.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+
+#include "json_spirit/json_spirit.h"
+#include "jsex.h"
+
+#include <numeric>
+
+namespace fs = boost::filesystem;
+namespace js = json_spirit;
+
+static const float SPAWN_TIME = .5f;
+
+// Projectiles in flight per tower place and attack the pools make room for, a guess
+static const size_t PROJECTILES_PER_ATTACK = 4;
+
+Simulation::Simulation(GlobalStatus& gs)
+: globalStatus(gs), enemyIndex(enemyStore), scheduler(world), towerActivity(map, enemyStore), running(false), skipCountdown(false), tick(0), recorder(nullptr)
+{
+	enemyStore.Init(map, gameStatus.clock, enemySettings);
+	AddSystems();
+}
+
+void Simulation::AddSystems()
+{
+	const ComponentMask enemyMotion = Bit(EnemyMotionId);
+	const ComponentMask enemyHealth = Bit(EnemyHealthId);
+
+	scheduler.Add("Enemy::Update", enemyHealth, enemyMotion, [this](float dt) {
+		ALLOC_TAG("enemies");
+		enemyStore.Update(dt);
+		// If an enemy reached the target area and did not strike yet,
+		// let them strike and loose a life. Poor player )-:
+		for (size_t struck = enemyStore.Strike(); struck > 0; --struck)
+			LooseLife();
+		enemyIndex.Update();
+	});
+
+	scheduler.Add("Projectile::Move", enemyMotion, Bit(TransformId) | Bit(ProjectileId), [this](float dt) {
+		MoveProjectiles(world, enemyStore, homing, dt);
+	});
+	scheduler.Add("Projectile::Hit", Bit(TransformId) | Bit(ProjectileId) | Bit(SplashId) | enemyMotion, enemyHealth, [this](float) {
+		HitTargets(world, enemyStore, enemyIndex);
+	});
+
+	scheduler.Add("Tower::Activity", Bit(TargetingId) | enemyMotion | enemyHealth, Bit(CooldownId), [this](float) {
+		ALLOC_TAG("towers");
+		towerActivity.Update(towers);
+	});
+	scheduler.Add("Tower::Cooldown", 0, Bit(CooldownId), [this](float dt) {
+		UpdateCooldowns(world, dt);
+	});
+	scheduler.Add("Tower::Aura", Bit(TransformId) | Bit(TargetingId) | Bit(CooldownId) | Bit(AuraId) | enemyMotion, enemyHealth, [this](float) {
+		ApplyAuras(world, enemyStore, enemyIndex);
+	});
+	scheduler.Add("Tower::Target", Bit(TransformId) | Bit(CooldownId) | Bit(LauncherId) | enemyMotion | enemyHealth, Bit(TargetingId), [this](float) {
+		ChooseTargets(world, enemyStore, enemyIndex);
+	});
+	scheduler.Add("Tower::Launch", Bit(TargetingId) | Bit(CooldownId) | Bit(LauncherId) | enemyMotion, Bit(TransformId) | Bit(ProjectileId) | Bit(SplashId), [this](float) {
+		LaunchProjectiles(world, enemyStore);
+	});
+}
+
+void Simulation::Reset(const std::string& levelName, unsigned int seed, ProgressCallback progress)
+{
+	PROFILE_ZONE_DETAIL("Simulation::Reset", levelName);
+	ALLOC_TAG("loading");
+
+	if (!progress)
+		progress = [](float) { };
+
+	if (recorder)
+		recorder->Begin(levelName, seed, globalStatus);
+	Randomizer::SetSeed(seed);
+
+	{
+		PROFILE_ZONE("Simulation::Reset/status");
+		enemyStore.Clear();
+		enemiesByY.clear();
+		enemyIndex.Clear();
+		towers.Clear();
+		towerActivity.Clear();
+		world.Clear();
+
+		gameStatus.Reset(globalStatus);
+	}
+	progress(0.2f);
+
+	{
+		PROFILE_ZONE("Simulation::Reset/level");
+		auto levelPath = GetLevelPath(levelName);
+		auto levelFile = GetLevelFile(levelName);
+		level.LoadFromFile(levelPath / levelFile);
+	}
+	progress(0.3f);
+
+	{
+		PROFILE_ZONE("Simulation::Reset/enemies");
+		LoadEnemySettings();
+	}
+	progress(0.4f);
+
+	{
+		PROFILE_ZONE("Simulation::Reset/map");
+		LoadFromFile(map, level.map);
+		map.Reset();
+		map.SetMazeMode(level.mazeMode);
+		enemyIndex.SetArea(static_cast<float>(map.GetWidthBlocks() * map.GetBlockSize()), static_cast<float>(map.GetHeightBlocks() * map.GetBlockSize()));
+	}
+	progress(0.7f);
+
+	{
+		PROFILE_ZONE("Simulation::Reset/theme");
+		gTheme.LoadTheme(level.theme);
+	}
+
+	{
+		PROFILE_ZONE("Simulation::Reset/coverage");
+		std::vector<float> ranges;
+		for (size_t i=0; i < gTheme.GetNumTowerSettings(); ++i) {
+			const TowerSettings* settings = gTheme.GetTowerSettings(i);
+			for (auto st = settings->stage.begin(); st != settings->stage.end(); ++st) {
+				if (boost::range::find(ranges, st->range) == ranges.end())
+					ranges.push_back(st->range);
+			}
+		}
+		map.PrecomputeCoverage(ranges);
+	}
+
+	ReservePools();
+
+	// reset countdown and spawn timer here for the first wave
+	gameStatus.spawnTimer.Reset();
+	gameStatus.countdownTimer.Reset();
+	skipCountdown = false;
+
+	tick = 0;
+	running = true;
+}
+
+void Simulation::Update(float dt)
+{
+	PROFILE_ZONE("Simulation::Update");
+	ALLOC_TAG("simulation");
+
+	gameStatus.clock.Advance(dt);
+
+	// Update the wave state
+	UpdateWave();
+
+	// Go through all enemies, projectiles and towers and update them
+	scheduler.Update(dt);
+
+	// grant money for dead enemies
+	for (size_t i=0; i < enemyStore.GetSize(); ++i) {
+		if (enemyStore.IsDead(i))
+			gameStatus.money += globalStatus.moneyPerEnemy * enemySettings[enemyStore.GetType(i)].moneyFactor;
+	}
+
+	// Remove all the things no longer needed
+	Cleanup();
+
+	{
+		PROFILE_ZONE("Simulation::Sort");
+		enemiesByY.resize(enemyStore.GetSize());
+		std::iota(enemiesByY.begin(), enemiesByY.end(), 0);
+		boost::sort(enemiesByY, [&](uint32_t a, uint32_t b) {
+			return enemyStore.GetPosition(a).y < enemyStore.GetPosition(b).y;
+		});
+	}
+
+	tick++;
+}
+
+void Simulation::Cleanup()
+{
+	PROFILE_ZONE("Simulation::Cleanup");
+
+	enemyStore.RemoveIrrelevant();
+	for (size_t i=0; i < towers.GetSize(); ++i) {
+		const Tower& t = towers.Get(i);
+		if (t.IsSold()) {
+			map.RemoveTower(t.GetPosition());
+			towerActivity.TowersChanged();
+			world.Destroy(t.GetEntity());
+		}
+	}
+	towers.RemoveSold();
+	world.Flush();
+}
+
+void Simulation::UpdateWave()
+{
+	PROFILE_ZONE("Simulation::UpdateWave");
+
+	if (gameStatus.currentWave >= level.waves.size()) {
+		// if we finished the last wave, the game has ended
+		if (enemyStore.GetSize() == 0)
+			running = false;
+
+		// return even if there are still enemies, there is nothing wave related to handle
+		// anymore (and currentWave points to the wave after the end of gameStatus.waves (-; )
+		return;
+	}
+
+	Level::Wave& currentWave = level.waves[gameStatus.currentWave];
+
+	switch (gameStatus.waveState) {
+	case GameStatus::InCountdown:
+		// We are in the InCountdown state. If the countdown has elapsed, begin to spawn
+		// the enemies by proceeding to the InSpawn state;
+		if (skipCountdown || gameStatus.countdownTimer.GetElapsedTime() > currentWave.countdown) {
+			gameStatus.waveState = GameStatus::InSpawn;
+			skipCountdown = false;
+
+			// copy the enemies to spawn to a stack
+			enemiesToSpawn.clear();
+			enemiesToSpawn.resize(currentWave.enemies.size());
+			for (size_t spawnPt = 0; spawnPt < currentWave.enemies.size(); ++spawnPt) {
+				boost::for_each(currentWave.enemies[spawnPt], [&](size_t tp) {
+					enemiesToSpawn[spawnPt].push(tp);
+				});
+			}
+
+			gameStatus.waveTimer.Reset();
+		}
+		break;
+	case GameStatus::InSpawn:
+		// In the spawn state see if the spawn timer has elapsed and then spawn an enemy.
+		// If all enemies for this wave are spawned proceed to the InWave state
+		if (gameStatus.spawnTimer.GetElapsedTime() > SPAWN_TIME) {
+
+			bool spawned = false;
+			for (size_t spawnPt = 0; spawnPt < std::min(enemiesToSpawn.size(), map.GetNumSpawns()); ++spawnPt) {
+				if (enemiesToSpawn[spawnPt].size() > 0) {
+					DoSpawnEnemy(enemiesToSpawn[spawnPt].front(), spawnPt);
+					enemiesToSpawn[spawnPt].pop();
+					gameStatus.spawnTimer.Reset();
+					spawned = true;
+				}
+			}
+
+			// everything is spawned, proceeed to InWave
+			if (!spawned) {
+				gameStatus.waveState = GameStatus::InWave;
+			}
+		}
+		break;
+	case GameStatus::InWave:
+		// In the InWave state wait untill all enemies are killed or the maximal time for the wave has
+		// elapsed, then proceed to the next wave.
+		// Reset both countdownTimer and spawnTimer here, so the first spawn will happen immediatly when
+		// the wave countdown finished (as long as countdown > SPAWN_TIME).
+		if (enemyStore.GetSize() == 0 || (currentWave.maxTime != 0 && gameStatus.waveTimer.GetElapsedTime() > currentWave.maxTime)) {
+			gameStatus.currentWave++;
+			gameStatus.waveState = GameStatus::InCountdown;
+			gameStatus.countdownTimer.Reset();
+			gameStatus.spawnTimer.Reset();
+		}
+		break;
+	}
+}
+
+void Simulation::LooseLife()
+{
+	gameStatus.lives--;
+	if (gameStatus.lives <= 0) {
+		running = false;
+	}
+}
+
+void Simulation::Execute(const SimCommand& command)
+{
+	SimCommand cmd = command;
+	cmd.tick = tick;
+
+	// refused commands change nothing and are not recorded, a replay from an older
+	// map or a bot trying any position goes on without them
+	if (cmd.type == SimCommand::AddTower) {
+		switch (map.CheckTowerPlace(cmd.pos)) {
+		case Map::InvalidPlace:
+			LOG(Msg, "Refused a tower at (" << cmd.pos.x << ", " << cmd.pos.y << "), it is no tower place");
+			return;
+
+		case Map::BlocksSpawn:
+			LOG(Msg, "Refused a tower at (" << cmd.pos.x << ", " << cmd.pos.y << "), it would cut off a spawn");
+			return;
+
+		case Map::FreePlace:
+			break;
+		}
+	}
+
+	if (recorder)
+		recorder->commands.push_back(cmd);
+
+	switch (cmd.type) {
+	case SimCommand::AddTower:
+		DoAddTower(gTheme.GetTowerSettings(cmd.tower), cmd.pos);
+		break;
+
+	case SimCommand::UpgradeTower:
+		{
+			const size_t row = towers.FindAt(cmd.pos);
+			if (row != TowerStore::NO_ROW && towers.Get(row).CanUpgrade()) {
+				towers.Get(row).Upgrade();
+				towerActivity.TowersChanged();
+			}
+		}
+		break;
+
+	case SimCommand::SellTower:
+		{
+			const size_t row = towers.FindAt(cmd.pos);
+			if (row != TowerStore::NO_ROW && !towers.Get(row).IsSold())
+				gameStatus.money += towers.Get(row).Sell();
+		}
+		break;
+
+	case SimCommand::SpawnEnemy:
+		DoSpawnEnemy(cmd.enemy, cmd.spawn);
+		break;
+
+	case SimCommand::SkipCountdown:
+		if (gameStatus.waveState == GameStatus::InCountdown)
+			skipCountdown = true;
+		break;
+
+	case SimCommand::Forfeit:
+		gameStatus.lives = 1;
+		LooseLife();
+		break;
+
+	default:
+		break;
+	}
+}
+
+void Simulation::AddTower(const TowerSettings* settings, Vector2f pos)
+{
+	SimCommand cmd(SimCommand::AddTower);
+	cmd.tower = gTheme.GetTowerSettingsIndex(settings);
+	cmd.pos = pos;
+	Execute(cmd);
+}
+
+void Simulation::UpgradeTower(Vector2f pos)
+{
+	SimCommand cmd(SimCommand::UpgradeTower);
+	cmd.pos = pos;
+	Execute(cmd);
+}
+
+void Simulation::SellTower(Vector2f pos)
+{
+	SimCommand cmd(SimCommand::SellTower);
+	cmd.pos = pos;
+	Execute(cmd);
+}
+
+void Simulation::SpawnEnemy(size_t type, size_t spawn)
+{
+	SimCommand cmd(SimCommand::SpawnEnemy);
+	cmd.enemy = type;
+	cmd.spawn = spawn;
+	Execute(cmd);
+}
+
+void Simulation::Forfeit()
+{
+	Execute(SimCommand(SimCommand::Forfeit));
+}
+
+void Simulation::SkipCountdown()
+{
+	Execute(SimCommand(SimCommand::SkipCountdown));
+}
+
+// FNV-1a
+static void HashBytes(uint64_t& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i=0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+template <typename T>
+static void HashValue(uint64_t& hash, const T& value)
+{
+	HashBytes(hash, &value, sizeof(value));
+}
+
+uint64_t Simulation::GetStateHash() const
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	HashValue(hash, tick);
+	HashValue(hash, gameStatus.lives);
+	HashValue(hash, gameStatus.money);
+	HashValue(hash, gameStatus.currentWave);
+	HashValue(hash, gameStatus.waveState);
+
+	for (size_t i=0; i < enemyStore.GetSize(); ++i) {
+		HashValue(hash, enemyStore.GetPosition(i).x);
+		HashValue(hash, enemyStore.GetPosition(i).y);
+		HashValue(hash, enemyStore.GetLife(i));
+	}
+	for (size_t i=0; i < towers.GetSize(); ++i) {
+		const Tower& t = towers.Get(i);
+		HashValue(hash, t.GetPosition().x);
+		HashValue(hash, t.GetPosition().y);
+		HashValue(hash, t.GetStage());
+	}
+	world.ForEach(Bit(TransformId) | Bit(ProjectileId), [&](const World::Archetype& a) {
+		const std::vector<Transform>& transforms = world.Read<Transform>(a);
+		for (auto t = transforms.begin(); t != transforms.end(); ++t) {
+			HashValue(hash, t->pos.x);
+			HashValue(hash, t->pos.y);
+		}
+	});
+
+	return hash;
+}
+
+void Simulation::LoadEnemySettings()
+{
+	if (level.theme == prevTheme)
+		return; // already loaded
+
+	fs::path themePath = GetThemePath(level.theme);
+	fs::path enemyDef = themePath / EnemyDefinitionFile;
+
+	std::ifstream in(enemyDef.string());
+	js::mValue rootValue;
+	try {
+		PROFILE_ZONE_DETAIL("Simulation::LoadEnemySettings/json", enemyDef.string());
+		js::read_or_throw(in, rootValue);
+	}
+	catch (js::Error_position err) {
+		throw GameError() << ErrorInfo::Desc("Invalid json file") << ErrorInfo::Note(err.reason_) << boost::errinfo_at_line(err.line_) << boost::errinfo_file_name(enemyDef.string());
+	}
+
+	if (rootValue.type() != js::obj_type)
+		throw GameError() << ErrorInfo::Desc("Root value is not an object") << boost::errinfo_file_name(enemyDef.string());
+
+	js::mObject rootObj = rootValue.get_obj();
+
+	js::mArray& enemies = rootObj["enemies"].get_array();
+	enemySettings.clear();
+	enemySettings.resize(enemies.size());
+	for (size_t i=0; i < enemies.size(); ++i) {
+		js::mObject& def = enemies[i].get_obj();
+
+		enemySettings[i].image     = &gImageManager.getResource((themePath / def["image"].get_str()).string());
+		enemySettings[i].width     = def["width"].get_int();
+		enemySettings[i].height    = def["height"].get_int();
+		enemySettings[i].offset    = def["offset"].get_int();
+		enemySettings[i].numFrames = def["frames"].get_int();
+		enemySettings[i].frameTime = jsex::get<float>(def["frame-time"]);
+
+		enemySettings[i].life  = def["life"].get_int();
+		enemySettings[i].speed = jsex::get<float>(def["speed"]);
+		enemySettings[i].moneyFactor = def["money-factor"].get_int();
+	}
+}
+
+void Simulation::DoSpawnEnemy(size_t type, size_t spawn)
+{
+	PROFILE_ZONE("Simulation::SpawnEnemy");
+	ALLOC_TAG("spawning");
+
+	Handle e = enemyStore.Spawn(type, map.GetSpawnPosition(spawn), map.GetDefaultTarget());
+	enemyIndex.Add(e);
+	towerActivity.AddEnemy(e);
+}
+
+void Simulation::DoAddTower(const TowerSettings* settings, Vector2f pos)
+{
+	gameStatus.money -= settings->baseCost;
+
+	Tower tower(settings, world, map.IsHighRange(pos));
+	tower.SetPosition(pos);
+	towers.Add(tower);
+	map.PlaceTower(pos);
+	towerActivity.TowersChanged();
+}
+
+void Simulation::ReservePools()
+{
+	PROFILE_ZONE("Simulation::ReservePools");
+
+	// all enemies of the level could be around at the same time
+	size_t numEnemies = 0;
+	for (auto wave = level.waves.begin(); wave != level.waves.end(); ++wave) {
+		for (auto spawn = wave->enemies.begin(); spawn != wave->enemies.end(); ++spawn)
+			numEnemies += spawn->size();
+	}
+	enemyStore.Reserve(numEnemies);
+	enemyIndex.Reserve(numEnemies);
+	towerActivity.Reserve(numEnemies);
+	enemiesByY.reserve(numEnemies);
+
+	// every tower type on every place, with its projectiles in flight
+	const size_t numPlaces = map.GetTowerPlaces().size();
+	towers.Reserve(numPlaces);
+	size_t numProjectiles = 0;
+	for (size_t i=0; i < gTheme.GetNumTowerSettings(); ++i) {
+		const TowerSettings* settings = gTheme.GetTowerSettings(i);
+		world.Reserve(Bit(TransformId) | Bit(TargetingId) | Bit(CooldownId) | settings->components, numPlaces);
+
+		if (settings->components & Bit(LauncherId)) {
+			int attacks = 0;
+			for (auto st = settings->stage.begin(); st != settings->stage.end(); ++st)
+				attacks = std::max(attacks, st->attacks);
+			const size_t n = numPlaces * attacks * PROJECTILES_PER_ATTACK;
+			world.Reserve(Bit(TransformId) | Bit(ProjectileId) | (settings->components & Bit(SplashId)), n);
+			numProjectiles = std::max(numProjectiles, n);
+		}
+	}
+
+	// the homing batch holds one archetype at a time
+	ALLOC_TAG("projectiles");
+	homing.Reserve(numProjectiles);
+}
@@ -0,0 +1,180 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "GameStatus.h"
+#include "GlobalStatus.h"
+#include "EnemyStore.h"
+#include "EnemyIndex.h"
+#include "Map.h"
+#include "TowerStore.h"
+#include "TowerActivity.h"
+#include "World.h"
+#include "SystemScheduler.h"
+#include "Kernels.h"
+#include "EnemySettings.h"
+#include "Level.h"
+#include "SimCommand.h"
+
+#include <functional>
+#include <cstdint>
+
+struct TowerSettings;
+struct Replay;
+
+// Length of one simulation step in seconds. The simulation is always advanced
+// in steps of this size, regardless of the frame rate.
+static const float SIM_TICK = 0.01f;
+
+// The game logic without any rendering or input handling. The simulation owns
+// all game objects and advances them in explicit time steps, so it can be run
+// without a window (e.g. on a build server).
+class Simulation
+{
+	GlobalStatus& globalStatus;
+
+	std::string prevTheme;
+	std::vector<EnemySettings> enemySettings;
+	EnemyStore enemyStore;
+	std::vector<uint32_t> enemiesByY;  // rows of enemyStore, sorted by y for drawing
+	EnemyIndex enemyIndex;  // the enemies ordered by progress, for the targeting of the towers
+	TowerStore towers;
+
+	World world;  // the towers and projectiles as entities
+	SystemScheduler scheduler;
+	HomingBatch homing;  // used while moving the projectiles
+
+	Map map;
+	GameStatus gameStatus;
+
+	TowerActivity towerActivity;  // lets the towers without enemies in range sleep
+
+	Level level;
+	std::vector<std::queue<size_t>> enemiesToSpawn;
+
+	bool running;
+	bool skipCountdown;
+
+	size_t tick;
+	Replay* recorder;
+
+public:
+	typedef std::function<void (float)> ProgressCallback;
+
+	explicit Simulation(GlobalStatus& gs);
+
+	// Load the given level and reset all game objects. The random seed is used for
+	// sf::Randomizer. The progress callback gets called with the loading progress in [0, 1].
+	void Reset(const std::string& levelName, unsigned int seed, ProgressCallback progress = ProgressCallback());
+
+	// Advance the simulation by dt seconds.
+	void Update(float dt);
+
+	bool IsRunning() const
+	{
+		return running;
+	}
+
+	// Number of updates since the last reset
+	size_t GetTick() const
+	{
+		return tick;
+	}
+
+	// Record the level, seed and all executed commands to the given replay (may be nullptr)
+	void SetRecorder(Replay* replay)
+	{
+		recorder = replay;
+	}
+
+	// Execute a command before the next tick. All changes from outside of the
+	// simulation should go through here (or the helpers below), so they get recorded.
+	// Towers on an invalid place or cutting off a spawn are refused and not recorded.
+	void Execute(const SimCommand& cmd);
+
+	void AddTower(const TowerSettings* settings, Vector2f pos);
+	void UpgradeTower(Vector2f pos);
+	void SellTower(Vector2f pos);
+	void SpawnEnemy(size_t type, size_t spawn);
+	void Forfeit();
+
+	// Start the next wave right away instead of waiting for the countdown
+	void SkipCountdown();
+
+	// Hash over the complete game state, to check if two runs are identical
+	uint64_t GetStateHash() const;
+
+	GameStatus& GetStatus()
+	{
+		return gameStatus;
+	}
+
+	const GameStatus& GetStatus() const
+	{
+		return gameStatus;
+	}
+
+	Map& GetMap()
+	{
+		return map;
+	}
+
+	const Map& GetMap() const
+	{
+		return map;
+	}
+
+	size_t GetNumEnemyTypes() const
+	{
+		return enemySettings.size();
+	}
+
+	const Level& GetLevel() const
+	{
+		return level;
+	}
+
+	const EnemyStore& GetEnemies() const
+	{
+		return enemyStore;
+	}
+
+	size_t GetNumEnemies() const
+	{
+		return enemyStore.GetSize();
+	}
+
+	// Rows of the enemies, the lower ones on the screen last
+	const std::vector<uint32_t>& GetEnemiesByY() const
+	{
+		return enemiesByY;
+	}
+
+	const TowerStore& GetTowers() const
+	{
+		return towers;
+	}
+
+	const World& GetWorld() const
+	{
+		return world;
+	}
+
+	size_t GetNumProjectiles() const
+	{
+		return world.Count(Bit(ProjectileId));
+	}
+
+private:
+	void UpdateWave();
+	void Cleanup();
+	void LooseLife();
+
+	void DoAddTower(const TowerSettings* settings, Vector2f pos);
+	void DoSpawnEnemy(size_t type, size_t spawn);
+
+	void LoadEnemySettings();
+	void AddSystems();
+	void ReservePools();
+};
+
+#endif //SIMULATION_H
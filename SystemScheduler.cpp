@@ -0,0 +1,29 @@
+#include "pch.h"
+#include "SystemScheduler.h"
+#include "World.h"
+#include "Profiler.h"
+
+SystemScheduler::SystemScheduler(World& world)
+: world(world)
+{ }
+
+void SystemScheduler::Add(const char* name, ComponentMask reads, ComponentMask writes, Run run)
+{
+	System s;
+	s.zone = Profiler::Instance().GetZoneId(name);
+	s.reads = reads;
+	s.writes = writes;
+	s.run = run;
+
+	systems.push_back(s);
+}
+
+void SystemScheduler::Update(float elapsed)
+{
+	for (auto it = systems.begin(); it != systems.end(); ++it) {
+		ProfileScope scope(it->zone);
+		world.BeginSystem(it->reads, it->writes);
+		it->run(elapsed);
+		world.EndSystem();
+	}
+}
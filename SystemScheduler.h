@@ -0,0 +1,39 @@
+#ifndef SYSTEM_SCHEDULER_H
+#define SYSTEM_SCHEDULER_H
+
+#include "Components.h"
+
+#include <functional>
+
+class World;
+
+// Runs the systems of the simulation in the order they were added, each one as a zone of
+// the profiler. Every system declares the components it reads and writes, the World
+// holds it to that in debug builds.
+class SystemScheduler
+{
+public:
+	typedef std::function<void (float)> Run;
+
+private:
+	struct System
+	{
+		size_t zone;  // in the profiler
+		ComponentMask reads, writes;
+		Run run;
+	};
+
+	World& world;
+	std::vector<System> systems;
+
+public:
+	explicit SystemScheduler(World& world);
+
+	// Add a system, name is a string literal as for PROFILE_ZONE
+	void Add(const char* name, ComponentMask reads, ComponentMask writes, Run run);
+
+	// Run all systems once
+	void Update(float elapsed);
+};
+
+#endif //SYSTEM_SCHEDULER_H
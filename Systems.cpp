@@ -0,0 +1,187 @@
+#include "pch.h"
+#include "Systems.h"
+#include "World.h"
+#include "EnemyStore.h"
+#include "EnemyIndex.h"
+#include "Kernels.h"
+#include "Utility.h"
+#include "AllocTracker.h"
+
+void UpdateCooldowns(World& world, float elapsed)
+{
+	world.ForEach(Bit(CooldownId), [&](World::Archetype& a) {
+		std::vector<Cooldown>& cooldowns = world.Write<Cooldown>(a);
+		for (auto c = cooldowns.begin(); c != cooldowns.end(); ++c) {
+			c->ready = false;
+			if (c->timer > 0)
+				c->timer -= elapsed;
+			if (c->timer <= 0) {
+				// a sleeping tower has no enemy in range, it only starts over
+				c->ready = !c->asleep;
+				c->timer = c->cooldown;
+			}
+		}
+	});
+}
+
+void ApplyAuras(World& world, EnemyStore& enemies, const EnemyIndex& index)
+{
+	world.ForEach(Bit(TransformId) | Bit(TargetingId) | Bit(CooldownId) | Bit(AuraId), [&](World::Archetype& a) {
+		const std::vector<Transform>& transforms = world.Read<Transform>(a);
+		const std::vector<Targeting>& targeting = world.Read<Targeting>(a);
+		const std::vector<Cooldown>& cooldowns = world.Read<Cooldown>(a);
+		const std::vector<Aura>& auras = world.Read<Aura>(a);
+		for (size_t i=0; i < a.GetSize(); ++i) {
+			if (!cooldowns[i].ready)
+				continue;
+			const float power = auras[i].power;
+			index.ForEachInRange(transforms[i].pos, targeting[i].range, [&](size_t e) {
+				enemies.Hit(e, power);
+			});
+		}
+	});
+}
+
+static void ChooseTarget(const Vector2f& pos, Targeting& t, const EnemyStore& enemies, const EnemyIndex& index)
+{
+	// the closest enemy stays the target as long as it is in range, the others are
+	// chosen anew for each attack, another enemy may have overtaken the last one
+	if (t.mode == TowerSettings::Closest) {
+		const size_t row = enemies.Find(t.current);
+		if (row != EnemyStore::NO_ROW && !enemies.IsIrrelevant(row) && distSq(enemies.GetPosition(row), pos) <= t.range * t.range)
+			return;
+	}
+
+	switch (t.mode) {
+	case TowerSettings::First:
+		t.current = index.FindFirst(pos, t.range);
+		break;
+	case TowerSettings::Last:
+		t.current = index.FindLast(pos, t.range);
+		break;
+	case TowerSettings::Strongest:
+		t.current = index.FindStrongest(pos, t.range);
+		break;
+	case TowerSettings::Closest:
+		t.current = index.FindClosest(pos, t.range);
+		break;
+	}
+}
+
+void ChooseTargets(World& world, const EnemyStore& enemies, const EnemyIndex& index)
+{
+	ALLOC_TAG("targeting");
+
+	world.ForEach(Bit(TransformId) | Bit(TargetingId) | Bit(CooldownId) | Bit(LauncherId), [&](World::Archetype& a) {
+		const std::vector<Transform>& transforms = world.Read<Transform>(a);
+		const std::vector<Cooldown>& cooldowns = world.Read<Cooldown>(a);
+		std::vector<Targeting>& targeting = world.Write<Targeting>(a);
+		for (size_t i=0; i < a.GetSize(); ++i) {
+			if (cooldowns[i].ready)
+				ChooseTarget(transforms[i].pos, targeting[i], enemies, index);
+		}
+	});
+}
+
+void LaunchProjectiles(World& world, const EnemyStore& enemies)
+{
+	ALLOC_TAG("projectiles");
+
+	world.ForEach(Bit(TargetingId) | Bit(CooldownId) | Bit(LauncherId), [&](World::Archetype& a) {
+		const std::vector<Targeting>& targeting = world.Read<Targeting>(a);
+		const std::vector<Cooldown>& cooldowns = world.Read<Cooldown>(a);
+		const std::vector<Launcher>& launchers = world.Read<Launcher>(a);
+		const bool splash = a.Has(SplashId);
+		const ComponentMask mask = Bit(TransformId) | Bit(ProjectileId) | (splash ? Bit(SplashId) : 0);
+
+		for (size_t i=0; i < a.GetSize(); ++i) {
+			if (!cooldowns[i].ready)
+				continue;
+			const size_t target = enemies.Find(targeting[i].current);
+			if (target == EnemyStore::NO_ROW)
+				continue;
+
+			const TowerSettings::Stage& st = *launchers[i].stage;
+			Vector2f offs; // per default use last valid offset
+			for (int k=0; k < st.attacks; ++k) {
+				if (k < static_cast<int>(st.attackPosition.size()))
+					offs = st.attackPosition[k];
+
+				Entity e = world.Create(mask);
+				world.Write<Transform>(e).pos = launchers[i].origin + offs;
+				Projectile& p = world.Write<Projectile>(e);
+				p.target = targeting[i].current;
+				p.targetPosition = enemies.GetPosition(target);
+				p.speed = st.speed;
+				p.power = st.power;
+				p.image = st.projectile;
+				if (splash)
+					world.Write<Splash>(e) = world.Read<Splash>(a)[i];
+			}
+		}
+	});
+}
+
+void MoveProjectiles(World& world, const EnemyStore& enemies, HomingBatch& batch, float elapsed)
+{
+	ALLOC_TAG("projectiles");
+
+	world.ForEach(Bit(TransformId) | Bit(ProjectileId), [&](World::Archetype& a) {
+		std::vector<Transform>& transforms = world.Write<Transform>(a);
+		std::vector<Projectile>& projectiles = world.Write<Projectile>(a);
+		const size_t n = a.GetSize();
+
+		batch.Resize(n);
+		for (size_t i=0; i < n; ++i) {
+			Projectile& p = projectiles[i];
+			if (!p.hit) {
+				const size_t tgt = enemies.Find(p.target);
+				if (tgt != EnemyStore::NO_ROW)
+					p.targetPosition = enemies.GetPosition(tgt);
+			}
+
+			batch.x[i] = transforms[i].pos.x;
+			batch.y[i] = transforms[i].pos.y;
+			batch.targetX[i] = p.targetPosition.x;
+			batch.targetY[i] = p.targetPosition.y;
+			batch.speed[i] = p.speed;
+			batch.rotation[i] = transforms[i].rotation;
+			batch.hit[i] = p.hit;
+		}
+
+		HomeProjectiles(batch, elapsed);
+
+		for (size_t i=0; i < n; ++i) {
+			transforms[i].pos = Vector2f(batch.x[i], batch.y[i]);
+			transforms[i].rotation = batch.rotation[i];
+			projectiles[i].hit = batch.hit[i] != 0;
+		}
+	});
+}
+
+void HitTargets(World& world, EnemyStore& enemies, const EnemyIndex& index)
+{
+	world.ForEach(Bit(TransformId) | Bit(ProjectileId), [&](World::Archetype& a) {
+		const std::vector<Transform>& transforms = world.Read<Transform>(a);
+		const std::vector<Projectile>& projectiles = world.Read<Projectile>(a);
+		const std::vector<Splash>* splash = a.Has(SplashId) ? &world.Read<Splash>(a) : nullptr;
+		for (size_t i=0; i < a.GetSize(); ++i) {
+			const Projectile& p = projectiles[i];
+			if (!p.hit)
+				continue;
+
+			const size_t tgt = enemies.Find(p.target);
+			if (tgt != EnemyStore::NO_ROW)
+				enemies.Hit(tgt, p.power);
+
+			if (splash) {
+				const float power = (*splash)[i].power;
+				index.ForEachInRange(transforms[i].pos, (*splash)[i].range, [&](size_t e) {
+					if (e != tgt)
+						enemies.Hit(e, power);
+				});
+			}
+			world.Destroy(a.GetEntity(i));
+		}
+	});
+}
@@ -0,0 +1,32 @@
+#ifndef SYSTEMS_H
+#define SYSTEMS_H
+
+class World;
+class EnemyStore;
+class EnemyIndex;
+struct HomingBatch;
+
+// The systems for the towers and projectiles, each one goes through the archetypes with
+// its components in a batch. The Simulation adds them to its SystemScheduler.
+
+// Count down the cooldown of all towers. Awake towers whose timer runs out become ready
+// to attack in this update. Sleeping ones count down as well but never become ready, so
+// they attack on the same ticks once they wake up.
+void UpdateCooldowns(World& world, float elapsed);
+
+// Attacking towers with an aura hit every enemy in range
+void ApplyAuras(World& world, EnemyStore& enemies, const EnemyIndex& index);
+
+// Attacking launchers pick an enemy in range according to their targeting mode
+void ChooseTargets(World& world, const EnemyStore& enemies, const EnemyIndex& index);
+
+// Attacking launchers shoot at their target, the projectiles take the splash along
+void LaunchProjectiles(World& world, const EnemyStore& enemies);
+
+// Move the projectiles towards their targets, the batch holds them for the kernel
+void MoveProjectiles(World& world, const EnemyStore& enemies, HomingBatch& batch, float elapsed);
+
+// Projectiles at their target hit it and the enemies around it, then they are destroyed
+void HitTargets(World& world, EnemyStore& enemies, const EnemyIndex& index);
+
+#endif //SYSTEMS_H
@@ -5,6 +5,8 @@
 #include "DataPaths.h"
 #include "ResourceManager.h"
 #include "Log.h"
+#include "Profiler.h"
+#include "Components.h"
 
 namespace fs = boost::filesystem;
 namespace js = json_spirit;
@@ -28,6 +30,7 @@ void Theme::LoadTheme(const std::string& name)
 
 	js::mValue rootValue;
 	try {
+		PROFILE_ZONE_DETAIL("Theme::LoadTheme/json", themeDef.string());
 		js::read_or_throw(in, rootValue);
 	}
 	catch (js::Error_position err) {
@@ -68,6 +71,45 @@ void GetOptFloat(T& var, js::mObject& obj, const std::string& name)
 		var = static_cast<float>(obj[name].get_real());
 }
 
+static TowerSettings::Targeting GetTargeting(const std::string& name)
+{
+	if (name == "first")
+		return TowerSettings::First;
+	else if (name == "last")
+		return TowerSettings::Last;
+	else if (name == "strongest")
+		return TowerSettings::Strongest;
+	else if (name == "closest")
+		return TowerSettings::Closest;
+	else
+		throw std::runtime_error("Unknown targeting mode '" + name + "'");
+}
+
+static ComponentMask GetComponent(const std::string& name)
+{
+	if (name == "launcher")
+		return Bit(LauncherId);
+	else if (name == "splash")
+		return Bit(SplashId);
+	else if (name == "aura")
+		return Bit(AuraId);
+	else
+		throw std::runtime_error("Unknown tower component '" + name + "'");
+}
+
+// The behavior of the tower types without a list of components
+static ComponentMask GetDefaultComponents(const std::string& type)
+{
+	if (type == "archer")
+		return Bit(LauncherId);
+	else if (type == "canon")
+		return Bit(LauncherId) | Bit(SplashId);
+	else if (type == "tea")
+		return Bit(AuraId);
+	else
+		throw std::runtime_error("Unknown tower type '" + type + "'");
+}
+
 void Theme::LoadTowerSettings()
 {
 	fs::path themePath = GetThemePath(currentTheme);
@@ -81,6 +123,7 @@ void Theme::LoadTowerSettings()
 
 	js::mValue rootValue;
 	try {
+		PROFILE_ZONE_DETAIL("Theme::LoadTowerSettings/json", towerDef.string());
 		js::read_or_throw(in, rootValue);
 	}
 	catch (js::Error_position err) {
@@ -104,6 +147,16 @@ void Theme::LoadTowerSettings()
 			settings->name = def["name"].get_str();
 			settings->type = def["type"].get_str();
 			settings->baseCost = def["base-cost"].get_int();
+			if (def.count("targeting"))
+				settings->targeting = GetTargeting(def["targeting"].get_str());
+			if (def.count("components")) {
+				js::mArray& components = def["components"].get_array();
+				settings->components = 0;
+				for (size_t k=0; k < components.size(); ++k)
+					settings->components |= GetComponent(components[k].get_str());
+			}
+			else
+				settings->components = GetDefaultComponents(settings->type);
 
 			js::mArray& stages = def["stages"].get_array();
 			settings->stage.resize(stages.size());
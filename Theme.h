@@ -58,6 +58,17 @@ public:
 		return &towerSettings.at(i);
 	}
 
+	size_t GetNumTowerSettings() const
+	{
+		return towerSettings.size();
+	}
+
+	size_t GetTowerSettingsIndex(const TowerSettings* settings) const
+	{
+		assert(settings >= &towerSettings.front() && settings <= &towerSettings.back());
+		return settings - &towerSettings.front();
+	}
+
 	bool KeyExists(const std::string& path, int idx = -1) const
 	{
 		return std::get<0>(TraversePath(path, idx));
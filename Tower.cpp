@@ -1,75 +1,78 @@
 #include "pch.h"
 #include "Tower.h"
-#include "Utility.h"
-
-#include "ArrowTower.h"
-#include "CanonTower.h"
-#include "TeaTower.h"
 
 static Color RangeCircleColor(255, 201, 0, 64);
 static Color RangeCircleOutline(255, 201, 0, 128);
 
-/*static*/ std::unique_ptr<Tower> Tower::CreateTower(const TowerSettings* settings, const std::vector<std::shared_ptr<Enemy>>& enemies, std::vector<std::unique_ptr<Projectile>>& projectiles, bool highRange)
+Tower::Tower(const TowerSettings* settings, World& world, bool highRange)
+: world(&world), hasHighRange(highRange), settings(settings), stage(0), isSold(false)
 {
-	const std::string& type = settings->type;
-
-	if (type == "archer")
-		return std::unique_ptr<Tower>(new ArrowTower(settings, enemies, projectiles, highRange));
-	else if (type == "canon")
-		return std::unique_ptr<Tower>(new CanonTower(settings, enemies, projectiles, highRange));
-	else if (type == "tea")
-		return std::unique_ptr<Tower>(new TeaTower(settings, enemies, projectiles, highRange));
-	else
-		throw GameError() << ErrorInfo::Note("Unknown tower type '" + type + "'");
+	entity = world.Create(Bit(TransformId) | Bit(TargetingId) | Bit(CooldownId) | settings->components);
+	world.Write<Targeting>(entity).mode = settings->targeting;
+	ApplyStage();
 }
 
-Tower::Tower(const TowerSettings* settings, const std::vector<std::shared_ptr<Enemy>>& enemies, std::vector<std::unique_ptr<Projectile>>& projectiles, bool highRange)
-: settings(settings), enemies(enemies), projectiles(projectiles), hasHighRange(highRange), stage(0), isSold(false)
+void Tower::Upgrade()
 {
+	stage++;
 	ApplyStage();
 }
 
-void Tower::Update(float elapsed)
+void Tower::Sleep()
 {
-	if (cooldownTimer > 0)
-		cooldownTimer -= elapsed;
-
-	if (cooldownTimer <= 0) {
-		Attack();
-		cooldownTimer = cooldown;
-	}
+	world->Write<Cooldown>(entity).asleep = true;
+}
 
-	AnimSprite::Update(elapsed);
+void Tower::Wake()
+{
+	world->Write<Cooldown>(entity).asleep = false;
 }
 
-void Tower::Upgrade()
+void Tower::SetPosition(Vector2f pos)
 {
-	stage++;
-	ApplyStage();
-	if (cooldownTimer > cooldown)
-		cooldownTimer = cooldown;
+	AnimSprite::SetPosition(pos);
+	rangeCircle.SetPosition(pos);
+
+	world->Write<Transform>(entity).pos = pos;
+	if (world->GetMask(entity) & Bit(LauncherId))
+		world->Write<Launcher>(entity).origin = pos - GetCenter();
 }
 
 void Tower::ApplyStage()
 {
 	assert(stage < settings->stage.size());
+	const TowerSettings::Stage& st = settings->stage[stage];
 
-	cooldown = settings->stage[stage].cooldown;
-	range    = settings->stage[stage].range;
-	attacks  = settings->stage[stage].attacks;
-	power    = settings->stage[stage].power;
-
+	float range = st.range;
 	if (hasHighRange)
 		range *= HIGH_RANGE_FACTOR;
 
-	Image* img = settings->stage[stage].image;
+	Image* img = st.image;
 	SetImage(*img);
 	SetSize(img->GetWidth(), img->GetHeight());
 	SetSubRect(IntRect(0, 0, GetWidth(), GetHeight())); // reset the subrect incase the image size has changed
-	SetCenter(settings->stage[stage].center);
+	SetCenter(st.center);
 
 	rangeCircle = Shape::Circle(GetPosition(), range, RangeCircleColor, 2.5f, RangeCircleOutline);
-}
 
-void Tower::Attack()
-{ }
+	world->Write<Targeting>(entity).range = range;
+
+	Cooldown& cooldown = world->Write<Cooldown>(entity);
+	cooldown.cooldown = st.cooldown;
+	if (cooldown.timer > cooldown.cooldown)
+		cooldown.timer = cooldown.cooldown;
+
+	const ComponentMask mask = world->GetMask(entity);
+	if (mask & Bit(LauncherId)) {
+		Launcher& launcher = world->Write<Launcher>(entity);
+		launcher.stage = &st;
+		launcher.origin = GetPosition() - GetCenter();
+	}
+	if (mask & Bit(SplashId)) {
+		Splash& splash = world->Write<Splash>(entity);
+		splash.range = st.splashRange;
+		splash.power = st.splashPower;
+	}
+	if (mask & Bit(AuraId))
+		world->Write<Aura>(entity).power = st.power;
+}
@@ -2,39 +2,36 @@
 #define TOWER_H
 
 #include "AnimSprite.h"
-#include "Enemy.h"
-#include "Map.h"
-#include "Projectile.h"
+#include "World.h"
 #include "TowerSettings.h"
+#include "RenderStats.h"
 
+// A tower as the player sees it. What it does in the simulation is up to the components
+// of its entity, the tower settings choose them. Towers are copied around by the
+// TowerStore, the copies share the entity.
 class Tower : public AnimSprite
 {
-protected:
-	const std::vector<std::shared_ptr<Enemy>>& enemies;
-	std::vector<std::unique_ptr<Projectile>>& projectiles;
+	World* world;
+	Entity entity;
 
 	bool hasHighRange;
 
 	Shape rangeCircle;
 
-	float  range;
-	float  cooldown;
-	size_t attacks;
-	float  power;
-	
-	float cooldownTimer;
-
 	const TowerSettings* settings;
 	size_t stage;
 
 	bool isSold;
 
 public:
-	static std::unique_ptr<Tower> CreateTower(const TowerSettings* settings, const std::vector<std::shared_ptr<Enemy>>& enemies, std::vector<std::unique_ptr<Projectile>>& projectiles, bool highRange);
+	Tower(const TowerSettings* settings, World& world, bool highRange);
 
-	void Update(float elapsed) /* override */;
+	Entity GetEntity() const
+	{
+		return entity;
+	}
 
-	bool CanUpgrade()
+	bool CanUpgrade() const
 	{
 		return stage < (settings->stage.size() - 1);
 	}
@@ -47,38 +44,50 @@ public:
 		return settings->baseCost;
 	}
 
-	bool IsSold()
+	bool IsSold() const
 	{
 		return isSold;
 	}
 
-	void DrawRangeCircle(RenderWindow& tgt)
+	// A sleeping tower has no enemy in range and does not attack. The cooldown goes on
+	// while it sleeps, so it keeps the ticks it attacks on.
+	void Sleep();
+	void Wake();
+
+	bool IsAsleep() const
 	{
-		tgt.Draw(rangeCircle);
+		return world->Read<Cooldown>(entity).asleep;
 	}
 
-	void SetPosition(float x, float y)
+	float GetRange() const
+	{
+		return world->Read<Targeting>(entity).range;
+	}
+
+	void DrawRangeCircle(RenderWindow& tgt) const
 	{
-		AnimSprite::SetPosition(x, y);
-		rangeCircle.SetPosition(x, y);
+		RenderStats::Draw(tgt, rangeCircle);
 	}
 
-	void SetPosition(Vector2f pos)
+	void SetPosition(float x, float y)
 	{
-		AnimSprite::SetPosition(pos);
-		rangeCircle.SetPosition(pos);
+		SetPosition(Vector2f(x, y));
 	}
 
+	void SetPosition(Vector2f pos);
+
 	const TowerSettings* GetSettings() const
 	{
 		return settings;
 	}
 
-protected:
-	Tower(const TowerSettings* settings, const std::vector<std::shared_ptr<Enemy>>& enemies, std::vector<std::unique_ptr<Projectile>>& projectiles, bool highRange);
+	size_t GetStage() const
+	{
+		return stage;
+	}
 
-	virtual void ApplyStage();
-	virtual void Attack();
+private:
+	void ApplyStage();
 };
 
 #endif //TOWER_H
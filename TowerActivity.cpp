@@ -0,0 +1,162 @@
+#include "pch.h"
+#include "TowerActivity.h"
+#include "Map.h"
+#include "EnemyStore.h"
+#include "TowerStore.h"
+#include "WalkPath.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+
+static const size_t NO_PATH = static_cast<size_t>(-1);
+
+// The stretches are widened a bit, so the towers are awake whenever their own range
+// check could hit an enemy, rounding differences included
+static const float COVERAGE_MARGIN = 1.0f;
+
+TowerActivity::TowerActivity(const Map& map, const EnemyStore& store)
+: map(map), store(store), untracked(0), towersChanged(true), pathVersion(0)
+{ }
+
+void TowerActivity::Clear()
+{
+	paths.clear();
+	enemies.clear();
+	inRange.clear();
+	untracked = 0;
+	towersChanged = true;
+}
+
+void TowerActivity::Reserve(size_t n)
+{
+	ALLOC_TAG("towers");
+	enemies.reserve(n);
+}
+
+void TowerActivity::AddEnemy(Handle enemy)
+{
+	Tracked t;
+	t.enemy = enemy;
+	t.path = NO_PATH;
+	t.next = 0;
+	Track(t, store.Find(enemy));
+	enemies.push_back(t);
+}
+
+void TowerActivity::Update(TowerStore& towers)
+{
+	PROFILE_ZONE("TowerActivity::Update");
+	ALLOC_TAG("towers");
+
+	if (towersChanged || pathVersion != map.GetPathVersion())
+		Rebuild(towers);
+
+	auto end = enemies.begin();
+	for (auto it = enemies.begin(); it != enemies.end(); ++it) {
+		const size_t row = store.Find(it->enemy);
+		if (row == EnemyStore::NO_ROW || store.IsIrrelevant(row)) {
+			Untrack(*it);
+			continue;
+		}
+
+		if (it->path != NO_PATH && store.GetPath(row) != paths[it->path].path) {
+			Untrack(*it);
+			Track(*it, row);
+		}
+		else if (it->path != NO_PATH) {
+			Advance(*it, row);
+		}
+		if (end != it)
+			*end = std::move(*it);
+		++end;
+	}
+	enemies.erase(end, enemies.end());
+
+	for (size_t i=0; i < towers.GetSize(); ++i) {
+		Tower& tower = towers.Get(i);
+		bool awake = untracked > 0 || inRange[i] > 0;
+		if (awake && tower.IsAsleep())
+			tower.Wake();
+		else if (!awake && !tower.IsAsleep())
+			tower.Sleep();
+	}
+}
+
+void TowerActivity::Rebuild(const TowerStore& towers)
+{
+	PROFILE_ZONE("TowerActivity::Rebuild");
+
+	towersChanged = false;
+	pathVersion = map.GetPathVersion();
+
+	paths.resize(map.GetNumSpawns());
+	for (size_t i=0; i < paths.size(); ++i) {
+		paths[i].path = map.GetSpawnPath(i);
+		paths[i].borders.clear();
+	}
+
+	for (size_t i=0; i < towers.GetSize(); ++i) {
+		const Map::Coverage& cov = map.GetCoverage(towers.Get(i).GetPosition(), towers.Get(i).GetRange());
+		for (size_t p=0; p < paths.size(); ++p) {
+			for (auto iv = cov.spawns[p].begin(); iv != cov.spawns[p].end(); ++iv) {
+				Border enter = { iv->begin - COVERAGE_MARGIN, i, +1 };
+				Border leave = { iv->end + COVERAGE_MARGIN, i, -1 };
+				paths[p].borders.push_back(enter);
+				paths[p].borders.push_back(leave);
+			}
+		}
+	}
+	for (size_t i=0; i < paths.size(); ++i) {
+		boost::sort(paths[i].borders, [](const Border& a, const Border& b) {
+			return a.distance < b.distance;
+		});
+	}
+
+	// pass all borders again from the start of the paths
+	inRange.assign(towers.GetSize(), 0);
+	untracked = 0;
+	for (auto it = enemies.begin(); it != enemies.end(); ++it) {
+		it->path = NO_PATH;
+		Track(*it, store.Find(it->enemy));
+	}
+}
+
+void TowerActivity::Track(Tracked& t, size_t row)
+{
+	t.path = NO_PATH;
+	t.next = 0;
+	// a removed enemy counts as untracked until the next update drops it
+	if (row != EnemyStore::NO_ROW) {
+		const std::shared_ptr<const WalkPath>& path = store.GetPath(row);
+		for (size_t i=0; i < paths.size(); ++i) {
+			if (path == paths[i].path && path->GetNumSegments() > 0)
+				t.path = i;
+		}
+	}
+
+	if (t.path == NO_PATH)
+		untracked++;
+	else
+		Advance(t, row);
+}
+
+void TowerActivity::Untrack(Tracked& t)
+{
+	if (t.path == NO_PATH) {
+		assert(untracked > 0);
+		untracked--;
+		return;
+	}
+
+	// leave the stretches the enemy is in
+	const std::vector<Border>& borders = paths[t.path].borders;
+	for (size_t i=0; i < t.next; ++i)
+		inRange[borders[i].tower] -= borders[i].change;
+}
+
+void TowerActivity::Advance(Tracked& t, size_t row)
+{
+	const std::vector<Border>& borders = paths[t.path].borders;
+	const float distance = store.GetDistance(row);
+	for (; t.next < borders.size() && borders[t.next].distance <= distance; ++t.next)
+		inRange[borders[t.next].tower] += borders[t.next].change;
+}
@@ -0,0 +1,76 @@
+#ifndef TOWER_ACTIVITY_H
+#define TOWER_ACTIVITY_H
+
+#include "HandlePool.h"
+
+class Map;
+class EnemyStore;
+class TowerStore;
+class WalkPath;
+
+// Puts the towers to sleep while no enemy is in their range. The map knows which
+// stretches of the spawn paths each tower covers, their borders are sorted along every
+// path. An enemy on a spawn path only passes the borders in front of it, entering a
+// stretch wakes the tower, leaving the last one puts it to sleep again. Enemies that
+// left the spawn paths (towers in maze mode changed the ways) keep all towers awake.
+class TowerActivity
+{
+	struct Border
+	{
+		float distance;
+		size_t tower;
+		int change;  // +1 entering the stretch, -1 leaving it
+	};
+
+	struct SpawnPath
+	{
+		std::shared_ptr<const WalkPath> path;
+		std::vector<Border> borders;
+	};
+
+	struct Tracked
+	{
+		Handle enemy;
+		size_t path;  // NO_PATH if not on a spawn path
+		size_t next;  // the first border not passed yet
+	};
+
+	const Map& map;
+	const EnemyStore& store;
+
+	std::vector<SpawnPath> paths;
+	std::vector<Tracked> enemies;
+	std::vector<int> inRange;  // enemies in the stretches of each tower
+	size_t untracked;
+
+	bool towersChanged;
+	size_t pathVersion;
+
+public:
+	TowerActivity(const Map& map, const EnemyStore& store);
+
+	void Clear();
+
+	// Make room for n enemies at the same time
+	void Reserve(size_t n);
+
+	void AddEnemy(Handle enemy);
+
+	// Towers were added, upgraded or removed, the coverage is collected on the next update
+	void TowersChanged()
+	{
+		towersChanged = true;
+	}
+
+	// Follow the enemies and let the towers sleep or wake, the towers have to be in the
+	// same rows as on the last update unless TowersChanged got called
+	void Update(TowerStore& towers);
+
+private:
+	void Rebuild(const TowerStore& towers);
+	void Track(Tracked& t, size_t row);
+	void Untrack(Tracked& t);
+	void Advance(Tracked& t, size_t row);
+};
+
+#endif //TOWER_ACTIVITY_H
@@ -38,12 +38,18 @@ bool TowerPlacer::HandleEvent(Event& event)
 		Vector2f pos(static_cast<float>(event.MouseMove.X), static_cast<float>(event.MouseMove.Y));
 
 		auto towerPlaces = map->GetTowerPlaces();
+
+		// in maze mode the path block under the mouse is a place as well
+		Vector2f pathBlock = map->SnapToPathBlock(pos);
+		if (pathBlock != pos)
+			towerPlaces.push_back(pathBlock);
+
 		auto nearestPlaceIt = boost::min_element(towerPlaces, boost::bind(CmpByDist, _1, _2, pos));
 		assert(nearestPlaceIt != towerPlaces.end());
 		auto nearestPlace = *nearestPlaceIt;
 		auto distToNearest = dist(nearestPlace, pos);
 
-		if (distToNearest < PLACE_RANGE) {
+		if (distToNearest < PLACE_RANGE && map->CheckTowerPlace(nearestPlace) == Map::FreePlace) {
 			SetPosition(nearestPlace);
 			validPosition = true;
 			SetColor(ColorValidPosition);
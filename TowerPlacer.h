@@ -2,6 +2,7 @@
 #define TOWER_PLACER_H
 
 #include "AnimSprite.h"
+#include "RenderStats.h"
 
 class Map;
 struct TowerSettings;
@@ -48,9 +49,9 @@ public:
 	void DrawRangeCircle(sf::RenderTarget& target, bool highRange)
 	{
 		if (highRange)
-			target.Draw(highRangeCircle);
+			RenderStats::Draw(target, highRangeCircle);
 		else
-			target.Draw(rangeCircle);
+			RenderStats::Draw(target, rangeCircle);
 	}
 
 	const TowerSettings* GetSettings()
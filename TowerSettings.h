@@ -1,6 +1,8 @@
 #ifndef TOWER_SETTINGS_H
 #define TOWER_SETTINGS_H
 
+#include <cstdint>
+
 static const float HIGH_RANGE_FACTOR = 1.5f;
 
 struct TowerSettings
@@ -25,11 +27,25 @@ struct TowerSettings
 		{ }
 	};
 
+	// Which enemy in range a tower attacks
+	enum Targeting {
+		First,      // the one closest to the target along the path
+		Last,
+		Strongest,
+		Closest,    // the one closest to the tower
+	};
+
 	std::string type;
 	std::string name;
 	size_t baseCost;
+	Targeting targeting;
+	uint32_t components;  // ComponentMask of the behavior: launcher, splash or aura
 
 	std::vector<Stage> stage;
+
+	TowerSettings()
+	: baseCost(0), targeting(Closest), components(0)
+	{ }
 };
 
 #endif //TOWER_SETTINGS_H
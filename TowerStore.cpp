@@ -0,0 +1,78 @@
+#include "pch.h"
+#include "TowerStore.h"
+#include "Utility.h"
+#include "AllocTracker.h"
+
+/*static*/ const size_t TowerStore::NO_ROW;
+
+void TowerStore::Clear()
+{
+	towers.clear();
+	handle.clear();
+	handles.Clear();
+}
+
+void TowerStore::Reserve(size_t n)
+{
+	ALLOC_TAG("towers");
+
+	towers.reserve(n);
+	handle.reserve(n);
+	handles.Reserve(n);
+	rows.reserve(n);
+	keep.reserve(n);
+}
+
+Handle TowerStore::Add(const Tower& tower)
+{
+	auto before = [](const Tower& a, const Tower& b) {
+		const Vector2f pa = a.GetPosition(), pb = b.GetPosition();
+		return pa.y < pb.y || (pa.y == pb.y && pa.x < pb.x);
+	};
+	const size_t i = std::upper_bound(towers.begin(), towers.end(), tower, before) - towers.begin();
+	towers.insert(towers.begin() + i, tower);
+
+	const Handle h = handles.Allocate();
+	handle.insert(handle.begin() + i, h);
+	rows.resize(handles.GetNumSlots());
+	UpdateRows(i);
+	return h;
+}
+
+void TowerStore::RemoveSold()
+{
+	ALLOC_TAG("towers");
+
+	keep.resize(GetSize());
+	bool removeAny = false;
+	for (size_t i=0; i < keep.size(); ++i) {
+		keep[i] = !towers[i].IsSold();
+		removeAny |= !keep[i];
+	}
+	if (!removeAny)
+		return;
+
+	for (size_t i=0; i < handle.size(); ++i) {
+		if (!keep[i])
+			handles.Release(handle[i]);
+	}
+
+	Compact(towers, keep);
+	Compact(handle, keep);
+	UpdateRows(0);
+}
+
+size_t TowerStore::FindAt(const Vector2f& pos) const
+{
+	for (size_t i=0; i < towers.size(); ++i) {
+		if (towers[i].GetPosition() == pos)
+			return i;
+	}
+	return NO_ROW;
+}
+
+void TowerStore::UpdateRows(size_t begin)
+{
+	for (size_t i=begin; i < handle.size(); ++i)
+		rows[HandlePool::GetSlot(handle[i])] = static_cast<uint32_t>(i);
+}
@@ -0,0 +1,70 @@
+#ifndef TOWER_STORE_H
+#define TOWER_STORE_H
+
+#include "Tower.h"
+#include "HandlePool.h"
+
+#include <cstdint>
+
+// All towers, ordered by their y position for drawing (by x among equals). Adding and
+// removing moves the towers to other rows, so everyone holding on to a tower keeps a
+// handle and looks up its row like with the enemies. The handle of a removed tower is
+// stale.
+class TowerStore
+{
+	std::vector<Tower> towers;
+	std::vector<Handle> handle;  // by row
+
+	HandlePool handles;
+	std::vector<uint32_t> rows;  // by slot of the handles
+
+	std::vector<uint8_t> keep;  // used while removing
+
+public:
+	static const size_t NO_ROW = static_cast<size_t>(-1);
+
+	// Drop all towers, their handles get stale. The entities are left to the world.
+	void Clear();
+
+	// Make room for n towers at the same time
+	void Reserve(size_t n);
+
+	Handle Add(const Tower& tower);
+
+	// Remove the sold towers, the others keep their order
+	void RemoveSold();
+
+	size_t GetSize() const
+	{
+		return towers.size();
+	}
+
+	// The row of the tower, NO_ROW if it was removed
+	size_t Find(Handle h) const
+	{
+		return handles.IsValid(h) ? rows[HandlePool::GetSlot(h)] : NO_ROW;
+	}
+
+	// The row of the tower standing on pos, NO_ROW if there is none
+	size_t FindAt(const Vector2f& pos) const;
+
+	Handle GetHandle(size_t i) const
+	{
+		return handle[i];
+	}
+
+	Tower& Get(size_t i)
+	{
+		return towers[i];
+	}
+
+	const Tower& Get(size_t i) const
+	{
+		return towers[i];
+	}
+
+private:
+	void UpdateRows(size_t begin);
+};
+
+#endif //TOWER_STORE_H
@@ -1,6 +1,9 @@
 #include "pch.h"
 #include "Utility.h"
 #include "GlobalStatus.h"
+#include "ResourceManager.h"
+
+#include <sstream>
 
 namespace fs = boost::filesystem;
 
@@ -30,6 +33,18 @@ bool DefaultHandleEvent(RenderWindow& win, Event& event)
 		else if (event.Key.Code == Key::P) {
 			MakeScreenshot(win);
 		}
+		// write the memory held by the images to the log
+		else if (event.Key.Code == Key::F11) {
+			if (gStatus.debug.enabled) {
+				std::stringstream report;
+				gImageManager.writeReport(report);
+
+				// line by line, a log message has a limited length
+				std::string line;
+				while (std::getline(report, line))
+					LOG(Msg, line);
+			}
+		}
 
 
 
@@ -3,6 +3,8 @@
 
 #include "Error.h"
 
+#include <cstdint>
+
 bool DefaultHandleEvent(RenderWindow& win, Event& event);
 
 static const float PI = 3.14159265f;
@@ -27,11 +29,32 @@ inline float dist(const Drawable& a, const Drawable& b)
 	return dist(a.GetPosition(), b.GetPosition());
 }
 
+// Squared distance, to compare against a squared range without the sqrt
+inline float distSq(const Vector2f& a, const Vector2f& b)
+{
+	return abs(a - b);
+}
+
 inline float dot(const Vector2f& a, const Vector2f& b)
 {
 	return a.x * b.x + a.y * b.y;
 }
 
+// Remove the entries of v where keep is false, moving the others to the front in order
+template <typename T>
+void Compact(std::vector<T>& v, const std::vector<uint8_t>& keep)
+{
+	size_t n = 0;
+	for (size_t i=0; i < v.size(); ++i) {
+		if (keep[i]) {
+			if (n != i)
+				v[n] = std::move(v[i]);
+			++n;
+		}
+	}
+	v.erase(v.begin() + n, v.end());
+}
+
 inline bool PointInRect(sf::Vector2f pt, sf::Vector2f topLeft, float width, float height)
 {
 	return pt.x >= topLeft.x && pt.x <= topLeft.x + width && pt.y > topLeft.y && pt.y <= topLeft.y + height;
@@ -42,6 +65,13 @@ inline Vector2f GetCenter(const FloatRect& r)
 	return Vector2f(r.Left + r.GetWidth() / 2.f, r.Top + r.GetHeight() / 2.f);
 }
 
+// Compare drawables by their y position, to ensure lower objects (= higher y pos) are drawn
+// later, so the overlap is displayed correctly.
+inline bool CompByY(const std::shared_ptr<sf::Drawable>& a, const std::shared_ptr<sf::Drawable>& b)
+{
+	return a->GetPosition().y < b->GetPosition().y;
+}
+
 template <typename Res>
 void LoadFromFile(Res& res, const std::string& fileName)
 {
@@ -0,0 +1,158 @@
+#include "pch.h"
+#include "WalkPath.h"
+#include "NavGrid.h"
+#include "FlowField.h"
+#include "Utility.h"
+#include "Profiler.h"
+#include "AllocTracker.h"
+
+// a line is not pulled over more blocks than this, it keeps building the path linear
+static const size_t MAX_PULL = 32;
+
+static const float EPSILON = 1e-4f;
+
+static bool IsWalkable(const NavGrid& grid, int x, int y)
+{
+	return grid.Contains(Vector2i(x, y)) && grid.IsWalkable(x, y);
+}
+
+// Do all blocks the line from a to b touches allow walking? The block of a is not checked,
+// the enemy is already there. Lines through a corner touch the blocks on both sides.
+static bool IsClear(const NavGrid& grid, float blockSize, const Vector2f& a, const Vector2f& b)
+{
+	const float x0 = a.x / blockSize, y0 = a.y / blockSize;
+	const float dx = b.x / blockSize - x0, dy = b.y / blockSize - y0;
+
+	int x = static_cast<int>(std::floor(x0));
+	int y = static_cast<int>(std::floor(y0));
+	const int endX = static_cast<int>(std::floor(b.x / blockSize));
+	const int endY = static_cast<int>(std::floor(b.y / blockSize));
+
+	const int stepX = dx > 0 ? 1 : -1;
+	const int stepY = dy > 0 ? 1 : -1;
+
+	// line parameter at the next vertical and horizontal block border
+	const float inf = std::numeric_limits<float>::infinity();
+	const float deltaX = dx != 0 ? std::abs(1 / dx) : inf;
+	const float deltaY = dy != 0 ? std::abs(1 / dy) : inf;
+	float nextX = dx > 0 ? (x + 1 - x0) * deltaX : dx < 0 ? (x0 - x) * deltaX : inf;
+	float nextY = dy > 0 ? (y + 1 - y0) * deltaY : dy < 0 ? (y0 - y) * deltaY : inf;
+
+	while ((x != endX || y != endY) && std::min(nextX, nextY) <= 1 + EPSILON) {
+		if (std::abs(nextX - nextY) < EPSILON) {
+			if (!IsWalkable(grid, x + stepX, y) || !IsWalkable(grid, x, y + stepY))
+				return false;
+			x += stepX;
+			y += stepY;
+			nextX += deltaX;
+			nextY += deltaY;
+		}
+		else if (nextX < nextY) {
+			x += stepX;
+			nextX += deltaX;
+		}
+		else {
+			y += stepY;
+			nextY += deltaY;
+		}
+
+		if (!IsWalkable(grid, x, y))
+			return false;
+	}
+	return true;
+}
+
+WalkPath::WalkPath()
+: start(0, 0), target(-1, -1)
+{ }
+
+void WalkPath::Build(const NavGrid& grid, size_t blockSize, const FlowField& field, const Vector2f& from)
+{
+	PROFILE_ZONE("WalkPath::Build");
+	ALLOC_TAG("pathfinding");
+
+	start = from;
+	target = field.GetTarget();
+	segments.clear();
+
+	// the centers of the blocks the field leads over, the same way the enemies walked before
+	const float size = static_cast<float>(blockSize);
+	auto center = [size](const Vector2i& blk) {
+		return Vector2f((blk.x + 0.5f) * size, (blk.y + 0.5f) * size);
+	};
+
+	Vector2i blk(static_cast<int>(from.x / size), static_cast<int>(from.y / size));
+	if (!field.IsReachable(blk) && field.GetNext(blk) == blk)
+		return; // there is no way, stay at the start
+
+	std::vector<Vector2f> raw;
+	raw.push_back(from);
+	raw.push_back(center(blk));
+	for (Vector2i next = field.GetNext(blk); next != blk; blk = next, next = field.GetNext(blk))
+		raw.push_back(center(next));
+
+	// from every point go straight to the furthest point in sight
+	std::vector<Vector2f> points;
+	points.push_back(raw.front());
+	for (size_t anchor=0; anchor + 1 < raw.size(); ) {
+		size_t furthest = anchor + 1;
+		for (size_t i = anchor + 2; i < raw.size() && i <= anchor + MAX_PULL; ++i) {
+			if (IsClear(grid, size, raw[anchor], raw[i]))
+				furthest = i;
+		}
+
+		// drop the corner if the new segment continues the last one
+		const Vector2f& p = raw[furthest];
+		if (points.size() >= 2) {
+			Vector2f d1 = points.back() - points[points.size() - 2];
+			Vector2f d2 = p - points.back();
+			if (std::abs(d1.x * d2.y - d1.y * d2.x) < EPSILON && d1.x * d2.x + d1.y * d2.y > 0)
+				points.pop_back();
+		}
+		if (p != points.back())
+			points.push_back(p);
+		anchor = furthest;
+	}
+
+	float length = 0;
+	for (size_t i=1; i < points.size(); ++i) {
+		Segment seg;
+		seg.start = points[i-1];
+		Vector2f d = points[i] - points[i-1];
+		float len = norm(d);
+		seg.dir = d / len;
+		seg.begin = length;
+		length += len;
+		seg.end = length;
+		seg.facing = AnimSprite::GetDirection(d);
+		segments.push_back(seg);
+	}
+}
+
+void WalkPath::GetCoverage(const Vector2f& center, float range, std::vector<Interval>& intervals) const
+{
+	const size_t first = intervals.size();
+	for (auto it = segments.begin(); it != segments.end(); ++it) {
+		// solve |start + dir * t - center| = range for the distance t on the segment
+		Vector2f f = it->start - center;
+		float b = f.x * it->dir.x + f.y * it->dir.y;
+		float c = f.x * f.x + f.y * f.y - range * range;
+		float disc = b * b - c;
+		if (disc < 0)
+			continue;
+
+		float root = std::sqrt(disc);
+		float t0 = std::max(-b - root, 0.0f);
+		float t1 = std::min(-b + root, it->end - it->begin);
+		if (t0 > t1)
+			continue;
+
+		Interval iv;
+		iv.begin = it->begin + t0;
+		iv.end = it->begin + t1;
+		if (intervals.size() > first && iv.begin <= intervals.back().end + EPSILON)
+			intervals.back().end = iv.end;
+		else
+			intervals.push_back(iv);
+	}
+}
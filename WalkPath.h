@@ -0,0 +1,85 @@
+#ifndef WALK_PATH_H
+#define WALK_PATH_H
+
+#include "AnimSprite.h"
+
+class NavGrid;
+class FlowField;
+
+// The way of the enemies from a start position to the target of a flow field, as a
+// polyline. The blocks the flow field leads over are string pulled: a corner is cut
+// whenever the straight line stays on walkable blocks. Every segment knows its distance
+// from the start, so a position on the path is a single distance, shared paths cost
+// the enemies nothing but that.
+class WalkPath
+{
+public:
+	// A stretch of the path, as distances from the start
+	struct Interval
+	{
+		float begin, end;
+	};
+
+private:
+	struct Segment
+	{
+		Vector2f start;
+		Vector2f dir;    // unit vector
+		float begin;     // distance of start from the start of the path
+		float end;
+		AnimSprite::Direction facing;
+	};
+
+	Vector2f start;
+	Vector2i target;
+	std::vector<Segment> segments;
+
+public:
+	WalkPath();
+
+	// Follow field from start, the block size converts between grid and positions
+	void Build(const NavGrid& grid, size_t blockSize, const FlowField& field, const Vector2f& start);
+
+	const Vector2f& GetStart() const
+	{
+		return start;
+	}
+
+	const Vector2i& GetTarget() const
+	{
+		return target;
+	}
+
+	float GetLength() const
+	{
+		return segments.empty() ? 0 : segments.back().end;
+	}
+
+	size_t GetNumSegments() const
+	{
+		return segments.size();
+	}
+
+	// Position at the given distance from the start. segment is the segment of an earlier
+	// position that is not further, it gets moved on to the segment of the result.
+	Vector2f GetPosition(float distance, size_t& segment) const
+	{
+		if (segments.empty())
+			return start;
+		while (segment + 1 < segments.size() && distance >= segments[segment].end)
+			++segment;
+
+		const Segment& seg = segments[segment];
+		return seg.start + seg.dir * (std::min(distance, seg.end) - seg.begin);
+	}
+
+	AnimSprite::Direction GetFacing(size_t segment) const
+	{
+		return segments[segment].facing;
+	}
+
+	// Append the stretches of the path within range of center, in order along the path
+	void GetCoverage(const Vector2f& center, float range, std::vector<Interval>& intervals) const;
+};
+
+#endif //WALK_PATH_H
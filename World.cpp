@@ -0,0 +1,160 @@
+#include "pch.h"
+#include "World.h"
+#include "AllocTracker.h"
+
+World::Archetype::Archetype(ComponentMask mask)
+: mask(mask), numDestroyed(0)
+{
+	for (int id=0; id < NUM_COMPONENTS; ++id) {
+		if (mask & Bit(static_cast<ComponentId>(id)))
+			columns[id].reset(CreateColumn(static_cast<ComponentId>(id)));
+	}
+}
+
+/*static*/ World::Archetype::ColumnBase* World::Archetype::CreateColumn(ComponentId id)
+{
+	switch (id) {
+	case TransformId:  return new Column<Transform>();
+	case TargetingId:  return new Column<Targeting>();
+	case CooldownId:   return new Column<Cooldown>();
+	case LauncherId:   return new Column<Launcher>();
+	case ProjectileId: return new Column<Projectile>();
+	case SplashId:     return new Column<Splash>();
+	case AuraId:       return new Column<Aura>();
+	default:
+		assert(false);
+		return nullptr;
+	}
+}
+
+World::World()
+: inSystem(false), reads(0), writes(0)
+{ }
+
+void World::Clear()
+{
+	for (auto it = archetypes.begin(); it != archetypes.end(); ++it) {
+		Archetype& a = **it;
+		for (int id=0; id < NUM_COMPONENTS; ++id) {
+			if (a.columns[id])
+				a.columns[id]->Clear();
+		}
+		a.entities.clear();
+		a.keep.clear();
+		a.numDestroyed = 0;
+	}
+	handles.Clear();
+}
+
+void World::Reserve(ComponentMask mask, size_t n)
+{
+	ALLOC_TAG("entities");
+
+	Archetype& a = GetArchetype(mask);
+	for (int id=0; id < NUM_COMPONENTS; ++id) {
+		if (a.columns[id])
+			a.columns[id]->Reserve(n);
+	}
+	a.entities.reserve(n);
+	a.keep.reserve(n);
+
+	// the slots are shared by all archetypes
+	size_t total = 0;
+	for (auto it = archetypes.begin(); it != archetypes.end(); ++it)
+		total += (*it)->entities.capacity();
+	handles.Reserve(total);
+	locations.reserve(total);
+}
+
+World::Archetype& World::GetArchetype(ComponentMask mask)
+{
+	assert(mask != 0 && mask < Bit(NUM_COMPONENTS));
+
+	auto it = boost::find_if(archetypes, [&](const std::unique_ptr<Archetype>& a) {
+		return a->mask == mask;
+	});
+	if (it != archetypes.end())
+		return **it;
+
+	archetypes.emplace_back(new Archetype(mask));
+	return *archetypes.back();
+}
+
+Entity World::Create(ComponentMask mask)
+{
+	ALLOC_TAG("entities");
+
+	Archetype& a = GetArchetype(mask);
+
+	const Entity e = handles.Allocate();
+	locations.resize(handles.GetNumSlots());
+	Location& loc = locations[HandlePool::GetSlot(e)];
+	loc.archetype = &a;
+	loc.row = a.GetSize();
+
+	a.entities.push_back(e);
+	a.keep.push_back(1);
+	for (int id=0; id < NUM_COMPONENTS; ++id) {
+		if (a.columns[id])
+			a.columns[id]->Push();
+	}
+	return e;
+}
+
+void World::Destroy(Entity e)
+{
+	const Location& loc = GetLocation(e);
+	Archetype& a = *loc.archetype;
+	uint8_t& keep = a.keep[loc.row];
+	if (keep) {
+		keep = 0;
+		a.numDestroyed++;
+	}
+}
+
+void World::Flush()
+{
+	for (auto it = archetypes.begin(); it != archetypes.end(); ++it) {
+		Archetype& a = **it;
+		if (a.numDestroyed == 0)
+			continue;
+
+		for (size_t row=0; row < a.entities.size(); ++row) {
+			if (!a.keep[row])
+				handles.Release(a.entities[row]);
+		}
+
+		for (int id=0; id < NUM_COMPONENTS; ++id) {
+			if (a.columns[id])
+				a.columns[id]->Compact(a.keep);
+		}
+		Compact(a.entities, a.keep);
+
+		for (size_t row=0; row < a.entities.size(); ++row)
+			locations[HandlePool::GetSlot(a.entities[row])].row = row;
+		a.keep.assign(a.entities.size(), 1);
+		a.numDestroyed = 0;
+	}
+}
+
+size_t World::Count(ComponentMask mask) const
+{
+	size_t count = 0;
+	ForEach(mask, [&](const Archetype& a) {
+		count += a.GetSize();
+	});
+	return count;
+}
+
+void World::BeginSystem(ComponentMask r, ComponentMask w)
+{
+	inSystem = true;
+	reads = r;
+	writes = w;
+}
+
+void World::EndSystem()
+{
+	inSystem = false;
+	reads = writes = 0;
+}
@@ -0,0 +1,231 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "Components.h"
+#include "HandlePool.h"
+#include "Utility.h"
+
+#include <cstdint>
+
+// A handle, it gets stale when the entity is destroyed
+typedef Handle Entity;
+
+static const Entity NO_ENTITY = NO_HANDLE;
+
+// The towers and projectiles as entities made of components. All entities with the
+// same set of components share an archetype, which stores every component in its own
+// array, so the systems go through the entities of one combination in a batch.
+// While a system of the SystemScheduler runs, debug builds check that it only touches
+// the components it declared.
+class World
+{
+public:
+	class Archetype
+	{
+		friend class World;
+
+		struct ColumnBase
+		{
+			virtual ~ColumnBase() { }
+			virtual void Push() = 0;
+			virtual void Reserve(size_t n) = 0;
+			virtual void Compact(const std::vector<uint8_t>& keep) = 0;
+			virtual void Clear() = 0;
+		};
+
+		template <typename T>
+		struct Column : ColumnBase
+		{
+			std::vector<T> data;
+
+			void Push() /* override */
+			{
+				data.push_back(T());
+			}
+
+			void Reserve(size_t n) /* override */
+			{
+				data.reserve(n);
+			}
+
+			void Compact(const std::vector<uint8_t>& keep) /* override */
+			{
+				::Compact(data, keep);
+			}
+
+			void Clear() /* override */
+			{
+				data.clear();
+			}
+		};
+
+		ComponentMask mask;
+		std::vector<Entity> entities;
+		std::unique_ptr<ColumnBase> columns[NUM_COMPONENTS];
+
+		std::vector<uint8_t> keep;  // rows not destroyed
+		size_t numDestroyed;
+
+		static ColumnBase* CreateColumn(ComponentId id);
+
+	public:
+		explicit Archetype(ComponentMask mask);
+
+		ComponentMask GetMask() const
+		{
+			return mask;
+		}
+
+		bool Has(ComponentId id) const
+		{
+			return (mask & Bit(id)) != 0;
+		}
+
+		size_t GetSize() const
+		{
+			return entities.size();
+		}
+
+		Entity GetEntity(size_t row) const
+		{
+			return entities[row];
+		}
+
+	private:
+		Archetype(const Archetype&) /*= delete*/;
+		Archetype& operator=(const Archetype&) /*= delete*/;
+	};
+
+private:
+	struct Location
+	{
+		Archetype* archetype;
+		size_t row;
+	};
+
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+	HandlePool handles;
+	std::vector<Location> locations;  // by slot of the handles
+
+	// access of the running system
+	bool inSystem;
+	ComponentMask reads, writes;
+
+public:
+	World();
+
+	// Remove all entities
+	void Clear();
+
+	// Make room for n entities with the components in mask
+	void Reserve(ComponentMask mask, size_t n);
+
+	// New entity with default constructed components
+	Entity Create(ComponentMask mask);
+
+	// The entity stays until the next Flush, so the systems can go on with their arrays
+	void Destroy(Entity e);
+
+	// Remove the destroyed entities, the others keep their order
+	void Flush();
+
+	bool IsAlive(Entity e) const
+	{
+		return handles.IsValid(e);
+	}
+
+	ComponentMask GetMask(Entity e) const
+	{
+		return GetLocation(e).archetype->mask;
+	}
+
+	// Number of entities having all components in mask
+	size_t Count(ComponentMask mask) const;
+
+	// Call f with every archetype having all components in mask. Entities may be created
+	// in the meantime, but not in an archetype f goes through.
+	template <typename F>
+	void ForEach(ComponentMask mask, F f)
+	{
+		for (size_t i=0; i < archetypes.size(); ++i) {
+			Archetype& a = *archetypes[i];
+			if ((a.mask & mask) == mask && a.GetSize() > 0)
+				f(a);
+		}
+	}
+
+	template <typename F>
+	void ForEach(ComponentMask mask, F f) const
+	{
+		for (size_t i=0; i < archetypes.size(); ++i) {
+			const Archetype& a = *archetypes[i];
+			if ((a.mask & mask) == mask && a.GetSize() > 0)
+				f(a);
+		}
+	}
+
+	// The component array of an archetype, indexed by row
+	template <typename T>
+	const std::vector<T>& Read(const Archetype& a) const
+	{
+		CheckRead(ComponentType<T>::id);
+		return GetColumn<T>(a).data;
+	}
+
+	template <typename T>
+	std::vector<T>& Write(Archetype& a)
+	{
+		CheckWrite(ComponentType<T>::id);
+		return const_cast<Archetype::Column<T>&>(GetColumn<T>(a)).data;
+	}
+
+	// The component of a single entity
+	template <typename T>
+	const T& Read(Entity e) const
+	{
+		const Location& loc = GetLocation(e);
+		return Read<T>(*loc.archetype)[loc.row];
+	}
+
+	template <typename T>
+	T& Write(Entity e)
+	{
+		const Location& loc = GetLocation(e);
+		return Write<T>(*loc.archetype)[loc.row];
+	}
+
+	// Only called by the SystemScheduler
+	void BeginSystem(ComponentMask reads, ComponentMask writes);
+	void EndSystem();
+
+private:
+	const Location& GetLocation(Entity e) const
+	{
+		assert(IsAlive(e));
+		return locations[HandlePool::GetSlot(e)];
+	}
+
+	Archetype& GetArchetype(ComponentMask mask);
+
+	template <typename T>
+	const Archetype::Column<T>& GetColumn(const Archetype& a) const
+	{
+		assert(a.Has(ComponentType<T>::id));
+		return static_cast<const Archetype::Column<T>&>(*a.columns[ComponentType<T>::id]);
+	}
+
+	void CheckRead(ComponentId id) const
+	{
+		assert(!inSystem || ((reads | writes) & Bit(id)));
+	}
+
+	void CheckWrite(ComponentId id) const
+	{
+		assert(!inSystem || (writes & Bit(id)));
+	}
+
+	World(const World&) /*= delete*/;
+	World& operator=(const World&) /*= delete*/;
+};
+
+#endif //WORLD_H
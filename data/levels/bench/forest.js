@@ -0,0 +1,14 @@
+{
+	"name" : "Benchmark",
+	"theme" : "default",
+	"map" : "forest",
+
+	"waves" : [
+		{
+			"countdown" : 1000000,
+			"enemies" : [
+				[]
+			]
+		}
+	]
+}
@@ -0,0 +1,64 @@
+{
+	"name" : "Late Waves (Forest)",
+	"theme" : "default",
+	"map" : "forest",
+
+	"waves" : [
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 12], [1, 12]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 25], [1, 25]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 50], [1, 50]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 75], [1, 75]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 100], [1, 100]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 150], [1, 150]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 200], [1, 200]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 250], [1, 250]]
+			]
+		}
+	]
+}
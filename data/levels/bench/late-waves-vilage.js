@@ -0,0 +1,72 @@
+{
+	"name" : "Late Waves (Vilage)",
+	"theme" : "default",
+	"map" : "vilage",
+
+	"waves" : [
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 6], [1, 6]],
+				[[0, 6], [1, 6]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 12], [1, 12]],
+				[[0, 12], [1, 12]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 25], [1, 25]],
+				[[0, 25], [1, 25]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 37], [1, 37]],
+				[[0, 37], [1, 37]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 50], [1, 50]],
+				[[0, 50], [1, 50]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 75], [1, 75]],
+				[[0, 75], [1, 75]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 100], [1, 100]],
+				[[0, 100], [1, 100]]
+			]
+		},
+		{
+			"countdown" : 5,
+			"max-time": 10,
+			"enemies" : [
+				[[0, 125], [1, 125]],
+				[[0, 125], [1, 125]]
+			]
+		}
+	]
+}
@@ -0,0 +1,29 @@
+{
+	"name" : "Maze (Forest)",
+	"theme" : "default",
+	"map" : "forest",
+	"maze" : true,
+
+	"waves" : [
+		{
+			"countdown" : 30,
+			"max-time": 20,
+			"enemies" : [
+				[[0, 20], [1, 20]]
+			]
+		},
+		{
+			"countdown" : 10,
+			"max-time": 20,
+			"enemies" : [
+				[[0, 40], [1, 40]]
+			]
+		},
+		{
+			"countdown" : 10,
+			"enemies" : [
+				[[0, 80], [1, 80]]
+			]
+		}
+	]
+}
@@ -4,6 +4,8 @@
 			"name" : "Archer Tower",
 			"type" : "archer",
 			"base-cost": 100,
+			"targeting": "first",
+			"components": ["launcher"],
 			"stages" : [
 				{
 					"base": "tower/Archer_level1.png",
@@ -47,6 +49,8 @@
 			"name" : "Canon Tower",
 			"type" : "canon",
 			"base-cost": 100,
+			"targeting": "closest",
+			"components": ["launcher", "splash"],
 			"stages" : [
 				{
 					"base": "tower/Gun_level1.png",
@@ -84,6 +88,7 @@
 			"name" : "Tea Tower",
 			"type" : "tea",
 			"base-cost": 100,
+			"components": ["aura"],
 			"stages" : [
 				{
 					"base": "tower/Tea_level1.png",
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "DataPaths.h"
 #include "Game.h"
+#include "Headless.h"
 #include "MainMenu.h"
 #include "Win.h"
 #include "Loose.h"
@@ -10,6 +11,7 @@
 #include "ResourceManager.h"
 #include "Theme.h"
 #include "Log.h"
+#include "Profiler.h"
 
 #ifdef WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -35,6 +37,41 @@ int main(int argc, char **argv)
 
 	LOG(Msg, "Drachen startup");
 
+	std::vector<std::string> args(argv, argv + argc);
+
+	// Drachen --trace <file> ...: write all profiler zones to a Chrome trace file
+	auto traceArg = std::find(args.begin(), args.end(), "--trace");
+	if (traceArg != args.end() && traceArg + 1 != args.end()) {
+		std::string traceFile = *(traceArg + 1);
+		args.erase(traceArg, traceArg + 2);
+
+		try {
+			Profiler::Instance().StartTrace(traceFile);
+		}
+		catch (boost::exception& ex) {
+			LOG(Crit, "GameError while starting the trace, saving info to crash.log");
+			HandleException(ex);
+			return 1;
+		}
+	}
+
+	// Drachen --headless <level> [seconds]: simulate a level without a window
+	// Drachen --replay <file> [hash-file]: play back a replay as fast as possible
+	if (args.size() >= 3 && (args[1] == "--headless" || args[1] == "--replay")) {
+		try {
+			if (args[1] == "--headless") {
+				float seconds = args.size() >= 4 ? boost::lexical_cast<float>(args[3]) : 3600.f;
+				return RunHeadless(args[2], seconds);
+			}
+			return RunReplay(args[2], args.size() >= 4 ? args[3] : "");
+		}
+		catch (boost::exception& ex) {
+			LOG(Crit, "GameError in headless run, saving info to crash.log");
+			HandleException(ex);
+			return 1;
+		}
+	}
+
 	std::ofstream fcerr("cerr.log");
 	std::cerr.rdbuf(fcerr.rdbuf());
 
@@ -160,6 +197,7 @@ int main(int argc, char **argv)
 	}
 	catch (std::runtime_error err) {
 		LOG(Crit, "runtime_error: " << err.what());
+		Log::Logger::Instance().Flush();
 		std::ofstream out("crash.log");
 		out << err.what() << "\n";
 	}
@@ -199,6 +237,10 @@ void HandleException(boost::exception& ex)
 		}
 	}
 
+	// keep the trace and the log up to the crash
+	Profiler::Instance().StopTrace();
+	Log::Logger::Instance().Flush();
+
 	msg << "\nFull diagnostic information:\n";
 	msg << diagnostic_information(ex);
 